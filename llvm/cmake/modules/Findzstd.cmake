@@ -0,0 +1,47 @@
+# Attempts to discover the zstd compression library.
+#
+# Example usage:
+#
+# find_package(zstd)
+#
+# If successful, the following variables will be defined:
+# zstd_FOUND
+# zstd_INCLUDE_DIRS
+# zstd_LIBRARIES
+#
+# Additionally, the following import target will be defined:
+# zstd::zstd
+
+find_path(zstd_INCLUDE_DIRS NAMES zstd.h)
+find_library(zstd_LIBRARIES NAMES zstd libzstd zstd_static)
+
+if(zstd_INCLUDE_DIRS AND zstd_LIBRARIES)
+  include(CMakePushCheckState)
+  include(CheckSymbolExists)
+  cmake_push_check_state()
+  list(APPEND CMAKE_REQUIRED_INCLUDES ${zstd_INCLUDE_DIRS})
+  list(APPEND CMAKE_REQUIRED_LIBRARIES ${zstd_LIBRARIES})
+  check_symbol_exists(ZSTD_compress zstd.h zstd_LINKABLE)
+  cmake_pop_check_state()
+endif()
+
+include(FindPackageHandleStandardArgs)
+find_package_handle_standard_args(zstd
+                                  FOUND_VAR
+                                    zstd_FOUND
+                                  REQUIRED_VARS
+                                    zstd_INCLUDE_DIRS
+                                    zstd_LIBRARIES
+                                    zstd_LINKABLE)
+mark_as_advanced(zstd_INCLUDE_DIRS
+                 zstd_LIBRARIES
+                 zstd_LINKABLE)
+
+if(zstd_FOUND)
+  if(NOT TARGET zstd::zstd)
+    add_library(zstd::zstd UNKNOWN IMPORTED)
+    set_target_properties(zstd::zstd PROPERTIES
+                          IMPORTED_LOCATION "${zstd_LIBRARIES}"
+                          INTERFACE_INCLUDE_DIRECTORIES "${zstd_INCLUDE_DIRS}")
+  endif()
+endif()
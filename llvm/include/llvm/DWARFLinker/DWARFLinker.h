@@ -20,6 +20,7 @@
 #include <map>
 
 namespace llvm {
+class ThreadPool;
 
 enum class DwarfLinkerClient { Dsymutil, LLD, General };
 
@@ -83,6 +84,8 @@ public:
 
   /// Apply the valid relocations to the buffer \p Data, taking into
   /// account that Data is at \p BaseOffset in the .debug_info section.
+  /// This and relocateIndexedAddr() may be called concurrently, for the
+  /// units of an object file that are cloned in parallel.
   ///
   /// \returns true whether any reloc has been applied.
   virtual bool applyValidRelocs(MutableArrayRef<char> Data, uint64_t BaseOffset,
@@ -294,6 +297,11 @@ public:
   /// Use specified number of threads for parallel files linking.
   void setNumThreads(unsigned NumThreads) { Options.Threads = NumThreads; }
 
+  /// Limit the input debug info, in bytes of .debug_info, that is parsed and
+  /// analyzed ahead of being cloned when linking with multiple threads. 0
+  /// means no limit.
+  void setMemoryBudget(uint64_t Bytes) { Options.MemoryBudget = Bytes; }
+
   /// Set kind of accelerator tables to be generated.
   void setAccelTableKind(AccelTableKind Kind) {
     Options.TheAccelTableKind = Kind;
@@ -412,6 +420,12 @@ private:
       Options.ErrorHandler(Warning, File.FileName, DIE);
   }
 
+  /// Add the parseable Swift interface \p Name, referenced by \p DIE of
+  /// \p File, to the Swift interfaces map. A warning is reported if it
+  /// conflicts with the interface already recorded for \p Name.
+  void addSwiftInterface(const DWARFFile &File, StringRef Name, StringRef Path,
+                         StringRef ResolvedPath, const DWARFDie &DIE);
+
   /// Remembers the oldest and newest DWARF version we've seen in a unit.
   void updateDwarfVersion(unsigned Version) {
     MaxDwarfVersion = std::max(MaxDwarfVersion, Version);
@@ -580,10 +594,14 @@ private:
     /// Construct the output DIE tree by cloning the DIEs we
     /// chose to keep above. If there are no valid relocs, then there's
     /// nothing to clone/emit.
+    ///
+    /// \param Pool if not null, the units are cloned concurrently on it.
+    /// The result is the same as when cloning them serially.
     uint64_t cloneAllCompileUnits(DWARFContext &DwarfContext,
                                   const DWARFFile &File,
                                   OffsetsStringPool &StringPool,
-                                  bool IsLittleEndian);
+                                  bool IsLittleEndian,
+                                  ThreadPool *Pool = nullptr);
 
   private:
     using AttributeSpec = DWARFAbbreviationDeclaration::AttributeSpec;
@@ -625,6 +643,113 @@ private:
       AttributesInfo() = default;
     };
 
+    /// A part of a cloned DIE that depends on the units cloned before it,
+    /// and so is only set by finishDIE(), in cloning order, when the units
+    /// of an object file are cloned concurrently.
+    struct PendingValue {
+      enum ValueKind : uint8_t { String, Reference, BaseTypeRef, Warning };
+      ValueKind Kind;
+
+      /// The placeholder for the attribute, or for a BaseTypeRef the first
+      /// byte of the operand in its block.
+      DIE::value_iterator Slot;
+
+      dwarf::Attribute Attr = dwarf::Attribute(0);
+      dwarf::Form Form = dwarf::Form(0);
+
+      /// The size of the attribute in the input for a Reference, or of the
+      /// operand for a BaseTypeRef.
+      unsigned Size = 0;
+
+      /// The offset of the operand in its expression for a BaseTypeRef.
+      unsigned ExprOffset = 0;
+
+      /// The value of a String.
+      const char *Str = nullptr;
+
+      /// The DIE referenced, or the DIE a Warning is about.
+      DWARFDie RefDie;
+      CompileUnit *RefUnit = nullptr;
+
+      const DWARFFile *File = nullptr;
+      std::string Message;
+
+      explicit PendingValue(ValueKind Kind) : Kind(Kind) {}
+    };
+
+    /// A DIE cloned concurrently, before it is placed by finishDIE().
+    struct PendingDIE {
+      DWARFDie InputDIE;
+      DIE *Die;
+      AttributesInfo AttrInfo;
+
+      /// The size of the attributes, without the pending ones.
+      uint32_t AttrSize;
+      bool HasChildren;
+
+      /// The PendingValues of the DIE.
+      size_t ValuesBegin, ValuesEnd;
+    };
+
+    /// The DIEs of a unit cloned concurrently, in the order they were
+    /// cloned.
+    struct PendingUnit {
+      std::vector<PendingDIE> DIEs;
+      std::vector<PendingValue> Values;
+
+      /// The allocator for the DIEs of the unit, and the DIELoc and
+      /// DIEBlock objects in it that need to be destructed.
+      BumpPtrAllocator DIEAlloc;
+      std::vector<DIELoc *> DIELocs;
+      std::vector<DIEBlock *> DIEBlocks;
+    };
+
+    /// The unit being cloned concurrently by this cloner, or null.
+    PendingUnit *Pending = nullptr;
+
+    /// Place the DIEs of \p P, cloned from \p Unit, and set their pending
+    /// values.
+    void finishUnit(PendingUnit &P, const DWARFFile &File, CompileUnit &Unit,
+                    OffsetsStringPool &StringPool, uint32_t OutOffset);
+
+    /// Place the DIE recorded at \p Idx in \p P, and its children, at
+    /// \p OutOffset and advance \p Idx past them.
+    /// \returns the offset following the DIE.
+    uint32_t finishDIE(PendingUnit &P, size_t &Idx, const DWARFFile &File,
+                       CompileUnit &Unit, OffsetsStringPool &StringPool,
+                       uint32_t OutOffset);
+
+    /// Set \p V of \p D.
+    /// \returns the size \p V adds to the DIE.
+    unsigned finishValue(PendingValue &V, PendingDIE &D, CompileUnit &Unit,
+                         OffsetsStringPool &StringPool);
+
+    /// Set \p Value at \p Slot of \p Die, or add it if \p Slot is null.
+    DIE::value_iterator setValue(DIE &Die, DIE::value_iterator Slot,
+                                 const DIEValue &Value);
+
+    /// Report \p Warning, after the values pending before it when cloning
+    /// concurrently.
+    void reportWarning(const Twine &Warning, const DWARFFile &File,
+                       const DWARFDie *DIE = nullptr);
+
+    /// Set the offset of \p Die, the clone of the DIE described by \p Info,
+    /// to \p OutOffset, and make it the canonical DIE of its DeclContext if
+    /// it is the first one cloned.
+    void placeDIE(DIE &Die, CompileUnit &Unit, CompileUnit::DIEInfo &Info,
+                  uint32_t OutOffset);
+
+    /// Add the accelerator table entries of \p Die, the clone of \p InputDIE.
+    void addAccelerators(const DWARFDie &InputDIE, const DIE *Die,
+                         const DWARFFile &File, CompileUnit &Unit,
+                         OffsetsStringPool &StringPool,
+                         const CompileUnit::DIEInfo &Info,
+                         AttributesInfo &AttrInfo);
+
+    /// Assign the abbreviation number of \p Die.
+    /// \returns the size of the abbreviation number.
+    unsigned assignAbbrevNumber(DIE &Die, bool HasChildren);
+
     /// Helper for cloneDIE.
     unsigned cloneAttribute(DIE &Die, const DWARFDie &InputDIE,
                             const DWARFFile &File, CompileUnit &U,
@@ -641,6 +766,13 @@ private:
                                   OffsetsStringPool &StringPool,
                                   AttributesInfo &Info);
 
+    /// Set the string attribute \p Attr of \p Die to \p String.
+    /// \returns the size of the attribute.
+    unsigned setStringAttribute(DIE &Die, DIE::value_iterator Slot,
+                                dwarf::Attribute Attr, const char *String,
+                                OffsetsStringPool &StringPool,
+                                AttributesInfo &Info);
+
     /// Clone an attribute referencing another DIE and add
     /// it to \p Die.
     /// \returns the size of the new attribute.
@@ -651,11 +783,26 @@ private:
                                         const DWARFFile &File,
                                         CompileUnit &Unit);
 
+    /// Set the attribute \p Attr of \p Die, the clone of \p InputDIE, to
+    /// reference \p RefDie in \p RefUnit.
+    /// \returns the size of the attribute.
+    unsigned cloneResolvedReference(DIE &Die, DIE::value_iterator Slot,
+                                    const DWARFDie &InputDIE,
+                                    dwarf::Attribute Attr, dwarf::Form Form,
+                                    unsigned AttrSize, const DWARFDie &RefDie,
+                                    CompileUnit &RefUnit, CompileUnit &Unit);
+
     /// Clone a DWARF expression that may be referencing another DIE.
     void cloneExpression(DataExtractor &Data, DWARFExpression Expression,
                          const DWARFFile &File, CompileUnit &Unit,
                          SmallVectorImpl<uint8_t> &OutputBuffer);
 
+    /// Encode the offset of the clone of the base type \p RefDie into the
+    /// \p ULEBSize bytes at \p ULEB.
+    void encodeBaseTypeRef(const DWARFDie &RefDie, unsigned ULEBSize,
+                           const DWARFFile &File, CompileUnit &Unit,
+                           uint8_t *ULEB);
+
     /// Clone an attribute referencing another DIE and add
     /// it to \p Die.
     /// \returns the size of the new attribute.
@@ -805,6 +952,10 @@ private:
     /// Number of threads.
     unsigned Threads = 1;
 
+    /// Size of the input debug info analyzed ahead of cloning, or 0 for no
+    /// limit.
+    uint64_t MemoryBudget = 0;
+
     /// The accelerator table kind
     AccelTableKind TheAccelTableKind = AccelTableKind::Default;
 
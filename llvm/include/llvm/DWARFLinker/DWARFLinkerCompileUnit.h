@@ -75,6 +75,11 @@ public:
 
     /// Does DIE transitively refer an incomplete decl?
     bool Incomplete : 1;
+
+    /// Has the DIE been cloned, or been referenced by a DIE cloned before
+    /// it? When the units of an object file are cloned concurrently, Clone
+    /// is set before the DIE is placed in cloning order and this is set.
+    bool Cloned : 1;
   };
 
   CompileUnit(DWARFUnit &OrigUnit, unsigned ID, bool CanUseODR,
@@ -169,6 +174,12 @@ public:
   /// Apply all fixups recorded by noteForwardReference().
   void fixupForwardReferences();
 
+  /// Record that the DIE at index \p Idx lives in the DeclContext \p Ctxt.
+  /// \returns the index of the first DIE of this unit recorded for \p Ctxt.
+  uint32_t noteDeclContext(const DeclContext *Ctxt, uint32_t Idx) {
+    return DeclContextDIEs.insert(std::make_pair(Ctxt, Idx)).first->second;
+  }
+
   /// Add the low_pc of a label that is relocated by applying
   /// offset \p PCOffset.
   void addLabelLowPc(uint64_t LabelLowPc, int64_t PcOffset);
@@ -261,6 +272,10 @@ private:
       std::tuple<DIE *, const CompileUnit *, DeclContext *, PatchLocation>>
       ForwardDIEReferences;
 
+  /// The first DIE seen in each DeclContext, used to detect contexts that are
+  /// ambiguous within this unit.
+  DenseMap<const DeclContext *, uint32_t> DeclContextDIEs;
+
   FunctionIntervals::Allocator RangeAlloc;
 
   /// The ranges in that interval map are the PC ranges for
@@ -19,6 +19,8 @@
 #include "llvm/DebugInfo/DWARF/DWARFDie.h"
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/Path.h"
+#include <atomic>
+#include <mutex>
 
 namespace llvm {
 
@@ -30,29 +32,45 @@ struct DeclMapInfo;
 /// resolve different files under the same path.
 class CachedPathResolver {
 public:
-  /// Resolve a path by calling realpath and cache its result. The returned
-  /// StringRef is interned in the given \p StringPool.
-  StringRef resolve(const std::string &Path,
-                    NonRelocatableStringpool &StringPool) {
+  /// Resolve a path by calling realpath on its parent directory and cache
+  /// the result. May be called concurrently; realpath is called without
+  /// holding the lock, so a directory may be resolved twice, with the same
+  /// result.
+  std::string resolve(const std::string &Path) {
     StringRef FileName = sys::path::filename(Path);
     StringRef ParentPath = sys::path::parent_path(Path);
 
+    SmallString<256> ResolvedPath;
+    bool Found = false;
+    {
+      std::lock_guard<std::mutex> Lock(Mutex);
+      auto It = ResolvedPaths.find(ParentPath);
+      if (It != ResolvedPaths.end()) {
+        ResolvedPath = It->second;
+        Found = true;
+      }
+    }
+
     // If the ParentPath has not yet been resolved, resolve and cache it for
     // future look-ups.
-    if (!ResolvedPaths.count(ParentPath)) {
+    if (!Found) {
       SmallString<256> RealPath;
       sys::fs::real_path(ParentPath, RealPath);
-      ResolvedPaths.insert(
-          {ParentPath, std::string(RealPath.c_str(), RealPath.size())});
+      std::lock_guard<std::mutex> Lock(Mutex);
+      ResolvedPath =
+          ResolvedPaths
+              .try_emplace(ParentPath,
+                           std::string(RealPath.c_str(), RealPath.size()))
+              .first->second;
     }
 
     // Join the file name again with the resolved path.
-    SmallString<256> ResolvedPath(ResolvedPaths[ParentPath]);
     sys::path::append(ResolvedPath, FileName);
-    return StringPool.internString(ResolvedPath);
+    return std::string(ResolvedPath);
   }
 
 private:
+  std::mutex Mutex;
   StringMap<std::string> ResolvedPaths;
 };
 
@@ -78,14 +96,12 @@ class DeclContext {
 public:
   using Map = DenseSet<DeclContext *, DeclMapInfo>;
 
-  DeclContext() : DefinedInClangModule(0), Parent(*this) {}
+  DeclContext() : Parent(*this) {}
 
   DeclContext(unsigned Hash, uint32_t Line, uint32_t ByteSize, uint16_t Tag,
-              StringRef Name, StringRef File, const DeclContext &Parent,
-              DWARFDie LastSeenDIE = DWARFDie(), unsigned CUId = 0)
+              StringRef Name, StringRef File, const DeclContext &Parent)
       : QualifiedNameHash(Hash), Line(Line), ByteSize(ByteSize), Tag(Tag),
-        DefinedInClangModule(0), Name(Name), File(File), Parent(Parent),
-        LastSeenDIE(LastSeenDIE), LastSeenCompileUnitID(CUId) {}
+        Name(Name), File(File), Parent(Parent) {}
 
   uint32_t getQualifiedNameHash() const { return QualifiedNameHash; }
 
@@ -94,8 +110,17 @@ public:
   uint32_t getCanonicalDIEOffset() const { return CanonicalDIEOffset; }
   void setCanonicalDIEOffset(uint32_t Offset) { CanonicalDIEOffset = Offset; }
 
-  bool isDefinedInClangModule() const { return DefinedInClangModule; }
-  void setDefinedInClangModule(bool Val) { DefinedInClangModule = Val; }
+  bool isDefinedInClangModule() const {
+    return DefinedInClangModule.load(std::memory_order_relaxed) & 1;
+  }
+
+  /// Record whether this context is defined in a clang module, as seen from
+  /// \p U. The value set from the unit with the lowest ID wins. A unit is
+  /// cloned after all units with lower IDs have been analyzed, but possibly
+  /// before or after units with higher IDs are, depending on the number of
+  /// threads. With this rule the value seen while cloning doesn't depend on
+  /// that.
+  void setDefinedInClangModule(bool Val, const CompileUnit &U);
 
   uint16_t getTag() const { return Tag; }
 
@@ -106,18 +131,22 @@ private:
   uint32_t Line = 0;
   uint32_t ByteSize = 0;
   uint16_t Tag = dwarf::DW_TAG_compile_unit;
-  unsigned DefinedInClangModule : 1;
+  /// One plus the ID of the unit that set the flag, shifted left by one, with
+  /// the flag in the low bit, or 0 if the flag is not set yet.
+  std::atomic<uint64_t> DefinedInClangModule{0};
   StringRef Name;
   StringRef File;
   const DeclContext &Parent;
-  DWARFDie LastSeenDIE;
-  uint32_t LastSeenCompileUnitID = 0;
   uint32_t CanonicalDIEOffset = 0;
 };
 
 /// This class gives a tree-like API to the DenseMap that stores the
 /// DeclContext objects. It holds the BumpPtrAllocator where these objects will
 /// be allocated.
+///
+/// getChildDeclContext may be called concurrently for DIEs of different
+/// object files. The contexts it returns do not depend on the order of the
+/// calls.
 class DeclContextTree {
 public:
   /// Get the child of \a Context described by \a DIE in \a Unit. The
@@ -139,6 +168,10 @@ public:
   DeclContext &getRoot() { return Root; }
 
 private:
+  /// Guards the allocator, the context map, the string pool and the cache of
+  /// resolved paths, but is not held while resolving paths.
+  std::mutex Mutex;
+
   BumpPtrAllocator Allocator;
   DeclContext Root;
   DeclContext::Map Contexts;
@@ -154,6 +187,8 @@ private:
   /// String pool keeping real path bodies.
   NonRelocatableStringpool StringPool;
 
+  /// Returns the real path of file \p FileNum of \p LineTable, interned in
+  /// StringPool. Called without holding Mutex.
   StringRef getResolvedPath(CompileUnit &CU, unsigned FileNum,
                             const DWARFDebugLine::LineTable &LineTable);
 };
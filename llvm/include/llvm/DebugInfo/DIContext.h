@@ -14,6 +14,7 @@
 #ifndef LLVM_DEBUGINFO_DICONTEXT_H
 #define LLVM_DEBUGINFO_DICONTEXT_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/Object/ObjectFile.h"
 #include "llvm/Support/WithColor.h"
@@ -244,6 +245,28 @@ public:
       object::SectionedAddress Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) = 0;
 
+  /// Batch versions of getLineInfoForAddress() and
+  /// getInliningInfoForAddress(). Results are returned in the order of
+  /// \p Addresses; implementations may resolve them in any order.
+  virtual std::vector<DILineInfo> getLineInfoForAddresses(
+      ArrayRef<object::SectionedAddress> Addresses,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) {
+    std::vector<DILineInfo> Result;
+    Result.reserve(Addresses.size());
+    for (object::SectionedAddress Address : Addresses)
+      Result.push_back(getLineInfoForAddress(Address, Specifier));
+    return Result;
+  }
+  virtual std::vector<DIInliningInfo> getInliningInfoForAddresses(
+      ArrayRef<object::SectionedAddress> Addresses,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) {
+    std::vector<DIInliningInfo> Result;
+    Result.reserve(Addresses.size());
+    for (object::SectionedAddress Address : Addresses)
+      Result.push_back(getInliningInfoForAddress(Address, Specifier));
+    return Result;
+  }
+
   virtual std::vector<DILocal>
   getLocalsForAddress(object::SectionedAddress Address) = 0;
 
@@ -173,6 +173,21 @@ public:
   // DWARF parsing to be faster as many DWARF DIEs have a fixed byte size.
   Optional<size_t> getFixedAttributesByteSize(const DWARFUnit &U) const;
 
+  /// Skip the attribute data of a DIE that uses this abbreviation.
+  ///
+  /// Runs of attributes with a fixed byte size are skipped with a single
+  /// addition, so only variable size forms need to be looked at.
+  ///
+  /// \param Data the .debug_info data of \p U.
+  /// \param OffsetPtr points to the offset right after the abbreviation code
+  /// of the DIE. On success it is updated to point past the attribute data.
+  /// On failure it points to the attribute that could not be skipped.
+  /// \param U the DWARFUnit that contains the DIE.
+  /// \param InvalidForm set to the form that could not be skipped on failure.
+  /// \returns true if all attribute data was skipped.
+  bool skipAttributeValues(const DataExtractor &Data, uint64_t *OffsetPtr,
+                           const DWARFUnit &U, dwarf::Form &InvalidForm) const;
+
 private:
   void clear();
 
@@ -197,8 +212,33 @@ private:
     /// The returned size does not include bytes for the  ULEB128 abbreviation
     /// code
     size_t getByteSize(const DWARFUnit &U) const;
+    size_t getByteSize(const dwarf::FormParams &Params) const;
+  };
+
+  /// How the value of a variable size form is skipped.
+  enum class SkipKind : uint8_t {
+    ULEB128,
+    SLEB128,
+    CString,
+    Block1,
+    Block2,
+    Block4,
+    BlockULEB128,
+    /// Anything else, including DW_FORM_indirect and unknown forms, is
+    /// handed to DWARFFormValue::skipValue().
+    Generic,
   };
 
+  /// One step of the skip plan: the fixed size attributes that precede a
+  /// variable size attribute, followed by that attribute.
+  struct SkipStep {
+    FixedSizeInfo Fixed;
+    SkipKind Kind;
+    dwarf::Form Form;
+  };
+
+  static SkipKind getSkipKind(dwarf::Form F);
+
   uint32_t Code;
   dwarf::Tag Tag;
   uint8_t CodeByteSize;
@@ -207,6 +247,11 @@ private:
   /// If this abbreviation has a fixed byte size then FixedAttributeSize member
   /// variable below will have a value.
   Optional<FixedSizeInfo> FixedAttributeSize;
+  /// The steps to skip the attribute data of a DIE, computed when the
+  /// declaration is extracted. Empty if FixedAttributeSize has a value.
+  SmallVector<SkipStep, 2> SkipPlan;
+  /// The fixed size attributes after the last variable size one.
+  FixedSizeInfo TrailingFixedSize;
 };
 
 } // end namespace llvm
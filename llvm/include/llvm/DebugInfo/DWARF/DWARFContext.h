@@ -22,8 +22,11 @@
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/Host.h"
+#include "llvm/Support/Threading.h"
 #include <cstdint>
+#include <list>
 #include <memory>
+#include <mutex>
 
 namespace llvm {
 
@@ -63,6 +66,10 @@ class DWARFContext : public DIContext {
   std::unique_ptr<AppleAcceleratorTable> AppleTypes;
   std::unique_ptr<AppleAcceleratorTable> AppleNamespaces;
   std::unique_ptr<AppleAcceleratorTable> AppleObjC;
+  /// Name index used by getOrBuildDebugNames() for objects without a
+  /// .debug_names section, and the buffer holding it.
+  std::unique_ptr<MemoryBuffer> BuiltNamesIndex;
+  std::unique_ptr<DWARFDebugNames> BuiltNames;
 
   DWARFUnitVector DWOUnits;
   Optional<DenseMap<uint64_t, DWARFTypeUnit*>> DWOTypeUnits;
@@ -88,6 +95,52 @@ class DWARFContext : public DIContext {
       WithColor::defaultErrorHandler;
   std::function<void(Error)> WarningHandler = WithColor::defaultWarningHandler;
 
+  /// True if this context may be queried from several threads at once.
+  bool ThreadSafe = false;
+
+  /// Guard the lazily-built tables that units and lookups depend on. Each
+  /// table is built exactly once, so readers never race with its
+  /// construction.
+  llvm::once_flag NormalUnitsOnce;
+  llvm::once_flag DWOUnitsOnce;
+  llvm::once_flag AbbrevOnce;
+  llvm::once_flag AbbrevDWOOnce;
+  llvm::once_flag ArangesOnce;
+  llvm::once_flag LocOnce;
+  llvm::once_flag MacroOnce;
+  llvm::once_flag MacroDWOOnce;
+  llvm::once_flag MacinfoOnce;
+  llvm::once_flag MacinfoDWOOnce;
+  llvm::once_flag BuiltNamesOnce;
+
+  /// Serializes access to the remaining lazily-built state (indexes, frames,
+  /// accelerator tables, the line table cache and DWO contexts) when
+  /// ThreadSafe is set. It is only held around code that does not extract
+  /// unit DIEs, so it never nests inside a per-unit once flag.
+  std::recursive_mutex Mutex;
+
+  /// Memory budget for extracted DIEs and line tables, see
+  /// setDIEMemoryBudget().
+  uint64_t DIEMemoryBudget = 0;
+  /// Units whose DIEs or line table were used while a budget is set, least
+  /// recently used first.
+  std::list<DWARFUnit *> UnitLRU;
+  DenseMap<DWARFUnit *, std::list<DWARFUnit *>::iterator> UnitLRUPos;
+
+  /// Returns the memory used by the parsed line table at \p Offset.
+  uint64_t getLineTableMemoryUsage(uint64_t Offset);
+
+  /// Returns the memory used by tracked units like the public overload and,
+  /// if \p LineTableUsers is given, counts the tracked units using each line
+  /// table in it.
+  uint64_t getDIEMemoryUsage(DenseMap<uint64_t, unsigned> *LineTableUsers);
+
+  /// Call \p F for the contexts of the DWO files and DWP file that are open.
+  void forEachDWOContext(function_ref<void(DWARFContext &)> F);
+
+  /// Release the DIEs and line table of \p U.
+  void releaseUnit(DWARFUnit &U);
+
   /// Read compile units from the debug_info section (if necessary)
   /// and type units from the debug_types sections (if necessary)
   /// and store them in NormalUnits.
@@ -117,7 +170,8 @@ public:
                std::function<void(Error)> RecoverableErrorHandler =
                    WithColor::defaultErrorHandler,
                std::function<void(Error)> WarningHandler =
-                   WithColor::defaultWarningHandler);
+                   WithColor::defaultWarningHandler,
+               bool ThreadSafe = false);
   ~DWARFContext();
 
   DWARFContext(DWARFContext &) = delete;
@@ -125,21 +179,73 @@ public:
 
   const DWARFObject &getDWARFObj() const { return *DObj; }
 
+  /// Returns true if this context was created to be queried from several
+  /// threads at once.
+  bool isThreadSafe() const { return ThreadSafe; }
+
+  /// Lock the mutex guarding lazily-built context state if this context is
+  /// thread-safe. Returns an empty lock otherwise. The lock must not be held
+  /// while extracting unit DIEs.
+  std::unique_lock<std::recursive_mutex> lockIfThreadSafe() {
+    if (!ThreadSafe)
+      return std::unique_lock<std::recursive_mutex>();
+    return std::unique_lock<std::recursive_mutex>(Mutex);
+  }
+
   static bool classof(const DIContext *DICtx) {
     return DICtx->getKind() == CK_DWARF;
   }
 
+  /// Set a budget in bytes for the memory used by extracted DIEs, the address
+  /// indexes built from them and parsed line tables, or 0 for no limit. While
+  /// a budget is set, units are tracked in least recently used order and
+  /// pruneDIECache() releases the least recently used ones. The budget also
+  /// applies to each split DWARF context opened from this one. Ignored if the
+  /// context is thread-safe, where extracted DIEs are never released.
+  void setDIEMemoryBudget(uint64_t Bytes);
+
+  /// Returns the memory used by the DIEs and line tables of tracked units.
+  /// Line tables shared by several units are counted once.
+  uint64_t getDIEMemoryUsage() { return getDIEMemoryUsage(nullptr); }
+
+  /// Release the DIEs and line tables of the least recently used units until
+  /// their memory usage is within the budget. Released data is extracted
+  /// again on demand. This invalidates DWARFDie handles and line table
+  /// pointers into the released units, so it must only be called while none
+  /// are held, e.g. between two queries. Split DWARF contexts opened from this
+  /// one are pruned as well.
+  void pruneDIECache();
+
+  /// Release the DIEs and line tables of all units, for clients that are done
+  /// with this context but keep it around. Released data is extracted again
+  /// on demand. Like pruneDIECache(), this invalidates DWARFDie handles and
+  /// line table pointers into the units. Ignored if the context is
+  /// thread-safe.
+  void releaseDIEs();
+
+  /// Mark the DIEs and line table of \p U as most recently used. Called by
+  /// DWARFUnit whenever its DIEs are used.
+  void recordUnitAccess(DWARFUnit &U);
+
   /// Dump a textual representation to \p OS. If any \p DumpOffsets are present,
-  /// dump only the record at the specified offset.
+  /// dump only the record at the specified offset. If the context is
+  /// thread-safe, units are formatted in parallel using \p S.
   void dump(raw_ostream &OS, DIDumpOptions DumpOpts,
-            std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets);
+            std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets,
+            ThreadPoolStrategy S = hardware_concurrency());
 
   void dump(raw_ostream &OS, DIDumpOptions DumpOpts) override {
     std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets;
     dump(OS, DumpOpts, DumpOffsets);
   }
 
-  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override;
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts = {}) override {
+    return verify(OS, DumpOpts, hardware_concurrency());
+  }
+
+  /// Verify the debug info and report problems to \p OS. If this context is
+  /// thread-safe, units and name indexes are verified in parallel using \p S.
+  bool verify(raw_ostream &OS, DIDumpOptions DumpOpts, ThreadPoolStrategy S);
 
   using unit_iterator_range = DWARFUnitVector::iterator_range;
   using compile_unit_range = DWARFUnitVector::compile_unit_range;
@@ -236,6 +342,24 @@ public:
     return DWOUnits.getNumTypesUnits();
   }
 
+  /// Extract the DIEs, line tables and address ranges of all normal units up
+  /// front instead of on first use, e.g. when most units are going to be
+  /// queried anyway. If the context is thread-safe, units are processed in
+  /// parallel using \p S; otherwise they are processed one at a time.
+  /// Problems are reported through the context's handlers in unit order.
+  void prefetchAllUnits(ThreadPoolStrategy S = hardware_concurrency());
+
+  /// Call \p Print for each index in [0, \p Count) and write what it printed
+  /// to \p OS in index order. If the context is thread-safe, the calls run in
+  /// parallel using \p S, each printing to a buffer of its own. Buffers are
+  /// written out as soon as all calls before them are done, and only a few
+  /// calls per thread are in flight at a time, which bounds their memory.
+  /// Otherwise the calls run one at a time and, if a DIE memory budget is
+  /// set, the DIE cache is pruned after each of them, so \p Print must not
+  /// keep DWARFDie handles from one call to the next.
+  void printInOrder(raw_ostream &OS, size_t Count, ThreadPoolStrategy S,
+                    function_ref<void(raw_ostream &, size_t)> Print);
+
   /// Get the unit at the specified index.
   DWARFUnit *getUnitAtIndex(unsigned index) {
     parseNormalUnits();
@@ -270,6 +394,7 @@ public:
   }
 
   void setMaxVersionIfGreater(unsigned Version) {
+    auto Lock = lockIfThreadSafe();
     if (Version > MaxVersion)
       MaxVersion = Version;
   }
@@ -311,6 +436,25 @@ public:
   /// Get a reference to the parsed accelerator table object.
   const DWARFDebugNames &getDebugNames();
 
+  /// Get the .debug_names accelerator table if the object has one, and
+  /// otherwise an equivalent table built in memory from the DIEs of all
+  /// compile units on first use, see DWARFDebugNamesBuilder. If the context is
+  /// thread-safe, units are processed in parallel using \p S.
+  const DWARFDebugNames &
+  getOrBuildDebugNames(ThreadPoolStrategy S = hardware_concurrency());
+
+  /// Write the table built by getOrBuildDebugNames() to \p OS, so that a later
+  /// context for the same object can load it with loadDebugNamesIndex()
+  /// instead of building it again. Fails if the object has a .debug_names
+  /// section.
+  Error writeDebugNamesIndex(raw_ostream &OS,
+                             ThreadPoolStrategy S = hardware_concurrency());
+
+  /// Use an index written by writeDebugNamesIndex() as the table returned by
+  /// getOrBuildDebugNames(). Fails if the index was written for a different
+  /// object, or if getOrBuildDebugNames() has been called already.
+  Error loadDebugNamesIndex(std::unique_ptr<MemoryBuffer> Index);
+
   /// Get a reference to the parsed accelerator table object.
   const AppleAcceleratorTable &getAppleNames();
 
@@ -367,6 +511,16 @@ public:
       object::SectionedAddress Address,
       DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
 
+  /// Batch lookups resolve compile units and line table rows for all of
+  /// \p Addresses in forward sweeps over the sorted addresses, instead of
+  /// doing independent binary searches per address.
+  std::vector<DILineInfo> getLineInfoForAddresses(
+      ArrayRef<object::SectionedAddress> Addresses,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
+  std::vector<DIInliningInfo> getInliningInfoForAddresses(
+      ArrayRef<object::SectionedAddress> Addresses,
+      DILineInfoSpecifier Specifier = DILineInfoSpecifier()) override;
+
   std::vector<DILocal>
   getLocalsForAddress(object::SectionedAddress Address) override;
 
@@ -412,6 +566,15 @@ public:
 
   enum class ProcessDebugRelocations { Process, Ignore };
 
+  /// Create a context for the debug info in \p Obj.
+  ///
+  /// If \p ThreadSafe is true, the context and its units may be queried
+  /// concurrently (e.g. getLineInfoForAddress and getInliningInfoForAddress
+  /// from several threads). Lazy parsing is then guarded by per-unit once
+  /// flags instead of a global lock, and each unit's DIEs are extracted in a
+  /// single step so that DWARFDie handles stay valid while other threads
+  /// query the same unit. DWO contexts opened from a thread-safe context are
+  /// thread-safe as well.
   static std::unique_ptr<DWARFContext>
   create(const object::ObjectFile &Obj,
          ProcessDebugRelocations RelocAction = ProcessDebugRelocations::Process,
@@ -419,7 +582,8 @@ public:
          std::function<void(Error)> RecoverableErrorHandler =
              WithColor::defaultErrorHandler,
          std::function<void(Error)> WarningHandler =
-             WithColor::defaultWarningHandler);
+             WithColor::defaultWarningHandler,
+         bool ThreadSafe = false);
 
   static std::unique_ptr<DWARFContext>
   create(const StringMap<std::unique_ptr<MemoryBuffer>> &Sections,
@@ -427,7 +591,8 @@ public:
          std::function<void(Error)> RecoverableErrorHandler =
              WithColor::defaultErrorHandler,
          std::function<void(Error)> WarningHandler =
-             WithColor::defaultWarningHandler);
+             WithColor::defaultWarningHandler,
+         bool ThreadSafe = false);
 
   /// Loads register info for the architecture of the provided object file.
   /// Improves readability of dumped DWARF expressions. Requires the caller to
@@ -455,6 +620,17 @@ private:
 
   void addLocalsForDie(DWARFCompileUnit *CU, DWARFDie Subprogram, DWARFDie Die,
                        std::vector<DILocal> &Result);
+
+  /// Resolve the compile unit and, if \p NeedLineRows is set, the line table
+  /// row of each of \p Addresses, and call \p Callback with the index of the
+  /// address, its unit, the unit's line table and the row index. Addresses
+  /// not covered by any unit are skipped.
+  void resolveAddresses(ArrayRef<object::SectionedAddress> Addresses,
+                        bool NeedLineRows,
+                        function_ref<void(size_t, DWARFCompileUnit *,
+                                          const DWARFDebugLine::LineTable *,
+                                          uint32_t)>
+                            Callback);
 };
 
 } // end namespace llvm
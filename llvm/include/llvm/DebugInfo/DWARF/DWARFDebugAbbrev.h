@@ -11,6 +11,7 @@
 
 #include "llvm/DebugInfo/DWARF/DWARFAbbreviationDeclaration.h"
 #include "llvm/Support/DataExtractor.h"
+#include <cassert>
 #include <cstdint>
 #include <map>
 #include <vector>
@@ -39,6 +40,20 @@ public:
   const DWARFAbbreviationDeclaration *
   getAbbreviationDeclaration(uint32_t AbbrCode) const;
 
+  /// Returns the position of \p Decl, which must belong to this set.
+  uint32_t
+  getAbbreviationIndex(const DWARFAbbreviationDeclaration *Decl) const {
+    assert(Decl >= Decls.data() && Decl < Decls.data() + Decls.size());
+    return Decl - Decls.data();
+  }
+
+  /// Returns the abbreviation declaration at position \p Idx.
+  const DWARFAbbreviationDeclaration *
+  getAbbreviationDeclarationAtIndex(uint32_t Idx) const {
+    assert(Idx < Decls.size());
+    return &Decls[Idx];
+  }
+
   const_iterator begin() const {
     return Decls.begin();
   }
@@ -9,8 +9,10 @@
 #ifndef LLVM_DEBUGINFO_DWARF_DWARFDEBUGARANGES_H
 #define LLVM_DEBUGINFO_DWARF_DWARFDEBUGARANGES_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/DenseSet.h"
 #include "llvm/ADT/STLFunctionalExtras.h"
+#include "llvm/Support/Threading.h"
 #include <cstdint>
 #include <vector>
 
@@ -22,8 +24,17 @@ class DWARFContext;
 
 class DWARFDebugAranges {
 public:
-  void generate(DWARFContext *CTX);
+  /// Build the aranges of \p CTX from .debug_aranges and, for the compile
+  /// units it doesn't describe, from the ranges of the units. On a thread-safe
+  /// context the unit ranges are collected in parallel according to \p S.
+  void generate(DWARFContext *CTX,
+                ThreadPoolStrategy S = hardware_concurrency());
   uint64_t findAddress(uint64_t Address) const;
+  /// Like findAddress(), for each of \p Addresses, storing the compile unit
+  /// offsets in \p Result. The ranges are searched in a single forward sweep,
+  /// which is most efficient when \p Addresses are sorted.
+  void findAddresses(ArrayRef<uint64_t> Addresses,
+                     MutableArrayRef<uint64_t> Result) const;
 
 private:
   void clear();
@@ -11,6 +11,7 @@
 
 #include "llvm/BinaryFormat/Dwarf.h"
 #include "llvm/DebugInfo/DWARF/DWARFAbbreviationDeclaration.h"
+#include <cassert>
 #include <cstdint>
 
 namespace llvm {
@@ -19,9 +20,15 @@ class DWARFUnit;
 class DWARFDataExtractor;
 
 /// DWARFDebugInfoEntry - A DIE with only the minimum required data.
+///
+/// A unit keeps one entry per DIE for as long as its DIEs are extracted, so
+/// entries are packed into 16 bytes: the offset is relative to the unit and
+/// the abbreviation declaration is stored as an index into the unit's
+/// abbreviation set. Use DWARFDie, or the accessors of the owning DWARFUnit,
+/// to get the absolute offset and the abbreviation declaration.
 class DWARFDebugInfoEntry {
-  /// Offset within the .debug_info of the start of this entry.
-  uint64_t Offset = 0;
+  /// Offset of the start of this entry relative to the start of its unit.
+  uint32_t Offset = 0;
 
   /// Index of the parent die. UINT32_MAX if there is no parent.
   uint32_t ParentIdx = UINT32_MAX;
@@ -29,7 +36,9 @@ class DWARFDebugInfoEntry {
   /// Index of the sibling die. Zero if there is no sibling.
   uint32_t SiblingIdx = 0;
 
-  const DWARFAbbreviationDeclaration *AbbrevDecl = nullptr;
+  /// Index of the abbreviation declaration in the unit's abbreviation set
+  /// plus one. Zero for a NULL entry.
+  uint32_t AbbrevIdx = 0;
 
 public:
   DWARFDebugInfoEntry() = default;
@@ -42,7 +51,8 @@ public:
                    const DWARFDataExtractor &DebugInfoData, uint64_t UEndOffset,
                    uint32_t ParentIdx);
 
-  uint64_t getOffset() const { return Offset; }
+  /// Returns the offset of this entry relative to the start of its unit.
+  uint32_t getUnitRelativeOffset() const { return Offset; }
 
   /// Returns index of the parent die.
   Optional<uint32_t> getParentIdx() const {
@@ -63,14 +73,14 @@ public:
   /// Set index of sibling.
   void setSiblingIdx(uint32_t Idx) { SiblingIdx = Idx; }
 
-  dwarf::Tag getTag() const {
-    return AbbrevDecl ? AbbrevDecl->getTag() : dwarf::DW_TAG_null;
-  }
-
-  bool hasChildren() const { return AbbrevDecl && AbbrevDecl->hasChildren(); }
+  /// Returns true for an entry that terminates a sibling chain.
+  bool isNULL() const { return AbbrevIdx == 0; }
 
-  const DWARFAbbreviationDeclaration *getAbbreviationDeclarationPtr() const {
-    return AbbrevDecl;
+  /// Returns the index of the abbreviation declaration in the unit's
+  /// abbreviation set. Must not be called on a NULL entry.
+  uint32_t getAbbreviationIndex() const {
+    assert(!isNULL() && "NULL entries have no abbreviation declaration");
+    return AbbrevIdx - 1;
   }
 };
 
@@ -239,6 +239,13 @@ public:
     /// or UnknownRowIndex if there is no such row.
     uint32_t lookupAddress(object::SectionedAddress Address) const;
 
+    /// Like lookupAddress(), for each of \p Addresses, storing the row indices
+    /// in \p Result. Sequences and rows are searched in a single forward
+    /// sweep, which is most efficient when \p Addresses are sorted by section
+    /// index and address.
+    void lookupAddresses(ArrayRef<object::SectionedAddress> Addresses,
+                         MutableArrayRef<uint32_t> Result) const;
+
     bool lookupAddressRange(object::SectionedAddress Address, uint64_t Size,
                             std::vector<uint32_t> &Result) const;
 
@@ -268,9 +275,19 @@ public:
                                    DILineInfoSpecifier::FileLineInfoKind Kind,
                                    DILineInfo &Result) const;
 
+    /// Fills the Result argument with the file and line information of the
+    /// row at \p RowIndex, as returned by lookupAddress(). Returns true on
+    /// success.
+    bool getFileLineInfoForRow(uint32_t RowIndex, const char *CompDir,
+                               DILineInfoSpecifier::FileLineInfoKind Kind,
+                               DILineInfo &Result) const;
+
     void dump(raw_ostream &OS, DIDumpOptions DumpOptions) const;
     void clear();
 
+    /// Returns the approximate number of bytes used by the table.
+    size_t getMemoryUsage() const;
+
     /// Parse prologue and all rows.
     Error parse(DWARFDataExtractor &DebugLineData, uint64_t *OffsetPtr,
                 const DWARFContext &Ctx, const DWARFUnit *U,
@@ -304,6 +321,12 @@ public:
   getOrParseLineTable(DWARFDataExtractor &DebugLineData, uint64_t Offset,
                       const DWARFContext &Ctx, const DWARFUnit *U,
                       function_ref<void(Error)> RecoverableErrorHandler);
+  /// Cache an already parsed line table for \p Offset, unless a table for
+  /// that offset is cached already. Returns the cached table.
+  const LineTable *addLineTable(uint64_t Offset, LineTable Table);
+  /// Drop the cached line table for \p Offset, if any. This invalidates
+  /// pointers to it.
+  void clearLineTable(uint64_t Offset) { LineTableMap.erase(Offset); }
 
   /// Helper to allow for parsing of an entire .debug_line section in sequence.
   class SectionParser {
@@ -0,0 +1,54 @@
+//===- DWARFDebugNamesBuilder.h ---------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_DWARF_DWARFDEBUGNAMESBUILDER_H
+#define LLVM_DEBUGINFO_DWARF_DWARFDEBUGNAMESBUILDER_H
+
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Threading.h"
+#include <memory>
+#include <utility>
+
+namespace llvm {
+
+class DWARFContext;
+class DWARFDie;
+
+/// Builds a name index in the DWARF v5 .debug_names format from the DIEs of
+/// all compile units of a context, for objects that come without accelerator
+/// tables. DIEs are included following the rules of the DWARF v5
+/// specification, which DWARFVerifier checks name indexes against.
+///
+/// The index is kept in a self-contained buffer that holds the .debug_names
+/// contents and the string section its string offsets refer to, so that it
+/// can be written to a file and loaded again for the same object.
+class DWARFDebugNamesBuilder {
+public:
+  /// Append the names \p Die is indexed under to \p Names. Nothing is appended
+  /// if \p Die is not indexed.
+  static void getIndexedNames(const DWARFDie &Die,
+                              SmallVectorImpl<StringRef> &Names);
+
+  /// Build the index for \p Context. If the context is thread-safe, compile
+  /// units are processed in parallel using \p S. Problems extracting DIEs are
+  /// reported through the context's handlers in unit order.
+  static std::unique_ptr<MemoryBuffer> build(DWARFContext &Context,
+                                             ThreadPoolStrategy S);
+
+  /// Check that \p Index is an index built for the object of \p Context and
+  /// return its .debug_names and string sections.
+  static Expected<std::pair<StringRef, StringRef>>
+  getSections(DWARFContext &Context, MemoryBufferRef Index);
+};
+
+} // end namespace llvm
+
+#endif // LLVM_DEBUGINFO_DWARF_DWARFDEBUGNAMESBUILDER_H
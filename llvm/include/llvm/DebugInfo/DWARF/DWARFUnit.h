@@ -17,11 +17,13 @@
 #include "llvm/BinaryFormat/Dwarf.h"
 #include "llvm/DebugInfo/DWARF/DWARFAddressRange.h"
 #include "llvm/DebugInfo/DWARF/DWARFDataExtractor.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugAbbrev.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugInfoEntry.h"
 #include "llvm/DebugInfo/DWARF/DWARFDie.h"
 #include "llvm/DebugInfo/DWARF/DWARFLocationExpression.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnitIndex.h"
 #include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/Threading.h"
 #include <cassert>
 #include <cstddef>
 #include <cstdint>
@@ -235,16 +237,32 @@ class DWARFUnit {
   /// The compile unit debug information entry items.
   std::vector<DWARFDebugInfoEntry> DieArray;
 
-  /// Map from range's start address to end address and corresponding DIE.
-  /// IntervalMap does not support range removal, as a result, we use the
-  /// std::map::upper_bound for address range lookup.
-  std::map<uint64_t, std::pair<uint64_t, DWARFDie>> AddrDieMap;
+  /// End address and DIE index of one entry of the address to DIE index.
+  struct AddrDieRange {
+    uint64_t HighPC;
+    uint32_t DieIdx;
+  };
+
+  /// Address to subroutine DIE index: disjoint address ranges sorted by start
+  /// address, each mapped to the innermost subroutine DIE covering it. The
+  /// start addresses are kept in their own array so that lookups binary
+  /// search densely packed keys; AddrDieRanges holds the matching entries.
+  std::vector<uint64_t> AddrDieLowPCs;
+  std::vector<AddrDieRange> AddrDieRanges;
 
   using die_iterator_range =
       iterator_range<std::vector<DWARFDebugInfoEntry>::iterator>;
 
   std::shared_ptr<DWARFUnit> DWO;
 
+  /// Guard the lazily-initialized state above when the context is
+  /// thread-safe (see DWARFContext::create).
+  llvm::once_flag ExtractDIEsOnce;
+  llvm::once_flag AddrDieIndexOnce;
+  llvm::once_flag DWOOnce;
+  llvm::once_flag BaseAddrOnce;
+  mutable llvm::once_flag AbbrevsOnce;
+
   uint32_t getDIEIndex(const DWARFDebugInfoEntry *Die) {
     auto First = DieArray.data();
     assert(Die >= First && Die < First + DieArray.size());
@@ -319,9 +337,6 @@ public:
     return AddrOffsetSectionBase;
   }
 
-  /// Recursively update address to Die map.
-  void updateAddressDieMap(DWARFDie Die);
-
   void setRangesSection(const DWARFSection *RS, uint64_t Base) {
     RangeSection = RS;
     RangeSectionBase = Base;
@@ -468,6 +483,23 @@ public:
     return DWARFDie(this, &DieArray[Index]);
   }
 
+  /// Return the absolute offset of a DIE of this unit.
+  uint64_t getDIEOffset(const DWARFDebugInfoEntry &Die) const {
+    return getOffset() + Die.getUnitRelativeOffset();
+  }
+
+  /// Return the abbreviation declaration of a DIE of this unit, or nullptr
+  /// for a NULL DIE.
+  const DWARFAbbreviationDeclaration *
+  getDIEAbbreviationDeclaration(const DWARFDebugInfoEntry &Die) const {
+    if (Die.isNULL())
+      return nullptr;
+    // The abbreviation set has been looked up to extract the DIE.
+    assert(Abbrevs && "DIE extracted without an abbreviation set");
+    return Abbrevs->getAbbreviationDeclarationAtIndex(
+        Die.getAbbreviationIndex());
+  }
+
   DWARFDie getParent(const DWARFDebugInfoEntry *Die);
   DWARFDie getSibling(const DWARFDebugInfoEntry *Die);
   DWARFDie getPreviousSibling(const DWARFDebugInfoEntry *Die);
@@ -480,11 +512,14 @@ public:
   /// The unit needs to have its DIEs extracted for this method to work.
   DWARFDie getDIEForOffset(uint64_t Offset) {
     extractDIEsIfNeeded(false);
+    if (Offset < getOffset())
+      return DWARFDie();
+    uint64_t RelOffset = Offset - getOffset();
     auto It =
         llvm::partition_point(DieArray, [=](const DWARFDebugInfoEntry &DIE) {
-          return DIE.getOffset() < Offset;
+          return DIE.getUnitRelativeOffset() < RelOffset;
         });
-    if (It != DieArray.end() && It->getOffset() == Offset)
+    if (It != DieArray.end() && It->getUnitRelativeOffset() == RelOffset)
       return DWARFDie(this, &*It);
     return DWARFDie();
   }
@@ -505,6 +540,16 @@ public:
 
   Error tryExtractDIEsIfNeeded(bool CUDieOnly);
 
+  /// Free the extracted DIEs other than the unit DIE, and the address index
+  /// built from them. They are extracted again on demand. This invalidates
+  /// all DWARFDie handles into this unit. Not supported if the context is
+  /// thread-safe.
+  void releaseDIEs();
+
+  /// Returns the approximate number of bytes used by the extracted DIEs and
+  /// the address index built from them.
+  size_t getDIEMemoryUsage() const;
+
 private:
   /// Size in bytes of the .debug_info data associated with this compile unit.
   size_t getDebugInfoSize() const {
@@ -516,6 +561,12 @@ private:
   /// hasn't already been done
   void extractDIEsIfNeeded(bool CUDieOnly);
 
+  /// Unsynchronized implementation of tryExtractDIEsIfNeeded.
+  Error tryExtractDIEsIfNeededImpl(bool CUDieOnly);
+
+  /// Build the address to subroutine DIE index from the extracted DIEs.
+  void buildAddressDieIndex();
+
   /// extractDIEsToVector - Appends all parsed DIEs to a vector.
   void extractDIEsToVector(bool AppendCUDie, bool AppendNonCUDIEs,
                            std::vector<DWARFDebugInfoEntry> &DIEs) const;
@@ -526,6 +577,9 @@ private:
   /// parseDWO - Parses .dwo file for current compile unit. Returns true if
   /// it was actually constructed.
   bool parseDWO();
+
+  /// Unsynchronized implementation of parseDWO.
+  bool parseDWOImpl();
 };
 
 inline bool isCompileUnit(const std::unique_ptr<DWARFUnit> &U) {
@@ -14,6 +14,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFAcceleratorTable.h"
 #include "llvm/DebugInfo/DWARF/DWARFDie.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnit.h"
+#include "llvm/Support/Threading.h"
 #include <cstdint>
 #include <map>
 #include <set>
@@ -82,6 +83,8 @@ private:
   // Used to relax some checks that do not currently work portably
   bool IsObjectFile;
   bool IsMachOObject;
+  /// Threads used to verify units and name indexes of a thread-safe context.
+  ThreadPoolStrategy Strategy;
   using ReferenceMap = std::map<uint64_t, std::set<uint64_t>>;
 
   raw_ostream &error() const;
@@ -89,6 +92,15 @@ private:
   raw_ostream &note() const;
   raw_ostream &dump(const DWARFDie &Die, unsigned indent = 0) const;
 
+  /// Run \p Task for each index in [0, \p NumTasks) and return the sum of
+  /// the errors they found. If the context is thread-safe, tasks run in
+  /// parallel, each on a verifier of its own that buffers its output, and the
+  /// buffers are written to OS in index order. Tasks must only report through
+  /// the verifier they are passed.
+  unsigned
+  verifyInParallel(size_t NumTasks,
+                   function_ref<unsigned(DWARFVerifier &, size_t)> Task);
+
   /// Verifies the abbreviations section.
   ///
   /// This function currently checks that:
@@ -277,8 +289,11 @@ private:
                             const DataExtractor &StrData);
 
 public:
+  /// If \p D is thread-safe, units and name index entries are verified in
+  /// parallel using \p Threads. The output does not depend on the thread count.
   DWARFVerifier(raw_ostream &S, DWARFContext &D,
-                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE());
+                DIDumpOptions DumpOpts = DIDumpOptions::getForSingleDIE(),
+                ThreadPoolStrategy Threads = hardware_concurrency());
 
   /// Verify the information in any of the following sections, if available:
   /// .debug_abbrev, debug_abbrev.dwo
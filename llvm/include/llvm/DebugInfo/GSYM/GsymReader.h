@@ -123,6 +123,22 @@ public:
   /// for failing to lookup the address.
   llvm::Expected<LookupResult> lookup(uint64_t Addr) const;
 
+  /// Lookup many addresses in the GSYM.
+  ///
+  /// The addresses are resolved against the address table in ascending order
+  /// so that each search starts where the previous one ended, which makes a
+  /// batch much cheaper than calling lookup() for each address. Addresses
+  /// that are already sorted are not copied or sorted again.
+  ///
+  /// \param Addrs Virtual addresses from the original object file to lookup.
+  /// \returns A LookupResult or an error for each address, in the order of
+  /// \a Addrs. Errors are the same as the ones lookup() returns.
+  std::vector<llvm::Expected<LookupResult>>
+  lookupAddresses(ArrayRef<uint64_t> Addrs) const;
+
+  /// Get the size in bytes of the GSYM data mapped or loaded by this object.
+  size_t getBufferSize() const;
+
   /// Get a string from the string table.
   ///
   /// \param Offset The string table offset for the string to retrieve.
@@ -251,14 +267,18 @@ protected:
   ///
   /// \param AddrOffset An address offset, that has already been computed by
   /// subtracting the gsym::Header::BaseAddress.
+  /// \param Start An index that is known not to be past the matching index,
+  /// used to narrow the search.
   /// \returns The matching address offset index. This index will be used to
   /// extract the FunctionInfo data's offset from the AddrInfoOffsets array.
   template <class T>
-  llvm::Optional<uint64_t> getAddressOffsetIndex(const uint64_t AddrOffset) const {
+  llvm::Optional<uint64_t> getAddressOffsetIndex(const uint64_t AddrOffset,
+                                                 size_t Start = 0) const {
     ArrayRef<T> AIO = getAddrOffsets<T>();
     const auto Begin = AIO.begin();
     const auto End = AIO.end();
-    auto Iter = std::lower_bound(Begin, End, AddrOffset);
+    assert(Start <= AIO.size() && "search start is out of bounds");
+    auto Iter = std::lower_bound(Begin + Start, End, AddrOffset);
     // Watch for addresses that fall between the gsym::Header::BaseAddress and
     // the first address offset.
     if (Iter == Begin && AddrOffset < *Begin)
@@ -287,10 +307,22 @@ protected:
   ///
   /// \param Addr A virtual address that matches the original object file
   /// to lookup.
+  /// \param Start An address index that is known not to be past the matching
+  /// index, used to narrow the search.
   /// \returns An index into the address table. This index can be used to
   /// extract the FunctionInfo data's offset from the AddrInfoOffsets array.
   /// Returns an error if the address isn't in the GSYM with details of why.
-  Expected<uint64_t> getAddressIndex(const uint64_t Addr) const;
+  Expected<uint64_t> getAddressIndex(const uint64_t Addr,
+                                     uint64_t Start = 0) const;
+
+  /// Lookup an address whose address index is already known.
+  ///
+  /// \param Addr A virtual address from the orignal object file to lookup.
+  /// \param AddressIndex The address index getAddressIndex() returned for
+  /// \a Addr.
+  /// \returns The same result as lookup().
+  llvm::Expected<LookupResult> lookupAddressIndex(uint64_t Addr,
+                                                  uint64_t AddressIndex) const;
 
   /// Given an address index, get the offset for the FunctionInfo.
   ///
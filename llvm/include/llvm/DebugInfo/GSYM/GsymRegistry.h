@@ -0,0 +1,107 @@
+//===- GsymRegistry.h -------------------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_DEBUGINFO_GSYM_GSYMREGISTRY_H
+#define LLVM_DEBUGINFO_GSYM_GSYMREGISTRY_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/GSYM/LookupResult.h"
+#include "llvm/Support/Error.h"
+#include <cstdint>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <string>
+#include <vector>
+
+namespace llvm {
+namespace gsym {
+
+class GsymReader;
+
+/// GsymRegistry serves lookups for many GSYM files keyed by the UUID of the
+/// object file they were created from, e.g. its build ID.
+///
+/// Files are registered by path and only opened, which maps them read only
+/// into memory, when an address is first looked up in them. If a limit is
+/// set, the least recently used files are unmapped once the files mapped
+/// together exceed it. Readers handed out by getReader() stay valid after
+/// their file has been evicted, until the last reference to them is dropped.
+///
+/// All member functions may be called from several threads at once.
+class GsymRegistry {
+public:
+  /// \param MaxMappedBytes The total size of the GSYM files to keep mapped,
+  /// or 0 for no limit. The most recently used file is always kept mapped,
+  /// even if it is larger than the limit.
+  explicit GsymRegistry(uint64_t MaxMappedBytes = 0);
+  ~GsymRegistry();
+
+  /// Register the GSYM file at \a Path for \a UUID without opening it. A later
+  /// registration for the same UUID replaces this one.
+  void addFile(ArrayRef<uint8_t> UUID, StringRef Path);
+
+  /// Open the GSYM file at \a Path and register it for the UUID in its
+  /// header. The file stays mapped like any file that has been looked up.
+  ///
+  /// \returns An error if the file can't be opened or has no UUID.
+  llvm::Error addFile(StringRef Path);
+
+  /// Get the reader for the GSYM file registered for \a UUID, opening the
+  /// file if it isn't mapped.
+  ///
+  /// \returns The reader, or an error if no file is registered for \a UUID,
+  /// if the file can't be opened or if its header has a different UUID.
+  llvm::Expected<std::shared_ptr<const GsymReader>>
+  getReader(ArrayRef<uint8_t> UUID);
+
+  /// Lookup \a Addr in the GSYM file registered for \a UUID.
+  llvm::Expected<LookupResult> lookup(ArrayRef<uint8_t> UUID, uint64_t Addr);
+
+  /// Lookup \a Addrs in the GSYM file registered for \a UUID, using
+  /// GsymReader::lookupAddresses().
+  ///
+  /// \returns A LookupResult or an error for each address, in the order of
+  /// \a Addrs, or an error if the file can't be used.
+  llvm::Expected<std::vector<llvm::Expected<LookupResult>>>
+  lookupAddresses(ArrayRef<uint8_t> UUID, ArrayRef<uint64_t> Addrs);
+
+  /// Get the total size of the GSYM files that are currently mapped.
+  uint64_t getMappedBytes() const;
+
+private:
+  struct Entry {
+    std::string Path;
+    /// The reader while the file is mapped.
+    std::shared_ptr<const GsymReader> Reader;
+    /// Position in MappedLRU while the file is mapped.
+    std::list<Entry *>::iterator LRUPos;
+  };
+
+  /// Add a mapped \a Reader to \a E and unmap other files if needed. Called
+  /// with Mutex held.
+  void map(Entry &E, std::shared_ptr<const GsymReader> Reader);
+
+  /// Drop the reader of \a E. Called with Mutex held.
+  void unmap(Entry &E);
+
+  uint64_t MaxMappedBytes;
+  uint64_t MappedBytes = 0;
+  /// Registered files keyed by the bytes of their UUID.
+  StringMap<Entry> Entries;
+  /// Mapped files, least recently used first.
+  std::list<Entry *> MappedLRU;
+  mutable std::mutex Mutex;
+};
+
+} // namespace gsym
+} // namespace llvm
+
+#endif // LLVM_DEBUGINFO_GSYM_GSYMREGISTRY_H
@@ -0,0 +1,139 @@
+//===- IndexedSymbolizableModule.h ------------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// This file declares the IndexedSymbolizableModule class, which answers code
+// queries from a precomputed, memory-mappable symbolization index.
+//
+//===----------------------------------------------------------------------===//
+#ifndef LLVM_DEBUGINFO_SYMBOLIZE_INDEXEDSYMBOLIZABLEMODULE_H
+#define LLVM_DEBUGINFO_SYMBOLIZE_INDEXEDSYMBOLIZABLEMODULE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/DebugInfo/DIContext.h"
+#include "llvm/DebugInfo/Symbolize/SymbolizableModule.h"
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/MemoryBuffer.h"
+#include <cstdint>
+#include <memory>
+
+namespace llvm {
+
+class raw_ostream;
+
+namespace symbolize {
+
+class SymbolizableObjectFile;
+
+// The symbolization index splits the address space of a module into ranges
+// over which symbolizeCode() and symbolizeInlinedCode() return the same
+// result, and stores that result for each range. All fields are little-endian
+// so that an index can be used directly from a memory mapped file.
+namespace index {
+
+const char Magic[8] = {'L', 'L', 'V', 'M', 'S', 'Y', 'M', 'I'};
+const uint32_t Version = 1;
+const uint32_t NoString = UINT32_MAX;
+
+struct Header {
+  char Magic[8];
+  support::ulittle32_t Version;
+  // The DILineInfoSpecifier and UseSymbolTable flag the index was built with.
+  support::ulittle32_t FileLineInfoKind;
+  support::ulittle32_t FunctionNameKind;
+  support::ulittle32_t UseSymbolTable;
+  support::ulittle64_t PreferredBase;
+  support::ulittle64_t NumRanges;
+  support::ulittle64_t NumFrames;
+  support::ulittle64_t StringTableSize;
+};
+
+// The results for addresses in [Address, next range's Address).
+struct Range {
+  support::ulittle64_t Address;
+  // Frames of symbolizeInlinedCode(), innermost first.
+  support::ulittle32_t FirstInlinedFrame;
+  support::ulittle32_t NumInlinedFrames;
+  // The frame returned by symbolizeCode().
+  support::ulittle32_t CodeFrame;
+};
+
+// A DILineInfo. Strings are offsets of NUL-terminated strings in the string
+// table, or NoString.
+struct Frame {
+  support::ulittle32_t FileName;
+  support::ulittle32_t FunctionName;
+  support::ulittle32_t StartFileName;
+  support::ulittle32_t Source;
+  support::ulittle32_t Line;
+  support::ulittle32_t Column;
+  support::ulittle32_t StartLine;
+  support::ulittle32_t Discriminator;
+  support::ulittle32_t HasStartAddress;
+  support::ulittle64_t StartAddress;
+};
+
+} // end namespace index
+
+class IndexedSymbolizableModule : public SymbolizableModule {
+public:
+  // Create a module answering code queries from the index in \p Index.
+  // Queries the index cannot answer (data and frame queries, queries with an
+  // explicit section index or with other options than the index was built
+  // with) are forwarded to \p Module. If \p Index is malformed, an error is
+  // returned and \p Module is left untouched.
+  static Expected<std::unique_ptr<IndexedSymbolizableModule>>
+  create(std::unique_ptr<MemoryBuffer> Index,
+         std::unique_ptr<SymbolizableModule> &&Module);
+
+  // Write the symbolization index of \p Module for the given options to
+  // \p OS.
+  static Error writeIndex(const SymbolizableObjectFile &Module,
+                          DILineInfoSpecifier LineInfoSpecifier,
+                          bool UseSymbolTable, raw_ostream &OS);
+
+  DILineInfo symbolizeCode(object::SectionedAddress ModuleOffset,
+                           DILineInfoSpecifier LineInfoSpecifier,
+                           bool UseSymbolTable) const override;
+  DIInliningInfo symbolizeInlinedCode(object::SectionedAddress ModuleOffset,
+                                      DILineInfoSpecifier LineInfoSpecifier,
+                                      bool UseSymbolTable) const override;
+  DIGlobal symbolizeData(object::SectionedAddress ModuleOffset) const override;
+  std::vector<DILocal>
+  symbolizeFrame(object::SectionedAddress ModuleOffset) const override;
+
+  bool isWin32Module() const override;
+  uint64_t getModulePreferredBase() const override;
+
+private:
+  IndexedSymbolizableModule(std::unique_ptr<MemoryBuffer> Index,
+                            std::unique_ptr<SymbolizableModule> Module)
+      : Index(std::move(Index)), Module(std::move(Module)) {}
+
+  // Returns the range containing \p ModuleOffset, or nullptr if the query
+  // must be forwarded to Module.
+  const index::Range *lookup(object::SectionedAddress ModuleOffset,
+                             DILineInfoSpecifier LineInfoSpecifier,
+                             bool UseSymbolTable) const;
+  DILineInfo getFrame(uint32_t Idx) const;
+  StringRef getString(uint32_t Offset) const;
+
+  std::unique_ptr<MemoryBuffer> Index;
+  std::unique_ptr<SymbolizableModule> Module;
+
+  const index::Header *Hdr = nullptr;
+  ArrayRef<index::Range> Ranges;
+  ArrayRef<index::Frame> Frames;
+  StringRef StringTable;
+};
+
+} // end namespace symbolize
+} // end namespace llvm
+
+#endif // LLVM_DEBUGINFO_SYMBOLIZE_INDEXEDSYMBOLIZABLEMODULE_H
@@ -33,6 +33,31 @@ public:
                        bool UseSymbolTable) const = 0;
   virtual DIGlobal
   symbolizeData(object::SectionedAddress ModuleOffset) const = 0;
+
+  // Batch versions of symbolizeCode() and symbolizeInlinedCode(). Results are
+  // returned in the order of ModuleOffsets.
+  virtual std::vector<DILineInfo>
+  symbolizeCodeBatch(ArrayRef<object::SectionedAddress> ModuleOffsets,
+                     DILineInfoSpecifier LineInfoSpecifier,
+                     bool UseSymbolTable) const {
+    std::vector<DILineInfo> Result;
+    Result.reserve(ModuleOffsets.size());
+    for (object::SectionedAddress ModuleOffset : ModuleOffsets)
+      Result.push_back(
+          symbolizeCode(ModuleOffset, LineInfoSpecifier, UseSymbolTable));
+    return Result;
+  }
+  virtual std::vector<DIInliningInfo>
+  symbolizeInlinedCodeBatch(ArrayRef<object::SectionedAddress> ModuleOffsets,
+                            DILineInfoSpecifier LineInfoSpecifier,
+                            bool UseSymbolTable) const {
+    std::vector<DIInliningInfo> Result;
+    Result.reserve(ModuleOffsets.size());
+    for (object::SectionedAddress ModuleOffset : ModuleOffsets)
+      Result.push_back(symbolizeInlinedCode(ModuleOffset, LineInfoSpecifier,
+                                            UseSymbolTable));
+    return Result;
+  }
   virtual std::vector<DILocal>
   symbolizeFrame(object::SectionedAddress ModuleOffset) const = 0;
 
@@ -43,6 +43,14 @@ public:
   DIGlobal symbolizeData(object::SectionedAddress ModuleOffset) const override;
   std::vector<DILocal>
   symbolizeFrame(object::SectionedAddress ModuleOffset) const override;
+  std::vector<DILineInfo>
+  symbolizeCodeBatch(ArrayRef<object::SectionedAddress> ModuleOffsets,
+                     DILineInfoSpecifier LineInfoSpecifier,
+                     bool UseSymbolTable) const override;
+  std::vector<DIInliningInfo>
+  symbolizeInlinedCodeBatch(ArrayRef<object::SectionedAddress> ModuleOffsets,
+                            DILineInfoSpecifier LineInfoSpecifier,
+                            bool UseSymbolTable) const override;
 
   // Return true if this is a 32-bit x86 PE COFF module.
   bool isWin32Module() const override;
@@ -51,6 +59,11 @@ public:
   // it in memory assuming there were no conflicts.
   uint64_t getModulePreferredBase() const override;
 
+  // Returns the sorted addresses at which the results of symbolizeCode() and
+  // symbolizeInlinedCode() may change: symbol, text section, line table row
+  // and subroutine DIE boundaries. Only supported for DWARF debug info.
+  Expected<std::vector<uint64_t>> getSymbolizationBoundaries() const;
+
 private:
   bool shouldOverrideWithSymbolTable(FunctionNameKind FNKind,
                                      bool UseSymbolTable) const;
@@ -58,6 +71,12 @@ private:
   bool getNameFromSymbolTable(uint64_t Address, std::string &Name,
                               uint64_t &Addr, uint64_t &Size,
                               std::string &FileName) const;
+  // Override the function name and start address in LineInfo with the symbol
+  // table entry containing Address, if any.
+  void overrideWithSymbolTable(uint64_t Address, DILineInfo &LineInfo) const;
+  // Fill in the section index of ModuleOffsets which do not have one.
+  std::vector<object::SectionedAddress>
+  getSectionedAddresses(ArrayRef<object::SectionedAddress> ModuleOffsets) const;
   // For big-endian PowerPC64 ELF, OpdAddress is the address of the .opd
   // (function descriptor) section and OpdExtractor refers to its contents.
   Error addSymbol(const object::SymbolRef &Symbol, uint64_t SymbolSize,
@@ -30,6 +30,9 @@
 #include <vector>
 
 namespace llvm {
+class DWARFContext;
+class MemoryBuffer;
+
 namespace object {
 class ELFObjectFileBase;
 class MachOObjectFile;
@@ -40,6 +43,7 @@ struct SectionedAddress;
 namespace symbolize {
 
 class SymbolizableModule;
+class SymbolizableObjectFile;
 
 using namespace object;
 
@@ -66,6 +70,17 @@ public:
     size_t MaxCacheSize = sizeof(size_t) == 4
                               ? 512 * 1024 * 1024 /* 512 MiB */
                               : 4ULL * 1024 * 1024 * 1024 /* 4 GiB */;
+    // If not 0, pruneCache() also releases the least recently used DIEs and
+    // line tables parsed from the DWARF of each module until they take at
+    // most about this many bytes.
+    uint64_t DIEMemoryBudget = 0;
+    // If not empty, symbolization indexes of ELF executables and shared
+    // objects with a build ID are persisted in this directory and reused
+    // across runs. Binaries with split DWARF are not indexed.
+    std::string IndexCacheDirectory;
+    // The pruning policy of IndexCacheDirectory, in the format accepted by
+    // parseCachePruningPolicy().
+    std::string IndexCachePruningPolicy;
   };
 
   LLVMSymbolizer();
@@ -90,6 +105,28 @@ public:
   symbolizeInlinedCode(ArrayRef<uint8_t> BuildID,
                        object::SectionedAddress ModuleOffset);
 
+  // Batch versions of symbolizeCode() and symbolizeInlinedCode() for many
+  // addresses in the same module. Results are returned in the order of
+  // ModuleOffsets, but the addresses are resolved in sorted order.
+  Expected<std::vector<DILineInfo>>
+  symbolizeCodeBatch(const ObjectFile &Obj,
+                     ArrayRef<object::SectionedAddress> ModuleOffsets);
+  Expected<std::vector<DILineInfo>>
+  symbolizeCodeBatch(const std::string &ModuleName,
+                     ArrayRef<object::SectionedAddress> ModuleOffsets);
+  Expected<std::vector<DILineInfo>>
+  symbolizeCodeBatch(ArrayRef<uint8_t> BuildID,
+                     ArrayRef<object::SectionedAddress> ModuleOffsets);
+  Expected<std::vector<DIInliningInfo>>
+  symbolizeInlinedCodeBatch(const ObjectFile &Obj,
+                            ArrayRef<object::SectionedAddress> ModuleOffsets);
+  Expected<std::vector<DIInliningInfo>>
+  symbolizeInlinedCodeBatch(const std::string &ModuleName,
+                            ArrayRef<object::SectionedAddress> ModuleOffsets);
+  Expected<std::vector<DIInliningInfo>>
+  symbolizeInlinedCodeBatch(ArrayRef<uint8_t> BuildID,
+                            ArrayRef<object::SectionedAddress> ModuleOffsets);
+
   Expected<DIGlobal> symbolizeData(const ObjectFile &Obj,
                                    object::SectionedAddress ModuleOffset);
   Expected<DIGlobal> symbolizeData(const std::string &ModuleName,
@@ -107,7 +144,8 @@ public:
   void flush();
 
   // Evict entries from the binary cache until it is under the maximum size
-  // given in the options. Calling this invalidates references in the DI...
+  // given in the options, and release parsed debug info beyond
+  // Options::DIEMemoryBudget. Calling this invalidates references in the DI...
   // objects returned by the methods above.
   void pruneCache();
 
@@ -133,6 +171,14 @@ private:
   symbolizeInlinedCodeCommon(const T &ModuleSpecifier,
                              object::SectionedAddress ModuleOffset);
   template <typename T>
+  Expected<std::vector<DILineInfo>>
+  symbolizeCodeBatchCommon(const T &ModuleSpecifier,
+                           ArrayRef<object::SectionedAddress> ModuleOffsets);
+  template <typename T>
+  Expected<std::vector<DIInliningInfo>> symbolizeInlinedCodeBatchCommon(
+      const T &ModuleSpecifier,
+      ArrayRef<object::SectionedAddress> ModuleOffsets);
+  template <typename T>
   Expected<DIGlobal> symbolizeDataCommon(const T &ModuleSpecifier,
                                          object::SectionedAddress ModuleOffset);
   template <typename T>
@@ -158,6 +204,21 @@ private:
   createModuleInfo(const ObjectFile *Obj, std::unique_ptr<DIContext> Context,
                    StringRef ModuleName);
 
+  /// Returns a module answering code queries from the symbolization index of
+  /// \p Obj in Opts.IndexCacheDirectory, building and caching the index
+  /// first if needed. \p DebugInfoKey identifies the debug info \p Module
+  /// was created with. Returns \p Module itself if \p Obj cannot be indexed
+  /// or the cache is unusable.
+  std::unique_ptr<SymbolizableModule>
+  getIndexedModule(const ObjectFile *Obj, StringRef DebugInfoKey,
+                   std::unique_ptr<SymbolizableObjectFile> Module);
+
+  /// Returns the index of \p Module stored under \p Key in
+  /// Opts.IndexCacheDirectory, building and storing it first if it is not
+  /// there. Returns null if the cache is unusable.
+  std::unique_ptr<MemoryBuffer> getIndex(const SymbolizableObjectFile &Module,
+                                         StringRef Key);
+
   ObjectFile *lookUpDsymFile(const std::string &Path,
                              const MachOObjectFile *ExeObj,
                              const std::string &ArchName);
@@ -190,6 +251,9 @@ private:
 
   std::map<std::string, std::unique_ptr<SymbolizableModule>, std::less<>>
       Modules;
+  /// The DWARF contexts of the modules in Modules, while a DIE memory budget
+  /// is set.
+  std::map<std::string, DWARFContext *, std::less<>> DWARFContexts;
   StringMap<std::string> BuildIDPaths;
 
   /// Contains cached results of getOrCreateObjectPair().
@@ -217,13 +281,15 @@ private:
 // A binary intrusively linked into a LRU cache list. If the binary is empty,
 // then the entry marks that an error occurred, and it is not part of the LRU
 // list.
+// The binary itself may be shared with other users through the process-wide
+// SharedBinaryCache.
 class CachedBinary : public ilist_node<CachedBinary> {
 public:
   CachedBinary() = default;
-  CachedBinary(OwningBinary<Binary> Bin) : Bin(std::move(Bin)) {}
+  CachedBinary(std::shared_ptr<OwningBinary<Binary>> Bin)
+      : Bin(std::move(Bin)) {}
 
-  OwningBinary<Binary> &operator*() { return Bin; }
-  OwningBinary<Binary> *operator->() { return &Bin; }
+  Binary *getBinary() const { return Bin ? Bin->getBinary() : nullptr; }
 
   // Add an action to be performed when the binary is evicted, before all
   // previously registered evictors.
@@ -236,10 +302,10 @@ public:
       Evictor();
   }
 
-  size_t size() { return Bin.getBinary()->getData().size(); }
+  size_t size() { return getBinary()->getData().size(); }
 
 private:
-  OwningBinary<Binary> Bin;
+  std::shared_ptr<OwningBinary<Binary>> Bin;
   std::function<void()> Evictor;
 };
 
@@ -24,6 +24,7 @@
 #include "llvm/Support/DynamicLibrary.h"
 #include <algorithm>
 #include <cstdint>
+#include <mutex>
 #include <utility>
 #include <vector>
 
@@ -301,6 +302,7 @@ private:
   GetObjectFileInterface GetObjFileInterface;
   std::unique_ptr<MemoryBuffer> ArchiveBuffer;
   std::unique_ptr<object::Archive> Archive;
+  std::once_flag SymbolIndexOnce;
 };
 
 } // end namespace orc
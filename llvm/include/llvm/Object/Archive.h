@@ -13,6 +13,7 @@
 #ifndef LLVM_OBJECT_ARCHIVE_H
 #define LLVM_OBJECT_ARCHIVE_H
 
+#include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/ADT/fallible_iterator.h"
 #include "llvm/ADT/iterator_range.h"
@@ -303,6 +304,8 @@ public:
     }
 
     StringRef getName() const;
+    /// \return the offset of the member that defines the symbol.
+    Expected<uint64_t> getMemberOffset() const;
     Expected<Child> getMember() const;
     Symbol getNext() const;
   };
@@ -359,6 +362,20 @@ public:
   // check if a symbol is in the archive
   Expected<Optional<Child>> findSym(StringRef name) const;
 
+  /// Find the first member named \p Name.
+  Expected<Optional<Child>> findMember(StringRef Name) const;
+
+  /// Build a hash table from symbol names to the members that define them.
+  /// Afterwards findSym no longer scans the symbol table, which pays off for
+  /// clients that look up many symbols. Without it, findSym scans.
+  Error buildSymbolIndex();
+  bool hasSymbolIndex() const { return HasSymbolIndex; }
+
+  /// Build a hash table from member names to members, which findMember uses
+  /// instead of scanning the members.
+  Error buildMemberIndex();
+  bool hasMemberIndex() const { return HasMemberIndex; }
+
   bool isEmpty() const;
   bool hasSymbolTable() const;
   StringRef getSymbolTable() const { return SymbolTable; }
@@ -379,9 +396,17 @@ protected:
   void setFirstRegular(const Child &C);
 
 private:
+  Expected<Child> getChildAt(uint64_t Offset) const;
+
   StringRef SymbolTable;
   StringRef StringTable;
 
+  /// The lookup indexes map names to the offsets of members.
+  StringMap<uint64_t> SymbolIndex;
+  StringMap<uint64_t> MemberIndex;
+  bool HasSymbolIndex = false;
+  bool HasMemberIndex = false;
+
   StringRef FirstRegularData;
   uint16_t FirstRegularStartOfFile = -1;
 
@@ -0,0 +1,33 @@
+//===- llvm/Object/BuildID.h - Build ID -------------------------*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares a library for handling Build IDs and using them to find
+/// debug info.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_BUILDID_H
+#define LLVM_OBJECT_BUILDID_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include <cstdint>
+
+namespace llvm {
+namespace object {
+
+class ObjectFile;
+
+/// Returns the build ID of \p Obj, if it is an ELF object file that has one.
+Optional<ArrayRef<uint8_t>> getBuildID(const ObjectFile *Obj);
+
+} // namespace object
+} // namespace llvm
+
+#endif // LLVM_OBJECT_BUILDID_H
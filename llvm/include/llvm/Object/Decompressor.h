@@ -56,10 +56,13 @@ private:
   Decompressor(StringRef Data);
 
   Error consumeCompressedGnuHeader();
-  Error consumeCompressedZLibHeader(bool Is64Bit, bool IsLittleEndian);
+  Error consumeCompressedELFHeader(bool Is64Bit, bool IsLittleEndian);
 
   StringRef SectionData;
   uint64_t DecompressedSize;
+  /// The ELFCOMPRESS_* algorithm of the section. GNU style compressed
+  /// sections always use zlib.
+  uint32_t CompressionType;
 };
 
 } // end namespace object
@@ -0,0 +1,85 @@
+//===- SharedBinaryCache.h - Process-wide cache of binaries -----*- C++ -*-===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+///
+/// \file
+/// This file declares a cache of opened binaries that is shared by all users
+/// in a process, so that each file is mapped and parsed only once.
+///
+//===----------------------------------------------------------------------===//
+
+#ifndef LLVM_OBJECT_SHAREDBINARYCACHE_H
+#define LLVM_OBJECT_SHAREDBINARYCACHE_H
+
+#include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/ADT/StringRef.h"
+#include "llvm/Object/Binary.h"
+#include "llvm/Support/Chrono.h"
+#include "llvm/Support/Error.h"
+#include "llvm/Support/FileSystem.h"
+#include <cstdint>
+#include <memory>
+#include <mutex>
+
+namespace llvm {
+namespace object {
+
+/// A cache of binaries opened by path, shared by everything in the process
+/// that opens binaries through it. Binaries are reference counted: the cache
+/// only refers to them weakly, so a binary is unmapped once its last user
+/// releases it. Entries are keyed by path and validated against the size and
+/// modification time of the file, and ELF object files are additionally
+/// indexed by build ID, preferring files that contain debug info. The cache is
+/// thread-safe.
+class SharedBinaryCache {
+public:
+  using SharedBinary = std::shared_ptr<OwningBinary<Binary>>;
+
+  /// Returns the cache of the process.
+  static SharedBinaryCache &get();
+
+  /// Returns the binary at \p Path. If it is already open and the file has not
+  /// changed since, the open binary is returned instead of opening the file
+  /// again.
+  Expected<SharedBinary> getOrOpen(StringRef Path);
+
+  /// Returns an open object file with build ID \p BuildID, or null if there
+  /// is none. If several are open, one with debug info is preferred.
+  SharedBinary lookupBuildID(ArrayRef<uint8_t> BuildID);
+
+private:
+  struct Entry {
+    sys::TimePoint<> ModificationTime;
+    uint64_t Size = 0;
+    std::weak_ptr<OwningBinary<Binary>> Bin;
+
+    /// Returns whether the entry is for the file with status \p Status.
+    bool isCurrent(const sys::fs::file_status &Status) const {
+      return ModificationTime == Status.getLastModificationTime() &&
+             Size == Status.getSize();
+    }
+  };
+
+  struct BuildIDEntry {
+    std::weak_ptr<OwningBinary<Binary>> Bin;
+    bool HasDebugInfo = false;
+  };
+
+  void removeExpiredEntries();
+
+  std::mutex Mutex;
+  StringMap<Entry> ByPath;
+  StringMap<BuildIDEntry> ByBuildID;
+  /// Expired entries are removed once ByPath grows to this size.
+  size_t NextCleanup = 64;
+};
+
+} // namespace object
+} // namespace llvm
+
+#endif // LLVM_OBJECT_SHAREDBINARYCACHE_H
@@ -27,11 +27,25 @@ static constexpr int BestSpeedCompression = 1;
 static constexpr int DefaultCompression = 6;
 static constexpr int BestSizeCompression = 9;
 
+/// compressParallel() splits its input into shards of this size.
+static constexpr size_t ParallelShardSize = 1 << 20;
+
 bool isAvailable();
 
 Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
                int Level = DefaultCompression);
 
+/// Like compress(), but inputs larger than ParallelShardSize are split into
+/// shards that are deflated concurrently according to parallel::strategy.
+/// Every shard but the last ends with a sync flush and shards do not share a
+/// dictionary, so the result is a single zlib stream that can be decompressed
+/// by any zlib implementation. It is not byte-identical to the output of
+/// compress() for such inputs, but does not depend on the number of threads.
+/// Smaller inputs are compressed exactly like compress() does.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression);
+
 Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                  size_t &UncompressedSize);
 
@@ -43,6 +57,40 @@ uint32_t crc32(StringRef Buffer);
 
 }  // End of namespace zlib
 
+namespace zstd {
+
+static constexpr int NoCompression = -5;
+static constexpr int BestSpeedCompression = 1;
+static constexpr int DefaultCompression = 5;
+static constexpr int BestSizeCompression = 12;
+
+/// compressParallel() splits its input into shards of this size.
+static constexpr size_t ParallelShardSize = 1 << 20;
+
+bool isAvailable();
+
+Error compress(StringRef InputBuffer, SmallVectorImpl<char> &CompressedBuffer,
+               int Level = DefaultCompression);
+
+/// Like compress(), but inputs larger than ParallelShardSize are split into
+/// shards that are compressed concurrently according to parallel::strategy,
+/// each into its own zstd frame. Concatenated frames form a valid zstd
+/// stream, so the result can be decompressed by any zstd implementation. It
+/// does not depend on the number of threads. Smaller inputs are compressed
+/// exactly like compress() does.
+Error compressParallel(StringRef InputBuffer,
+                       SmallVectorImpl<char> &CompressedBuffer,
+                       int Level = DefaultCompression);
+
+Error uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                 size_t &UncompressedSize);
+
+Error uncompress(StringRef InputBuffer,
+                 SmallVectorImpl<char> &UncompressedBuffer,
+                 size_t UncompressedSize);
+
+} // End of namespace zstd
+
 } // End of namespace llvm
 
 #endif
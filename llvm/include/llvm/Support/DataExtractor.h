@@ -9,6 +9,7 @@
 #ifndef LLVM_SUPPORT_DATAEXTRACTOR_H
 #define LLVM_SUPPORT_DATAEXTRACTOR_H
 
+#include "llvm/ADT/ArrayRef.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Support/DataTypes.h"
 #include "llvm/Support/Error.h"
@@ -647,6 +648,36 @@ public:
   /// state, zero is returned.
   uint64_t getULEB128(Cursor &C) const { return getULEB128(&C.Offset, &C.Err); }
 
+  /// Extract consecutive unsigned LEB128 values from \a *OffsetPtr.
+  ///
+  /// Extracts as many unsigned LEB128 numbers as \a Values holds, starting
+  /// at the offset pointed to by \a OffsetPtr, which is advanced past the
+  /// last value on success. This is faster than extracting the values one
+  /// by one.
+  ///
+  /// @param[in,out] OffsetPtr
+  ///     A pointer to an offset within the data. If any of the values cannot
+  ///     be extracted, the offset is left unmodified and all values are set
+  ///     to zero.
+  ///
+  /// @param[out] Values
+  ///     The array to store the extracted values into.
+  ///
+  /// @param[in,out] Err
+  ///     A pointer to an Error object. Upon return the Error object is set to
+  ///     indicate the result (success/failure) of the function. If the Error
+  ///     object is already set when calling this function, no extraction is
+  ///     performed.
+  void getULEB128(uint64_t *OffsetPtr, MutableArrayRef<uint64_t> Values,
+                  Error *Err = nullptr) const;
+
+  /// Extract consecutive unsigned LEB128 values from the location given by
+  /// the cursor. In case of an extraction error, or if the cursor is already
+  /// in an error state, all values are set to zero.
+  void getULEB128(Cursor &C, MutableArrayRef<uint64_t> Values) const {
+    getULEB128(&C.Offset, Values, &C.Err);
+  }
+
   /// Advance the Cursor position by the given number of bytes. No-op if the
   /// cursor is in an error state.
   void skip(Cursor &C, uint64_t Length) const;
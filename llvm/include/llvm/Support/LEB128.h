@@ -14,6 +14,8 @@
 #ifndef LLVM_SUPPORT_LEB128_H
 #define LLVM_SUPPORT_LEB128_H
 
+#include "llvm/Support/Endian.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/raw_ostream.h"
 
 namespace llvm {
@@ -124,6 +126,32 @@ inline unsigned encodeULEB128(uint64_t Value, uint8_t *p,
   return (unsigned)(p - orig_p);
 }
 
+namespace detail {
+
+/// Decode a LEB128 value of at most 8 bytes a word at a time. \p p must point
+/// to at least 8 readable bytes. Returns the length of the encoding and sets
+/// \p Value to the concatenated 7-bit groups, or returns 0 if the encoding is
+/// longer than 8 bytes.
+inline unsigned decodeLEB128Word(const uint8_t *p, uint64_t &Value) {
+  uint64_t Word = support::endian::read64le(p);
+  // The first byte without a continuation bit ends the encoding.
+  uint64_t Ends = ~Word & 0x8080808080808080ULL;
+  if (!Ends)
+    return 0;
+  unsigned Length = countTrailingZeros(Ends) / 8 + 1;
+  if (Length < 8)
+    Word &= (uint64_t(1) << (8 * Length)) - 1;
+  // Drop the continuation bits and pack the 7-bit groups, doubling the width
+  // of the packed fields at each step.
+  Word = (Word & 0x007f007f007f007fULL) | ((Word & 0x7f007f007f007f00ULL) >> 1);
+  Word = (Word & 0x00003fff00003fffULL) | ((Word & 0x3fff00003fff0000ULL) >> 2);
+  Word = (Word & 0x000000000fffffffULL) | ((Word & 0x0fffffff00000000ULL) >> 4);
+  Value = Word;
+  return Length;
+}
+
+} // namespace detail
+
 /// Utility function to decode a ULEB128 value.
 inline uint64_t decodeULEB128(const uint8_t *p, unsigned *n = nullptr,
                               const uint8_t *end = nullptr,
@@ -133,6 +161,26 @@ inline uint64_t decodeULEB128(const uint8_t *p, unsigned *n = nullptr,
   unsigned Shift = 0;
   if (error)
     *error = nullptr;
+  // Most values fit into one or two bytes. Longer values of up to 8 bytes,
+  // which cannot overflow, are decoded a word at a time when the bounds allow
+  // it.
+  if (p != end && *p < 128) {
+    if (n)
+      *n = 1;
+    return *p;
+  }
+  if (end && end - p >= 8) {
+    if (p[1] < 128) {
+      if (n)
+        *n = 2;
+      return (p[0] & 0x7f) | (uint64_t(p[1]) << 7);
+    }
+    if (unsigned Length = detail::decodeLEB128Word(p, Value)) {
+      if (n)
+        *n = Length;
+      return Value;
+    }
+  }
   do {
     if (p == end) {
       if (error)
@@ -167,6 +215,21 @@ inline int64_t decodeSLEB128(const uint8_t *p, unsigned *n = nullptr,
   uint8_t Byte;
   if (error)
     *error = nullptr;
+  // Fast paths as in decodeULEB128(), sign extending from the last group.
+  if (p != end && *p < 128) {
+    if (n)
+      *n = 1;
+    return int64_t(uint64_t(*p) << 57) >> 57;
+  }
+  if (end && end - p >= 8) {
+    uint64_t Bits;
+    if (unsigned Length = detail::decodeLEB128Word(p, Bits)) {
+      if (n)
+        *n = Length;
+      unsigned Unused = 64 - 7 * Length;
+      return int64_t(Bits << Unused) >> Unused;
+    }
+  }
   do {
     if (p == end) {
       if (error)
@@ -197,6 +260,27 @@ inline int64_t decodeSLEB128(const uint8_t *p, unsigned *n = nullptr,
   return Value;
 }
 
+/// Utility function to decode \p Count consecutive ULEB128 values into
+/// \p Values. Returns the number of bytes read. If a value is malformed,
+/// \p error is set, decoding stops and the returned size covers the values
+/// decoded before it.
+inline uint64_t decodeULEB128Values(const uint8_t *p, const uint8_t *end,
+                                    uint64_t *Values, size_t Count,
+                                    const char **error = nullptr) {
+  const uint8_t *orig_p = p;
+  const char *Err = nullptr;
+  for (size_t I = 0; I != Count; ++I) {
+    unsigned Length;
+    Values[I] = decodeULEB128(p, &Length, end, &Err);
+    if (Err)
+      break;
+    p += Length;
+  }
+  if (error)
+    *error = Err;
+  return p - orig_p;
+}
+
 /// Utility function to get the size of the ULEB128-encoded value.
 extern unsigned getULEB128Size(uint64_t Value);
 
@@ -8,7 +8,6 @@
 
 #include "llvm/DWARFLinker/DWARFLinker.h"
 #include "llvm/ADT/ArrayRef.h"
-#include "llvm/ADT/BitVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/Triple.h"
 #include "llvm/CodeGen/NonRelocatableStringpool.h"
@@ -59,6 +58,20 @@ static CompileUnit *getUnitForOffset(const UnitListTy &Units, uint64_t Offset) {
   return CU != Units.end() ? CU->get() : nullptr;
 }
 
+/// Find the DIE at \p RefOffset in \p Units and store its unit into \p
+/// RefCU. \returns null if there is none.
+static DWARFDie getReferencedDIE(const UnitListTy &Units, uint64_t RefOffset,
+                                 CompileUnit *&RefCU) {
+  if ((RefCU = getUnitForOffset(Units, RefOffset)))
+    if (const auto RefDie = RefCU->getOrigUnit().getDIEForOffset(RefOffset)) {
+      // In a file with broken references, an attribute might point to a NULL
+      // DIE.
+      if (!RefDie.isNULL())
+        return RefDie;
+    }
+  return DWARFDie();
+}
+
 /// Resolve the DIE attribute reference that has been extracted in \p RefValue.
 /// The resulting DIE might be in another CompileUnit which is stored into \p
 /// ReferencedCU. \returns null if resolving fails for any reason.
@@ -68,14 +81,9 @@ DWARFDie DWARFLinker::resolveDIEReference(const DWARFFile &File,
                                           const DWARFDie &DIE,
                                           CompileUnit *&RefCU) {
   assert(RefValue.isFormClass(DWARFFormValue::FC_Reference));
-  uint64_t RefOffset = *RefValue.getAsReference();
-  if ((RefCU = getUnitForOffset(Units, RefOffset)))
-    if (const auto RefDie = RefCU->getOrigUnit().getDIEForOffset(RefOffset)) {
-      // In a file with broken references, an attribute might point to a NULL
-      // DIE.
-      if (!RefDie.isNULL())
-        return RefDie;
-    }
+  if (DWARFDie RefDie =
+          getReferencedDIE(Units, *RefValue.getAsReference(), RefCU))
+    return RefDie;
 
   reportWarning("could not find referenced DIE", File, &DIE);
   return DWARFDie();
@@ -203,16 +211,19 @@ static void resolveRelativeObjectPath(SmallVectorImpl<char> &Buf, DWARFDie CU) {
   sys::path::append(Buf, dwarf::toString(CU.find(dwarf::DW_AT_comp_dir), ""));
 }
 
+/// Callback receiving the name, path and resolved path of a parseable Swift
+/// interface referenced by a DW_TAG_module DIE.
+using SwiftInterfaceHandler = std::function<void(
+    StringRef Name, StringRef Path, StringRef ResolvedPath, const DWARFDie &)>;
+
 /// Collect references to parseable Swift interfaces in imported
 /// DW_TAG_module blocks.
-static void analyzeImportedModule(
-    const DWARFDie &DIE, CompileUnit &CU,
-    swiftInterfacesMap *ParseableSwiftInterfaces,
-    std::function<void(const Twine &, const DWARFDie &)> ReportWarning) {
+static void analyzeImportedModule(const DWARFDie &DIE, CompileUnit &CU,
+                                  const SwiftInterfaceHandler &AddInterface) {
   if (CU.getLanguage() != dwarf::DW_LANG_Swift)
     return;
 
-  if (!ParseableSwiftInterfaces)
+  if (!AddInterface)
     return;
 
   StringRef Path = dwarf::toStringRef(DIE.find(dwarf::DW_AT_LLVM_include_path));
@@ -227,18 +238,13 @@ static void analyzeImportedModule(
   Optional<const char*> Name = dwarf::toString(DIE.find(dwarf::DW_AT_name));
   if (!Name)
     return;
-  auto &Entry = (*ParseableSwiftInterfaces)[*Name];
   // The prepend path is applied later when copying.
   DWARFDie CUDie = CU.getOrigUnit().getUnitDIE();
   SmallString<128> ResolvedPath;
   if (sys::path::is_relative(Path))
     resolveRelativeObjectPath(ResolvedPath, CUDie);
   sys::path::append(ResolvedPath, Path);
-  if (!Entry.empty() && Entry != ResolvedPath)
-    ReportWarning(Twine("Conflicting parseable interfaces for Swift Module ") +
-                      *Name + ": " + Entry + " and " + Path,
-                  DIE);
-  Entry = std::string(ResolvedPath.str());
+  AddInterface(*Name, Path, ResolvedPath, DIE);
 }
 
 /// The distinct types of work performed by the work loop in
@@ -310,12 +316,12 @@ static void updateChildPruning(const DWARFDie &Die, CompileUnit &CU,
 /// \return true when this DIE and all of its children are only
 /// forward declarations to types defined in external clang modules
 /// (i.e., forward declarations that are children of a DW_TAG_module).
-static bool analyzeContextInfo(
-    const DWARFDie &DIE, unsigned ParentIdx, CompileUnit &CU,
-    DeclContext *CurrentDeclContext, DeclContextTree &Contexts,
-    uint64_t ModulesEndOffset, swiftInterfacesMap *ParseableSwiftInterfaces,
-    std::function<void(const Twine &, const DWARFDie &)> ReportWarning,
-    bool InImportedModule = false) {
+static bool analyzeContextInfo(const DWARFDie &DIE, unsigned ParentIdx,
+                               CompileUnit &CU, DeclContext *CurrentDeclContext,
+                               DeclContextTree &Contexts,
+                               uint64_t ModulesEndOffset,
+                               const SwiftInterfaceHandler &AddSwiftInterface,
+                               bool InImportedModule = false) {
   // LIFO work list.
   std::vector<ContextWorklistItem> Worklist;
   Worklist.emplace_back(DIE, CurrentDeclContext, ParentIdx, InImportedModule);
@@ -355,8 +361,7 @@ static bool analyzeContextInfo(
         dwarf::toString(Current.Die.find(dwarf::DW_AT_name), "") !=
             CU.getClangModuleName()) {
       Current.InImportedModule = true;
-      analyzeImportedModule(Current.Die, CU, ParseableSwiftInterfaces,
-                            ReportWarning);
+      analyzeImportedModule(Current.Die, CU, AddSwiftInterface);
     }
 
     Info.ParentIdx = Current.ParentIdx;
@@ -369,7 +374,7 @@ static bool analyzeContextInfo(
         Info.Ctxt =
             PtrInvalidPair.getInt() ? nullptr : PtrInvalidPair.getPointer();
         if (Info.Ctxt)
-          Info.Ctxt->setDefinedInClangModule(InClangModule);
+          Info.Ctxt->setDefinedInClangModule(InClangModule, CU);
       } else
         Info.Ctxt = Current.Context = nullptr;
     }
@@ -850,18 +855,38 @@ unsigned DWARFLinker::DIECloner::cloneStringAttribute(
   if (!String)
     return 0;
 
+  if (Pending) {
+    // The string offsets are handed out in cloning order.
+    PendingValue V(PendingValue::String);
+    V.Slot = Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
+                          dwarf::DW_FORM_strp, DIEInteger(0));
+    V.Attr = dwarf::Attribute(AttrSpec.Attr);
+    V.Str = *String;
+    Pending->Values.push_back(std::move(V));
+    return 4;
+  }
+
+  return setStringAttribute(Die, DIE::value_iterator(),
+                            dwarf::Attribute(AttrSpec.Attr), *String,
+                            StringPool, Info);
+}
+
+unsigned DWARFLinker::DIECloner::setStringAttribute(
+    DIE &Die, DIE::value_iterator Slot, dwarf::Attribute Attr,
+    const char *String, OffsetsStringPool &StringPool, AttributesInfo &Info) {
   // Switch everything to out of line strings.
-  auto StringEntry = StringPool.getEntry(*String);
+  auto StringEntry = StringPool.getEntry(String);
 
   // Update attributes info.
-  if (AttrSpec.Attr == dwarf::DW_AT_name)
+  if (Attr == dwarf::DW_AT_name)
     Info.Name = StringEntry;
-  else if (AttrSpec.Attr == dwarf::DW_AT_MIPS_linkage_name ||
-           AttrSpec.Attr == dwarf::DW_AT_linkage_name)
+  else if (Attr == dwarf::DW_AT_MIPS_linkage_name ||
+           Attr == dwarf::DW_AT_linkage_name)
     Info.MangledName = StringEntry;
 
-  Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr), dwarf::DW_FORM_strp,
-               DIEInteger(StringEntry.getOffset()));
+  setValue(Die, Slot,
+           DIEValue(Attr, dwarf::DW_FORM_strp,
+                    DIEInteger(StringEntry.getOffset())));
 
   return 4;
 }
@@ -870,70 +895,97 @@ unsigned DWARFLinker::DIECloner::cloneDieReferenceAttribute(
     DIE &Die, const DWARFDie &InputDIE, AttributeSpec AttrSpec,
     unsigned AttrSize, const DWARFFormValue &Val, const DWARFFile &File,
     CompileUnit &Unit) {
-  const DWARFUnit &U = Unit.getOrigUnit();
-  uint64_t Ref = *Val.getAsReference();
-
-  DIE *NewRefDie = nullptr;
   CompileUnit *RefUnit = nullptr;
-  DeclContext *Ctxt = nullptr;
-
   DWARFDie RefDie =
-      Linker.resolveDIEReference(File, CompileUnits, Val, InputDIE, RefUnit);
+      getReferencedDIE(CompileUnits, *Val.getAsReference(), RefUnit);
+  if (!RefDie)
+    reportWarning("could not find referenced DIE", File, &InputDIE);
 
   // If the referenced DIE is not found,  drop the attribute.
   if (!RefDie || AttrSpec.Attr == dwarf::DW_AT_sibling)
     return 0;
 
-  CompileUnit::DIEInfo &RefInfo = RefUnit->getInfo(RefDie);
+  if (Pending) {
+    // Whether the referenced DIE has been cloned, or has a canonical DIE,
+    // and its offset depend on the units cloned before. The form and size
+    // of the attribute are only known once that is decided.
+    PendingValue V(PendingValue::Reference);
+    V.Slot = Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
+                          dwarf::Form(AttrSpec.Form), DIEInteger(0));
+    V.Attr = dwarf::Attribute(AttrSpec.Attr);
+    V.Form = dwarf::Form(AttrSpec.Form);
+    V.Size = AttrSize;
+    V.RefDie = RefDie;
+    V.RefUnit = RefUnit;
+    Pending->Values.push_back(std::move(V));
+    return 0;
+  }
+
+  return cloneResolvedReference(Die, DIE::value_iterator(), InputDIE,
+                                dwarf::Attribute(AttrSpec.Attr),
+                                dwarf::Form(AttrSpec.Form), AttrSize, RefDie,
+                                *RefUnit, Unit);
+}
+
+unsigned DWARFLinker::DIECloner::cloneResolvedReference(
+    DIE &Die, DIE::value_iterator Slot, const DWARFDie &InputDIE,
+    dwarf::Attribute Attr, dwarf::Form Form, unsigned AttrSize,
+    const DWARFDie &RefDie, CompileUnit &RefUnit, CompileUnit &Unit) {
+  const DWARFUnit &U = Unit.getOrigUnit();
+  uint64_t Ref = RefDie.getOffset();
+  DeclContext *Ctxt = nullptr;
+
+  CompileUnit::DIEInfo &RefInfo = RefUnit.getInfo(RefDie);
 
   // If we already have emitted an equivalent DeclContext, just point
   // at it.
-  if (isODRAttribute(AttrSpec.Attr)) {
+  if (isODRAttribute(Attr)) {
     Ctxt = RefInfo.Ctxt;
     if (Ctxt && Ctxt->getCanonicalDIEOffset()) {
-      DIEInteger Attr(Ctxt->getCanonicalDIEOffset());
-      Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
-                   dwarf::DW_FORM_ref_addr, Attr);
+      DIEInteger Value(Ctxt->getCanonicalDIEOffset());
+      setValue(Die, Slot, DIEValue(Attr, dwarf::DW_FORM_ref_addr, Value));
       return U.getRefAddrByteSize();
     }
   }
 
-  if (!RefInfo.Clone) {
+  if (!RefInfo.Cloned) {
     assert(Ref > InputDIE.getOffset());
     // We haven't cloned this DIE yet. Just create an empty one and
     // store it. It'll get really cloned when we process it.
-    RefInfo.Clone = DIE::get(DIEAlloc, dwarf::Tag(RefDie.getTag()));
+    if (!RefInfo.Clone)
+      RefInfo.Clone = DIE::get(DIEAlloc, dwarf::Tag(RefDie.getTag()));
+    RefInfo.Cloned = true;
   }
-  NewRefDie = RefInfo.Clone;
+  DIE *NewRefDie = RefInfo.Clone;
 
-  if (AttrSpec.Form == dwarf::DW_FORM_ref_addr ||
-      (Unit.hasODR() && isODRAttribute(AttrSpec.Attr))) {
+  if (Form == dwarf::DW_FORM_ref_addr ||
+      (Unit.hasODR() && isODRAttribute(Attr))) {
     // We cannot currently rely on a DIEEntry to emit ref_addr
     // references, because the implementation calls back to DwarfDebug
     // to find the unit offset. (We don't have a DwarfDebug)
     // FIXME: we should be able to design DIEEntry reliance on
     // DwarfDebug away.
-    uint64_t Attr;
+    uint64_t Value;
     if (Ref < InputDIE.getOffset()) {
       // We must have already cloned that DIE.
       uint32_t NewRefOffset =
-          RefUnit->getStartOffset() + NewRefDie->getOffset();
-      Attr = NewRefOffset;
-      Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
-                   dwarf::DW_FORM_ref_addr, DIEInteger(Attr));
+          RefUnit.getStartOffset() + NewRefDie->getOffset();
+      Value = NewRefOffset;
+      setValue(Die, Slot,
+               DIEValue(Attr, dwarf::DW_FORM_ref_addr, DIEInteger(Value)));
     } else {
       // A forward reference. Note and fixup later.
-      Attr = 0xBADDEF;
+      Value = 0xBADDEF;
       Unit.noteForwardReference(
-          NewRefDie, RefUnit, Ctxt,
-          Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
-                       dwarf::DW_FORM_ref_addr, DIEInteger(Attr)));
+          NewRefDie, &RefUnit, Ctxt,
+          setValue(Die, Slot,
+                   DIEValue(Attr, dwarf::DW_FORM_ref_addr,
+                            DIEInteger(Value))));
     }
     return U.getRefAddrByteSize();
   }
 
-  Die.addValue(DIEAlloc, dwarf::Attribute(AttrSpec.Attr),
-               dwarf::Form(AttrSpec.Form), DIEEntry(*NewRefDie));
+  setValue(Die, Slot, DIEValue(Attr, Form, DIEEntry(*NewRefDie)));
 
   return AttrSize;
 }
@@ -952,7 +1004,7 @@ void DWARFLinker::DIECloner::cloneExpression(
     auto Op1 = Description.Op[1];
     if ((Op0 == Encoding::BaseTypeRef && Op1 != Encoding::SizeNA) ||
         (Op1 == Encoding::BaseTypeRef && Op0 != Encoding::Size1))
-      Linker.reportWarning("Unsupported DW_OP encoding.", File);
+      reportWarning("Unsupported DW_OP encoding.", File);
 
     if ((Op0 == Encoding::BaseTypeRef && Op1 == Encoding::SizeNA) ||
         (Op1 == Encoding::BaseTypeRef && Op0 == Encoding::Size1)) {
@@ -970,27 +1022,24 @@ void DWARFLinker::DIECloner::cloneExpression(
         OutputBuffer.push_back(Op.getRawOperand(0));
         RefOffset = Op.getRawOperand(1);
       }
-      uint32_t Offset = 0;
+      uint8_t ULEB[16];
+      encodeULEB128(0, ULEB, ULEBsize);
       // Look up the base type. For DW_OP_convert, the operand may be 0 to
       // instead indicate the generic type. The same holds for
       // DW_OP_reinterpret, which is currently not supported.
       if (RefOffset > 0 || Op.getCode() != dwarf::DW_OP_convert) {
         auto RefDie = Unit.getOrigUnit().getDIEForOffset(RefOffset);
-        CompileUnit::DIEInfo &Info = Unit.getInfo(RefDie);
-        if (DIE *Clone = Info.Clone)
-          Offset = Clone->getOffset();
-        else
-          Linker.reportWarning(
-              "base type ref doesn't point to DW_TAG_base_type.", File);
+        if (Pending) {
+          // The offset of the base type is only known once it is placed.
+          PendingValue V(PendingValue::BaseTypeRef);
+          V.Size = ULEBsize;
+          V.ExprOffset = OutputBuffer.size();
+          V.RefDie = RefDie;
+          V.File = &File;
+          Pending->Values.push_back(std::move(V));
+        } else
+          encodeBaseTypeRef(RefDie, ULEBsize, File, Unit, ULEB);
       }
-      uint8_t ULEB[16];
-      unsigned RealSize = encodeULEB128(Offset, ULEB, ULEBsize);
-      if (RealSize > ULEBsize) {
-        // Emit the generic type as a fallback.
-        RealSize = encodeULEB128(0, ULEB, ULEBsize);
-        Linker.reportWarning("base type ref doesn't fit.", File);
-      }
-      assert(RealSize == ULEBsize && "padding failed");
       ArrayRef<uint8_t> ULEBbytes(ULEB, ULEBsize);
       OutputBuffer.append(ULEBbytes.begin(), ULEBbytes.end());
     } else {
@@ -1002,6 +1051,26 @@ void DWARFLinker::DIECloner::cloneExpression(
   }
 }
 
+void DWARFLinker::DIECloner::encodeBaseTypeRef(const DWARFDie &RefDie,
+                                              unsigned ULEBSize,
+                                              const DWARFFile &File,
+                                              CompileUnit &Unit,
+                                              uint8_t *ULEB) {
+  uint32_t Offset = 0;
+  CompileUnit::DIEInfo &Info = Unit.getInfo(RefDie);
+  if (Info.Cloned)
+    Offset = Info.Clone->getOffset();
+  else
+    reportWarning("base type ref doesn't point to DW_TAG_base_type.", File);
+  unsigned RealSize = encodeULEB128(Offset, ULEB, ULEBSize);
+  if (RealSize > ULEBSize) {
+    // Emit the generic type as a fallback.
+    RealSize = encodeULEB128(0, ULEB, ULEBSize);
+    reportWarning("base type ref doesn't fit.", File);
+  }
+  assert(RealSize == ULEBSize && "padding failed");
+}
+
 unsigned DWARFLinker::DIECloner::cloneBlockAttribute(
     DIE &Die, const DWARFFile &File, CompileUnit &Unit, AttributeSpec AttrSpec,
     const DWARFFormValue &Val, unsigned AttrSize, bool IsLittleEndian) {
@@ -1011,10 +1080,10 @@ unsigned DWARFLinker::DIECloner::cloneBlockAttribute(
   DIEBlock *Block = nullptr;
   if (AttrSpec.Form == dwarf::DW_FORM_exprloc) {
     Loc = new (DIEAlloc) DIELoc;
-    Linker.DIELocs.push_back(Loc);
+    (Pending ? Pending->DIELocs : Linker.DIELocs).push_back(Loc);
   } else {
     Block = new (DIEAlloc) DIEBlock;
-    Linker.DIEBlocks.push_back(Block);
+    (Pending ? Pending->DIEBlocks : Linker.DIEBlocks).push_back(Block);
   }
   Attr = Loc ? static_cast<DIEValueList *>(Loc)
              : static_cast<DIEValueList *>(Block);
@@ -1029,6 +1098,7 @@ unsigned DWARFLinker::DIECloner::cloneBlockAttribute(
   // If the block is a DWARF Expression, clone it into the temporary
   // buffer using cloneExpression(), otherwise copy the data directly.
   SmallVector<uint8_t, 32> Buffer;
+  size_t PendingBegin = Pending ? Pending->Values.size() : 0;
   ArrayRef<uint8_t> Bytes = *Val.getAsBlock();
   if (DWARFAttribute::mayHaveLocationExpr(AttrSpec.Attr) &&
       (Val.isFormClass(DWARFFormValue::FC_Block) ||
@@ -1041,9 +1111,21 @@ unsigned DWARFLinker::DIECloner::cloneBlockAttribute(
     cloneExpression(Data, Expr, File, Unit, Buffer);
     Bytes = Buffer;
   }
-  for (auto Byte : Bytes)
-    Attr->addValue(DIEAlloc, static_cast<dwarf::Attribute>(0),
-                   dwarf::DW_FORM_data1, DIEInteger(Byte));
+  // Point the base type references cloneExpression() left pending at their
+  // operands in the block.
+  SmallVector<PendingValue *, 1> BaseTypeRefs;
+  if (Pending)
+    for (size_t I = PendingBegin, E = Pending->Values.size(); I != E; ++I)
+      if (Pending->Values[I].Kind == PendingValue::BaseTypeRef)
+        BaseTypeRefs.push_back(&Pending->Values[I]);
+  auto NextRef = BaseTypeRefs.begin();
+  for (size_t I = 0, E = Bytes.size(); I != E; ++I) {
+    DIE::value_iterator Value =
+        Attr->addValue(DIEAlloc, static_cast<dwarf::Attribute>(0),
+                       dwarf::DW_FORM_data1, DIEInteger(Bytes[I]));
+    if (NextRef != BaseTypeRefs.end() && (*NextRef)->ExprOffset == I)
+      (*NextRef++)->Slot = Value;
+  }
 
   // FIXME: If DIEBlock and DIELoc just reuses the Size field of
   // the DIE class, this "if" could be replaced by
@@ -1080,9 +1162,9 @@ unsigned DWARFLinker::DIECloner::cloneAddressAttribute(
               ObjFile.Addresses->relocateIndexedAddr(StartOffset, EndOffset))
         Addr = *RelocAddr;
       else
-        Linker.reportWarning(toString(RelocAddr.takeError()), ObjFile);
+        reportWarning(toString(RelocAddr.takeError()), ObjFile);
     } else
-      Linker.reportWarning("no base offset for address table", ObjFile);
+      reportWarning("no base offset for address table", ObjFile);
 
     // If this is an indexed address emit the debug_info address.
     Form = dwarf::DW_FORM_addr;
@@ -1148,9 +1230,8 @@ unsigned DWARFLinker::DIECloner::cloneScalarAttribute(
     else if (auto OptionalValue = Val.getAsSectionOffset())
       Value = *OptionalValue;
     else {
-      Linker.reportWarning(
-          "Unsupported scalar attribute form. Dropping attribute.", File,
-          &InputDIE);
+      reportWarning("Unsupported scalar attribute form. Dropping attribute.",
+                    File, &InputDIE);
       return 0;
     }
     if (AttrSpec.Attr == dwarf::DW_AT_declaration && Value)
@@ -1173,9 +1254,8 @@ unsigned DWARFLinker::DIECloner::cloneScalarAttribute(
   else if (auto OptionalValue = Val.getAsUnsignedConstant())
     Value = *OptionalValue;
   else {
-    Linker.reportWarning(
-        "Unsupported scalar attribute form. Dropping attribute.", File,
-        &InputDIE);
+    reportWarning("Unsupported scalar attribute form. Dropping attribute.",
+                  File, &InputDIE);
     return 0;
   }
   PatchLocation Patch =
@@ -1247,10 +1327,10 @@ unsigned DWARFLinker::DIECloner::cloneAttribute(
     return cloneScalarAttribute(Die, InputDIE, File, Unit, AttrSpec, Val,
                                 AttrSize, Info);
   default:
-    Linker.reportWarning("Unsupported attribute form " +
-                             dwarf::FormEncodingString(AttrSpec.Form) +
-                             " in cloneAttribute. Dropping.",
-                         File, &InputDIE);
+    reportWarning("Unsupported attribute form " +
+                      dwarf::FormEncodingString(AttrSpec.Form) +
+                      " in cloneAttribute. Dropping.",
+                  File, &InputDIE);
   }
 
   return 0;
@@ -1352,19 +1432,15 @@ DIE *DWARFLinker::DIECloner::cloneDIE(const DWARFDie &InputDIE,
     if (!Info.Clone)
       Info.Clone = DIE::get(DIEAlloc, dwarf::Tag(InputDIE.getTag()));
     Die = Info.Clone;
+    // When cloning concurrently, finishDIE() marks the DIE once it is placed.
+    if (!Pending)
+      Info.Cloned = true;
   }
 
   assert(Die->getTag() == InputDIE.getTag());
-  Die->setOffset(OutOffset);
-  if ((Unit.hasODR() || Unit.isClangModule()) && !Info.Incomplete &&
-      Die->getTag() != dwarf::DW_TAG_namespace && Info.Ctxt &&
-      Info.Ctxt != Unit.getInfo(Info.ParentIdx).Ctxt &&
-      !Info.Ctxt->getCanonicalDIEOffset()) {
-    // We are about to emit a DIE that is the root of its own valid
-    // DeclContext tree. Make the current offset the canonical offset
-    // for this context.
-    Info.Ctxt->setCanonicalDIEOffset(OutOffset + Unit.getStartOffset());
-  }
+  const uint32_t DIEOffset = OutOffset;
+  if (!Pending)
+    placeDIE(*Die, Unit, Info, OutOffset);
 
   // Extract and clone every attribute.
   DWARFDataExtractor Data = U.getDebugInfoExtractor();
@@ -1410,6 +1486,7 @@ DIE *DWARFLinker::DIECloner::cloneDIE(const DWARFDie &InputDIE,
   // Reset the Offset to 0 as we will be working on the local copy of
   // the data.
   Offset = 0;
+  size_t PendingBegin = Pending ? Pending->Values.size() : 0;
 
   const auto *Abbrev = InputDIE.getAbbreviationDeclarationPtr();
   Offset += getULEB128Size(Abbrev->getCode());
@@ -1448,6 +1525,73 @@ DIE *DWARFLinker::DIECloner::cloneDIE(const DWARFDie &InputDIE,
                                 AttrSpec, AttrSize, AttrInfo, IsLittleEndian);
   }
 
+  // Determine whether there are any children that we want to keep.
+  bool HasChildren = false;
+  for (auto Child : InputDIE.children()) {
+    unsigned Idx = U.getDIEIndex(Child);
+    if (Unit.getInfo(Idx).Keep) {
+      HasChildren = true;
+      break;
+    }
+  }
+
+  if (Pending) {
+    // Placing the DIE, its accelerator entries and its abbreviation depend
+    // on the units cloned before, finishDIE() does them in cloning order.
+    Pending->DIEs.push_back({InputDIE, Die, AttrInfo, OutOffset - DIEOffset,
+                             HasChildren, PendingBegin,
+                             Pending->Values.size()});
+    for (auto Child : InputDIE.children())
+      if (DIE *Clone = cloneDIE(Child, File, Unit, StringPool, PCOffset, 0,
+                                Flags, IsLittleEndian))
+        Die->addChild(Clone);
+    return Die;
+  }
+
+  addAccelerators(InputDIE, Die, File, Unit, StringPool, Info, AttrInfo);
+  OutOffset += assignAbbrevNumber(*Die, HasChildren);
+
+  if (!HasChildren) {
+    // Update our size.
+    Die->setSize(OutOffset - Die->getOffset());
+    return Die;
+  }
+
+  // Recursively clone children.
+  for (auto Child : InputDIE.children()) {
+    if (DIE *Clone = cloneDIE(Child, File, Unit, StringPool, PCOffset,
+                              OutOffset, Flags, IsLittleEndian)) {
+      Die->addChild(Clone);
+      OutOffset = Clone->getOffset() + Clone->getSize();
+    }
+  }
+
+  // Account for the end of children marker.
+  OutOffset += sizeof(int8_t);
+  // Update our size.
+  Die->setSize(OutOffset - Die->getOffset());
+  return Die;
+}
+
+void DWARFLinker::DIECloner::placeDIE(DIE &Die, CompileUnit &Unit,
+                                      CompileUnit::DIEInfo &Info,
+                                      uint32_t OutOffset) {
+  Die.setOffset(OutOffset);
+  if ((Unit.hasODR() || Unit.isClangModule()) && !Info.Incomplete &&
+      Die.getTag() != dwarf::DW_TAG_namespace && Info.Ctxt &&
+      Info.Ctxt != Unit.getInfo(Info.ParentIdx).Ctxt &&
+      !Info.Ctxt->getCanonicalDIEOffset()) {
+    // We are about to emit a DIE that is the root of its own valid
+    // DeclContext tree. Make the current offset the canonical offset
+    // for this context.
+    Info.Ctxt->setCanonicalDIEOffset(OutOffset + Unit.getStartOffset());
+  }
+}
+
+void DWARFLinker::DIECloner::addAccelerators(
+    const DWARFDie &InputDIE, const DIE *Die, const DWARFFile &File,
+    CompileUnit &Unit, OffsetsStringPool &StringPool,
+    const CompileUnit::DIEInfo &Info, AttributesInfo &AttrInfo) {
   // Look for accelerator entries.
   uint16_t Tag = InputDIE.getTag();
   // FIXME: This is slightly wrong. An inline_subroutine without a
@@ -1490,47 +1634,112 @@ DIE *DWARFLinker::DIECloner::cloneDIE(const DWARFDie &InputDIE,
     Unit.addTypeAccelerator(Die, AttrInfo.Name, ObjCClassIsImplementation,
                             Hash);
   }
+}
 
-  // Determine whether there are any children that we want to keep.
-  bool HasChildren = false;
-  for (auto Child : InputDIE.children()) {
-    unsigned Idx = U.getDIEIndex(Child);
-    if (Unit.getInfo(Idx).Keep) {
-      HasChildren = true;
-      break;
-    }
-  }
-
-  DIEAbbrev NewAbbrev = Die->generateAbbrev();
+unsigned DWARFLinker::DIECloner::assignAbbrevNumber(DIE &Die,
+                                                    bool HasChildren) {
+  DIEAbbrev NewAbbrev = Die.generateAbbrev();
   if (HasChildren)
     NewAbbrev.setChildrenFlag(dwarf::DW_CHILDREN_yes);
   // Assign a permanent abbrev number
   Linker.assignAbbrev(NewAbbrev);
-  Die->setAbbrevNumber(NewAbbrev.getNumber());
+  Die.setAbbrevNumber(NewAbbrev.getNumber());
 
   // Add the size of the abbreviation number to the output offset.
-  OutOffset += getULEB128Size(Die->getAbbrevNumber());
+  return getULEB128Size(Die.getAbbrevNumber());
+}
 
-  if (!HasChildren) {
-    // Update our size.
-    Die->setSize(OutOffset - Die->getOffset());
-    return Die;
-  }
+void DWARFLinker::DIECloner::finishUnit(PendingUnit &P, const DWARFFile &File,
+                                        CompileUnit &Unit,
+                                        OffsetsStringPool &StringPool,
+                                        uint32_t OutOffset) {
+  size_t Idx = 0;
+  finishDIE(P, Idx, File, Unit, StringPool, OutOffset);
+  assert(Idx == P.DIEs.size() && "DIEs left unplaced");
+}
 
-  // Recursively clone children.
-  for (auto Child : InputDIE.children()) {
-    if (DIE *Clone = cloneDIE(Child, File, Unit, StringPool, PCOffset,
-                              OutOffset, Flags, IsLittleEndian)) {
-      Die->addChild(Clone);
-      OutOffset = Clone->getOffset() + Clone->getSize();
+uint32_t DWARFLinker::DIECloner::finishDIE(PendingUnit &P, size_t &Idx,
+                                           const DWARFFile &File,
+                                           CompileUnit &Unit,
+                                           OffsetsStringPool &StringPool,
+                                           uint32_t OutOffset) {
+  // This does what cloneDIE() does when cloning serially, in the same order.
+  PendingDIE &D = P.DIEs[Idx++];
+  DIE &Die = *D.Die;
+  CompileUnit::DIEInfo &Info = Unit.getInfo(D.InputDIE);
+  if (Info.Clone == &Die)
+    Info.Cloned = true;
+  placeDIE(Die, Unit, Info, OutOffset);
+
+  OutOffset += D.AttrSize;
+  for (size_t I = D.ValuesBegin; I != D.ValuesEnd; ++I)
+    OutOffset += finishValue(P.Values[I], D, Unit, StringPool);
+
+  addAccelerators(D.InputDIE, &Die, File, Unit, StringPool, Info, D.AttrInfo);
+  OutOffset += assignAbbrevNumber(Die, D.HasChildren);
+
+  if (D.HasChildren) {
+    for (DIE &Child : Die.children()) {
+      assert(P.DIEs[Idx].Die == &Child && "DIEs recorded out of order");
+      (void)Child;
+      OutOffset = finishDIE(P, Idx, File, Unit, StringPool, OutOffset);
     }
+    // Account for the end of children marker.
+    OutOffset += sizeof(int8_t);
   }
 
-  // Account for the end of children marker.
-  OutOffset += sizeof(int8_t);
-  // Update our size.
-  Die->setSize(OutOffset - Die->getOffset());
-  return Die;
+  Die.setSize(OutOffset - Die.getOffset());
+  return OutOffset;
+}
+
+unsigned DWARFLinker::DIECloner::finishValue(PendingValue &V, PendingDIE &D,
+                                             CompileUnit &Unit,
+                                             OffsetsStringPool &StringPool) {
+  switch (V.Kind) {
+  case PendingValue::String:
+    return setStringAttribute(*D.Die, V.Slot, V.Attr, V.Str, StringPool,
+                              D.AttrInfo);
+  case PendingValue::Reference:
+    return cloneResolvedReference(*D.Die, V.Slot, D.InputDIE, V.Attr, V.Form,
+                                  V.Size, V.RefDie, *V.RefUnit, Unit);
+  case PendingValue::BaseTypeRef: {
+    uint8_t ULEB[16];
+    encodeBaseTypeRef(V.RefDie, V.Size, *V.File, Unit, ULEB);
+    DIE::value_iterator Byte = V.Slot;
+    for (unsigned I = 0; I != V.Size; ++I, ++Byte)
+      *Byte = DIEValue(static_cast<dwarf::Attribute>(0), dwarf::DW_FORM_data1,
+                       DIEInteger(ULEB[I]));
+    return 0;
+  }
+  case PendingValue::Warning:
+    Linker.reportWarning(V.Message, *V.File, V.RefDie ? &V.RefDie : nullptr);
+    return 0;
+  }
+  llvm_unreachable("unknown pending value");
+}
+
+DIE::value_iterator DWARFLinker::DIECloner::setValue(DIE &Die,
+                                                     DIE::value_iterator Slot,
+                                                     const DIEValue &Value) {
+  if (!Slot)
+    return Die.addValue(DIEAlloc, Value);
+  *Slot = Value;
+  return Slot;
+}
+
+void DWARFLinker::DIECloner::reportWarning(const Twine &Warning,
+                                           const DWARFFile &File,
+                                           const DWARFDie *DIE) {
+  if (!Pending)
+    return Linker.reportWarning(Warning, File, DIE);
+
+  // Report the warning in cloning order.
+  PendingValue V(PendingValue::Warning);
+  V.File = &File;
+  V.Message = Warning.str();
+  if (DIE)
+    V.RefDie = *DIE;
+  Pending->Values.push_back(std::move(V));
 }
 
 /// Patch the input object file relevant debug_ranges entries
@@ -2108,11 +2317,14 @@ Error DWARFLinker::loadClangModule(
       // Add this module.
       Unit = std::make_unique<CompileUnit>(*CU, UnitID++, !Options.NoODR,
                                            ModuleName);
+      SwiftInterfaceHandler AddSwiftInterface;
+      if (Options.ParseableSwiftInterfaces)
+        AddSwiftInterface = [&](StringRef Name, StringRef Path,
+                                StringRef ResolvedPath, const DWARFDie &DIE) {
+          addSwiftInterface(File, Name, Path, ResolvedPath, DIE);
+        };
       analyzeContextInfo(CUDie, 0, *Unit, &ODRContexts.getRoot(), ODRContexts,
-                         ModulesEndOffset, Options.ParseableSwiftInterfaces,
-                         [&](const Twine &Warning, const DWARFDie &DIE) {
-                           reportWarning(Warning, File, &DIE);
-                         });
+                         ModulesEndOffset, AddSwiftInterface);
       // Keep everything.
       Unit->markEverythingAsKept();
     }
@@ -2137,12 +2349,40 @@ Error DWARFLinker::loadClangModule(
 
 uint64_t DWARFLinker::DIECloner::cloneAllCompileUnits(
     DWARFContext &DwarfContext, const DWARFFile &File,
-    OffsetsStringPool &StringPool, bool IsLittleEndian) {
+    OffsetsStringPool &StringPool, bool IsLittleEndian, ThreadPool *Pool) {
   uint64_t OutputDebugInfoSize =
       Linker.Options.NoOutput ? 0 : Emitter->getDebugInfoSectionSize();
   const uint64_t StartOutputDebugInfoSize = OutputDebugInfoSize;
 
-  for (auto &CurrentUnit : CompileUnits) {
+  // Most of cloning a unit only depends on the unit, so the units are cloned
+  // concurrently into their own DIE trees. What depends on the units cloned
+  // before, which are the offsets of the DIEs and the canonical DIEs of
+  // their DeclContexts, the string offsets, the abbreviation numbers and the
+  // references, is left pending. It is then set by a serial pass in unit
+  // order, which does what cloning serially does in the same order.
+  std::vector<PendingUnit> PendingUnits;
+  if (Pool && CompileUnits.size() > 1) {
+    PendingUnits.resize(CompileUnits.size());
+    for (size_t I = 0, E = CompileUnits.size(); I != E; ++I)
+      Pool->async([&, I]() {
+        CompileUnit &Unit = *CompileUnits[I];
+        auto InputDIE = Unit.getOrigUnit().getUnitDIE();
+        if (!InputDIE || !Unit.getInfo(0).Keep)
+          return;
+        PendingUnit &P = PendingUnits[I];
+        DIECloner UnitCloner(Linker, Emitter, ObjFile, P.DIEAlloc,
+                             CompileUnits, Update);
+        UnitCloner.Pending = &P;
+        Unit.createOutputDIE();
+        UnitCloner.cloneDIE(InputDIE, File, Unit, StringPool,
+                            0 /* PC offset */, 0, 0, IsLittleEndian,
+                            Unit.getOutputUnitDIE());
+      });
+    Pool->wait();
+  }
+
+  for (size_t I = 0, E = CompileUnits.size(); I != E; ++I) {
+    auto &CurrentUnit = CompileUnits[I];
     const uint16_t DwarfVersion = CurrentUnit->getOrigUnit().getVersion();
     const uint32_t UnitHeaderSize = DwarfVersion >= 5 ? 12 : 11;
     auto InputDIE = CurrentUnit->getOrigUnit().getUnitDIE();
@@ -2152,12 +2392,17 @@ uint64_t DWARFLinker::DIECloner::cloneAllCompileUnits(
       continue;
     }
     if (CurrentUnit->getInfo(0).Keep) {
-      // Clone the InputDIE into your Unit DIE in our compile unit since it
-      // already has a DIE inside of it.
-      CurrentUnit->createOutputDIE();
-      cloneDIE(InputDIE, File, *CurrentUnit, StringPool, 0 /* PC offset */,
-               UnitHeaderSize, 0, IsLittleEndian,
-               CurrentUnit->getOutputUnitDIE());
+      if (!PendingUnits.empty()) {
+        finishUnit(PendingUnits[I], File, *CurrentUnit, StringPool,
+                   UnitHeaderSize);
+      } else {
+        // Clone the InputDIE into your Unit DIE in our compile unit since it
+        // already has a DIE inside of it.
+        CurrentUnit->createOutputDIE();
+        cloneDIE(InputDIE, File, *CurrentUnit, StringPool, 0 /* PC offset */,
+                 UnitHeaderSize, 0, IsLittleEndian,
+                 CurrentUnit->getOutputUnitDIE());
+      }
     }
 
     OutputDebugInfoSize = CurrentUnit->computeNextUnitOffset(DwarfVersion);
@@ -2212,6 +2457,15 @@ uint64_t DWARFLinker::DIECloner::cloneAllCompileUnits(
     }
   }
 
+  // The DIEs of the units cloned concurrently are freed with their
+  // allocators, once they have been emitted.
+  for (PendingUnit &P : PendingUnits) {
+    for (DIEBlock *I : P.DIEBlocks)
+      I->~DIEBlock();
+    for (DIELoc *I : P.DIELocs)
+      I->~DIELoc();
+  }
+
   return OutputDebugInfoSize - StartOutputDebugInfoSize;
 }
 
@@ -2311,6 +2565,17 @@ void DWARFLinker::copyInvariantDebugSection(DWARFContext &Dwarf) {
                                        "debug_aranges");
 }
 
+void DWARFLinker::addSwiftInterface(const DWARFFile &File, StringRef Name,
+                                    StringRef Path, StringRef ResolvedPath,
+                                    const DWARFDie &DIE) {
+  auto &Entry = (*Options.ParseableSwiftInterfaces)[std::string(Name)];
+  if (!Entry.empty() && Entry != ResolvedPath)
+    reportWarning(Twine("Conflicting parseable interfaces for Swift Module ") +
+                      Name + ": " + Entry + " and " + Path,
+                  File, &DIE);
+  Entry = std::string(ResolvedPath);
+}
+
 void DWARFLinker::addObjectFile(DWARFFile &File) {
   ObjectContexts.emplace_back(LinkContext(File));
 
@@ -2389,9 +2654,12 @@ bool DWARFLinker::link() {
     OptContext.CompileUnits.reserve(
         OptContext.File.Dwarf->getNumCompileUnits());
 
+    // Only the unit DIEs are needed here. The other DIEs are extracted when
+    // the object file is analyzed and released once it has been cloned, so
+    // that they are not all in memory at once.
     for (const auto &CU : OptContext.File.Dwarf->compile_units()) {
       updateDwarfVersion(CU->getVersion());
-      auto CUDie = CU->getUnitDIE(false);
+      auto CUDie = CU->getUnitDIE();
       if (Options.Verbose) {
         outs() << "Input compilation unit:";
         DIDumpOptions DumpOpts;
@@ -2418,15 +2686,9 @@ bool DWARFLinker::link() {
   const uint64_t ModulesEndOffset =
       Options.NoOutput ? 0 : TheDwarfEmitter->getDebugInfoSectionSize();
 
-  // These variables manage the list of processed object files.
-  // The mutex and condition variable are to ensure that this is thread safe.
-  std::mutex ProcessedFilesMutex;
-  std::condition_variable ProcessedFilesConditionVariable;
-  BitVector ProcessedFiles(NumObjects, false);
-
-  //  Analyzing the context info is particularly expensive so it is executed in
-  //  parallel with emitting the previous compile unit.
-  auto AnalyzeLambda = [&](size_t I) {
+  // Create the compile units of an object file. This hands out the unit IDs,
+  // so it is done in object order.
+  auto CreateUnitsLambda = [&](size_t I) {
     auto &Context = ObjectContexts[I];
 
     if (Context.Skip || !Context.File.Dwarf)
@@ -2449,29 +2711,39 @@ bool DWARFLinker::link() {
             *CU, UnitID++, !Options.NoODR && !Options.Update, ""));
       }
     }
+  };
+
+  // Now build the DIE parent links that we will use during the next phase.
+  // Analyzing the context info is particularly expensive. It only touches the
+  // units of the object file and the ODR contexts, which can be shared, so
+  // object files can be analyzed concurrently.
+  auto AnalyzeLambda = [&](size_t I,
+                           const SwiftInterfaceHandler &AddSwiftInterface) {
+    auto &Context = ObjectContexts[I];
+
+    if (Context.Skip || !Context.File.Dwarf)
+      return;
 
-    // Now build the DIE parent links that we will use during the next phase.
     for (auto &CurrentUnit : Context.CompileUnits) {
       auto CUDie = CurrentUnit->getOrigUnit().getUnitDIE();
       if (!CUDie)
         continue;
       analyzeContextInfo(CurrentUnit->getOrigUnit().getUnitDIE(), 0,
                          *CurrentUnit, &ODRContexts.getRoot(), ODRContexts,
-                         ModulesEndOffset, Options.ParseableSwiftInterfaces,
-                         [&](const Twine &Warning, const DWARFDie &DIE) {
-                           reportWarning(Warning, Context.File, &DIE);
-                         });
+                         ModulesEndOffset, AddSwiftInterface);
     }
   };
 
   // For each object file map how many bytes were emitted.
   StringMap<DebugInfoSize> SizeByObject;
 
-  // And then the remaining work in serial again.
-  // Note, although this loop runs in serial, it can run in parallel with
-  // the analyzeContextInfo loop so long as we process files with indices >=
-  // than those processed by analyzeContextInfo.
-  auto CloneLambda = [&](size_t I) {
+  // And then the remaining work in serial again. Which object file emits the
+  // canonical copy of an ODR type, the string offsets and the abbreviation
+  // numbers all depend on the order in which object files are cloned, so this
+  // is always done in object order, once analysis has completed. The units of
+  // an object file are cloned concurrently on the thread pool, if there is one,
+  // and then placed in unit order.
+  auto CloneLambda = [&](size_t I, ThreadPool *Pool) {
     auto &OptContext = ObjectContexts[I];
     if (OptContext.Skip || !OptContext.File.Dwarf)
       return;
@@ -2506,7 +2778,8 @@ bool DWARFLinker::link() {
                     OptContext.CompileUnits, Options.Update)
               .cloneAllCompileUnits(*OptContext.File.Dwarf, OptContext.File,
                                     OffsetsStringPool,
-                                    OptContext.File.Dwarf->isLittleEndian());
+                                    OptContext.File.Dwarf->isLittleEndian(),
+                                    Pool);
     }
     if (!Options.NoOutput && !OptContext.CompileUnits.empty() &&
         LLVM_LIKELY(!Options.Update))
@@ -2517,6 +2790,7 @@ bool DWARFLinker::link() {
 
     // Clean-up before starting working on the next object.
     cleanupAuxiliarryData(OptContext);
+    OptContext.File.Dwarf->releaseDIEs();
   };
 
   auto EmitLambda = [&]() {
@@ -2544,45 +2818,106 @@ bool DWARFLinker::link() {
     }
   };
 
-  auto AnalyzeAll = [&]() {
-    for (unsigned I = 0, E = NumObjects; I != E; ++I) {
-      AnalyzeLambda(I);
-
-      std::unique_lock<std::mutex> LockGuard(ProcessedFilesMutex);
-      ProcessedFiles.set(I);
-      ProcessedFilesConditionVariable.notify_one();
-    }
-  };
-
-  auto CloneAll = [&]() {
-    for (unsigned I = 0, E = NumObjects; I != E; ++I) {
-      {
-        std::unique_lock<std::mutex> LockGuard(ProcessedFilesMutex);
-        if (!ProcessedFiles[I]) {
-          ProcessedFilesConditionVariable.wait(
-              LockGuard, [&]() { return ProcessedFiles[I]; });
-        }
-      }
-
-      CloneLambda(I);
-    }
-    EmitLambda();
-  };
-
   // To limit memory usage in the single threaded case, analyze and clone are
   // run sequentially so the OptContext is freed after processing each object
   // in endDebugObject.
   if (Options.Threads == 1) {
     for (unsigned I = 0, E = NumObjects; I != E; ++I) {
-      AnalyzeLambda(I);
-      CloneLambda(I);
+      SwiftInterfaceHandler AddSwiftInterface;
+      if (Options.ParseableSwiftInterfaces)
+        AddSwiftInterface = [&, I](StringRef Name, StringRef Path,
+                                   StringRef ResolvedPath,
+                                   const DWARFDie &DIE) {
+          addSwiftInterface(ObjectContexts[I].File, Name, Path, ResolvedPath,
+                            DIE);
+        };
+      CreateUnitsLambda(I);
+      AnalyzeLambda(I, AddSwiftInterface);
+      CloneLambda(I, nullptr);
     }
     EmitLambda();
   } else {
-    ThreadPool Pool(hardware_concurrency(2));
-    Pool.async(AnalyzeAll);
-    Pool.async(CloneAll);
-    Pool.wait();
+    ThreadPool Pool(hardware_concurrency(Options.Threads));
+
+    // The object files are processed in batches whose input .debug_info fits
+    // in the memory budget, so that only one batch worth of DIEs is in memory
+    // at any time. The batches only depend on the input, so the output does
+    // not depend on scheduling.
+    auto GetInputSize = [&](unsigned I) -> uint64_t {
+      LinkContext &Context = ObjectContexts[I];
+      if (Context.Skip || !Context.File.Dwarf)
+        return 0;
+      return getDebugInfoSize(*Context.File.Dwarf);
+    };
+
+    // The Swift interfaces found during the concurrent analysis are recorded
+    // per object file and added in object order afterwards, so that the map
+    // and the conflicts reported do not depend on scheduling.
+    struct SwiftInterface {
+      std::string Name;
+      std::string Path;
+      std::string ResolvedPath;
+      DWARFDie DIE;
+    };
+    std::vector<std::vector<SwiftInterface>> SwiftInterfaces(NumObjects);
+
+    for (unsigned Begin = 0, End = 0; Begin != NumObjects; Begin = End) {
+      uint64_t BatchSize = GetInputSize(End++);
+      while (End != NumObjects) {
+        uint64_t InputSize = GetInputSize(End);
+        if (Options.MemoryBudget &&
+            BatchSize + InputSize > Options.MemoryBudget)
+          break;
+        BatchSize += InputSize;
+        ++End;
+      }
+
+      // Extracting the DIEs and parsing the line tables is independent for
+      // each object file, so it is done on all threads before the units are
+      // created.
+      for (unsigned I = Begin; I != End; ++I) {
+        LinkContext &Context = ObjectContexts[I];
+        if (Context.Skip || !Context.File.Dwarf)
+          continue;
+        DWARFContext &Dwarf = *Context.File.Dwarf;
+        Pool.async([&Dwarf]() {
+          for (const auto &CU : Dwarf.compile_units()) {
+            CU->getUnitDIE(false);
+            Dwarf.getLineTableForUnit(CU.get());
+          }
+        });
+      }
+      Pool.wait();
+
+      for (unsigned I = Begin; I != End; ++I)
+        CreateUnitsLambda(I);
+
+      for (unsigned I = Begin; I != End; ++I)
+        Pool.async([&, I]() {
+          SwiftInterfaceHandler AddSwiftInterface;
+          if (Options.ParseableSwiftInterfaces)
+            AddSwiftInterface = [&, I](StringRef Name, StringRef Path,
+                                       StringRef ResolvedPath,
+                                       const DWARFDie &DIE) {
+              SwiftInterfaces[I].push_back(
+                  {Name.str(), Path.str(), ResolvedPath.str(), DIE});
+            };
+          AnalyzeLambda(I, AddSwiftInterface);
+        });
+      Pool.wait();
+
+      for (unsigned I = Begin; I != End; ++I) {
+        for (const SwiftInterface &Interface : SwiftInterfaces[I])
+          addSwiftInterface(ObjectContexts[I].File, Interface.Name,
+                            Interface.Path, Interface.ResolvedPath,
+                            Interface.DIE);
+        SwiftInterfaces[I].clear();
+      }
+
+      for (unsigned I = Begin; I != End; ++I)
+        CloneLambda(I, &Pool);
+    }
+    EmitLambda();
   }
 
   if (Options.Statistics) {
@@ -27,17 +27,26 @@ namespace llvm {
 ///
 /// If a context that is not a namespace appears twice in the same CU, we know
 /// it is ambiguous. Make it invalid.
+///
+/// The DIEs seen are tracked by the CU, so that CUs can be analyzed
+/// concurrently.
 bool DeclContext::setLastSeenDIE(CompileUnit &U, const DWARFDie &Die) {
-  if (LastSeenCompileUnitID == U.getUniqueID()) {
-    DWARFUnit &OrigUnit = U.getOrigUnit();
-    uint32_t FirstIdx = OrigUnit.getDIEIndex(LastSeenDIE);
-    U.getInfo(FirstIdx).Ctxt = nullptr;
-    return false;
-  }
+  uint32_t Idx = U.getOrigUnit().getDIEIndex(Die);
+  uint32_t FirstIdx = U.noteDeclContext(this, Idx);
+  if (FirstIdx == Idx)
+    return true;
+
+  U.getInfo(FirstIdx).Ctxt = nullptr;
+  return false;
+}
 
-  LastSeenCompileUnitID = U.getUniqueID();
-  LastSeenDIE = Die;
-  return true;
+void DeclContext::setDefinedInClangModule(bool Val, const CompileUnit &U) {
+  uint64_t New = (uint64_t(U.getUniqueID()) + 1) << 1 | Val;
+  uint64_t Old = DefinedInClangModule.load(std::memory_order_relaxed);
+  while ((Old == 0 || Old > New) &&
+         !DefinedInClangModule.compare_exchange_weak(
+             Old, New, std::memory_order_relaxed))
+    ;
 }
 
 PointerIntPair<DeclContext *, 1>
@@ -80,28 +89,24 @@ DeclContextTree::getChildDeclContext(DeclContext &Context, const DWARFDie &DIE,
     break;
   }
 
-  StringRef NameRef;
-  StringRef FileRef;
-
-  if (const char *LinkageName = DIE.getLinkageName())
-    NameRef = StringPool.internString(LinkageName);
-  else if (const char *ShortName = DIE.getShortName())
-    NameRef = StringPool.internString(ShortName);
-
-  bool IsAnonymousNamespace = NameRef.empty() && Tag == dwarf::DW_TAG_namespace;
-  if (IsAnonymousNamespace) {
-    // FIXME: For dsymutil-classic compatibility. I think uniquing within
-    // anonymous namespaces is wrong. There is no ODR guarantee there.
-    NameRef = "(anonymous namespace)";
-  }
+  // Everything read from the DIE is gathered before taking the lock; only
+  // the shared caches and the context map are accessed with it held.
+  const char *Name = DIE.getLinkageName();
+  if (!Name)
+    Name = DIE.getShortName();
+  bool HasName = Name && *Name;
 
+  bool IsAnonymousNamespace = !HasName && Tag == dwarf::DW_TAG_namespace;
   if (Tag != dwarf::DW_TAG_class_type && Tag != dwarf::DW_TAG_structure_type &&
       Tag != dwarf::DW_TAG_union_type &&
-      Tag != dwarf::DW_TAG_enumeration_type && NameRef.empty())
+      Tag != dwarf::DW_TAG_enumeration_type && !HasName &&
+      !IsAnonymousNamespace)
     return PointerIntPair<DeclContext *, 1>(nullptr);
 
   unsigned Line = 0;
   unsigned ByteSize = std::numeric_limits<uint32_t>::max();
+  const DWARFDebugLine::LineTable *FileLineTable = nullptr;
+  unsigned FileNum = 0;
 
   if (!InClangModule) {
     // Gather some discriminating data about the DeclContext we will be
@@ -115,8 +120,8 @@ DeclContextTree::getChildDeclContext(DeclContext &Context, const DWARFDie &DIE,
     ByteSize = dwarf::toUnsigned(DIE.find(dwarf::DW_AT_byte_size),
                                  std::numeric_limits<uint64_t>::max());
     if (Tag != dwarf::DW_TAG_namespace || IsAnonymousNamespace) {
-      if (unsigned FileNum =
-              dwarf::toUnsigned(DIE.find(dwarf::DW_AT_decl_file), 0)) {
+      FileNum = dwarf::toUnsigned(DIE.find(dwarf::DW_AT_decl_file), 0);
+      if (FileNum) {
         if (const auto *LT = U.getOrigUnit().getContext().getLineTableForUnit(
                 &U.getOrigUnit())) {
           // FIXME: dsymutil-classic compatibility. I'd rather not
@@ -127,89 +132,113 @@ DeclContextTree::getChildDeclContext(DeclContext &Context, const DWARFDie &DIE,
 
           if (LT->hasFileAtIndex(FileNum)) {
             Line = dwarf::toUnsigned(DIE.find(dwarf::DW_AT_decl_line), 0);
-            // Cache the resolved paths based on the index in the line table,
-            // because calling realpath is expensive.
-            FileRef = getResolvedPath(U, FileNum, *LT);
+            FileLineTable = LT;
           }
         }
       }
     }
   }
 
-  if (!Line && NameRef.empty())
+  if (!Line && !HasName && !IsAnonymousNamespace)
     return PointerIntPair<DeclContext *, 1>(nullptr);
 
-  // We hash NameRef, which is the mangled name, in order to get most
-  // overloaded functions resolve correctly.
-  //
-  // Strictly speaking, hashing the Tag is only necessary for a
-  // DW_TAG_module, to prevent uniquing of a module and a namespace
-  // with the same name.
-  //
-  // FIXME: dsymutil-classic won't unique the same type presented
-  // once as a struct and once as a class. Using the Tag in the fully
-  // qualified name hash to get the same effect.
-  unsigned Hash = hash_combine(Context.getQualifiedNameHash(), Tag, NameRef);
-
-  // FIXME: dsymutil-classic compatibility: when we don't have a name,
-  // use the filename.
-  if (IsAnonymousNamespace)
-    Hash = hash_combine(Hash, FileRef);
-
-  // Now look if this context already exists.
-  DeclContext Key(Hash, Line, ByteSize, Tag, NameRef, FileRef, Context);
-  auto ContextIter = Contexts.find(&Key);
-
-  if (ContextIter == Contexts.end()) {
-    // The context wasn't found.
-    bool Inserted;
-    DeclContext *NewContext =
-        new (Allocator) DeclContext(Hash, Line, ByteSize, Tag, NameRef, FileRef,
-                                    Context, DIE, U.getUniqueID());
-    std::tie(ContextIter, Inserted) = Contexts.insert(NewContext);
-    assert(Inserted && "Failed to insert DeclContext");
-    (void)Inserted;
-  } else if (Tag != dwarf::DW_TAG_namespace &&
-             !(*ContextIter)->setLastSeenDIE(U, DIE)) {
+  // Resolving the path may call realpath, so do it before taking the lock.
+  StringRef FileRef;
+  if (FileLineTable)
+    FileRef = getResolvedPath(U, FileNum, *FileLineTable);
+
+  DeclContext *Ctxt;
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+
+    StringRef NameRef;
+
+    if (IsAnonymousNamespace) {
+      // FIXME: For dsymutil-classic compatibility. I think uniquing within
+      // anonymous namespaces is wrong. There is no ODR guarantee there.
+      NameRef = "(anonymous namespace)";
+    } else if (Name) {
+      NameRef = StringPool.internString(Name);
+    }
+
+    // We hash NameRef, which is the mangled name, in order to get most
+    // overloaded functions resolve correctly.
+    //
+    // Strictly speaking, hashing the Tag is only necessary for a
+    // DW_TAG_module, to prevent uniquing of a module and a namespace
+    // with the same name.
+    //
+    // FIXME: dsymutil-classic won't unique the same type presented
+    // once as a struct and once as a class. Using the Tag in the fully
+    // qualified name hash to get the same effect.
+    unsigned Hash = hash_combine(Context.getQualifiedNameHash(), Tag, NameRef);
+
+    // FIXME: dsymutil-classic compatibility: when we don't have a name,
+    // use the filename.
+    if (IsAnonymousNamespace)
+      Hash = hash_combine(Hash, FileRef);
+
+    // Now look if this context already exists.
+    DeclContext Key(Hash, Line, ByteSize, Tag, NameRef, FileRef, Context);
+    auto ContextIter = Contexts.find(&Key);
+
+    if (ContextIter == Contexts.end()) {
+      // The context wasn't found.
+      bool Inserted;
+      DeclContext *NewContext = new (Allocator)
+          DeclContext(Hash, Line, ByteSize, Tag, NameRef, FileRef, Context);
+      std::tie(ContextIter, Inserted) = Contexts.insert(NewContext);
+      assert(Inserted && "Failed to insert DeclContext");
+      (void)Inserted;
+    }
+    Ctxt = *ContextIter;
+  }
+
+  if (Tag != dwarf::DW_TAG_namespace && !Ctxt->setLastSeenDIE(U, DIE)) {
     // The context was found, but it is ambiguous with another context
     // in the same file. Mark it invalid.
-    return PointerIntPair<DeclContext *, 1>(*ContextIter, /* IntVal= */ 1);
+    return PointerIntPair<DeclContext *, 1>(Ctxt, /* IntVal= */ 1);
   }
 
-  assert(ContextIter != Contexts.end());
   // FIXME: dsymutil-classic compatibility. Union types aren't
   // uniques, but their children might be.
   if ((Tag == dwarf::DW_TAG_subprogram &&
        Context.getTag() != dwarf::DW_TAG_structure_type &&
        Context.getTag() != dwarf::DW_TAG_class_type) ||
       (Tag == dwarf::DW_TAG_union_type))
-    return PointerIntPair<DeclContext *, 1>(*ContextIter, /* IntVal= */ 1);
+    return PointerIntPair<DeclContext *, 1>(Ctxt, /* IntVal= */ 1);
 
-  return PointerIntPair<DeclContext *, 1>(*ContextIter);
+  return PointerIntPair<DeclContext *, 1>(Ctxt);
 }
 
 StringRef
 DeclContextTree::getResolvedPath(CompileUnit &CU, unsigned FileNum,
                                  const DWARFDebugLine::LineTable &LineTable) {
+  // Cache the resolved paths based on the index in the line table,
+  // because calling realpath is expensive.
   std::pair<unsigned, unsigned> Key = {CU.getUniqueID(), FileNum};
-
-  ResolvedPathsMap::const_iterator It = ResolvedPaths.find(Key);
-  if (It == ResolvedPaths.end()) {
-    std::string FileName;
-    bool FoundFileName = LineTable.getFileNameByIndex(
-        FileNum, CU.getOrigUnit().getCompilationDir(),
-        DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, FileName);
-    (void)FoundFileName;
-    assert(FoundFileName && "Must get file name from line table");
-
-    // Second level of caching, this time based on the file's parent
-    // path.
-    StringRef ResolvedPath = PathResolver.resolve(FileName, StringPool);
-
-    It = ResolvedPaths.insert(std::make_pair(Key, ResolvedPath)).first;
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    ResolvedPathsMap::const_iterator It = ResolvedPaths.find(Key);
+    if (It != ResolvedPaths.end())
+      return It->second;
   }
 
-  return It->second;
+  std::string FileName;
+  bool FoundFileName = LineTable.getFileNameByIndex(
+      FileNum, CU.getOrigUnit().getCompilationDir(),
+      DILineInfoSpecifier::FileLineInfoKind::AbsoluteFilePath, FileName);
+  (void)FoundFileName;
+  assert(FoundFileName && "Must get file name from line table");
+
+  // Second level of caching, this time based on the file's parent
+  // path.
+  std::string ResolvedPath = PathResolver.resolve(FileName);
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  return ResolvedPaths
+      .try_emplace(Key, StringPool.internString(ResolvedPath))
+      .first->second;
 }
 
 } // namespace llvm
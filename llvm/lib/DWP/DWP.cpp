@@ -11,12 +11,18 @@
 //
 //===----------------------------------------------------------------------===//
 #include "llvm/DWP/DWP.h"
+#include "llvm/ADT/CachedHashString.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/ScopeExit.h"
 #include "llvm/DWP/DWPError.h"
+#include "llvm/MC/MCAsmInfo.h"
 #include "llvm/MC/MCContext.h"
 #include "llvm/MC/MCObjectFileInfo.h"
 #include "llvm/MC/MCTargetOptionsCommandFlags.h"
 #include "llvm/Object/Decompressor.h"
+#include "llvm/Support/EndianStream.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include "llvm/Support/Parallel.h"
 
 using namespace llvm;
 using namespace llvm::object;
@@ -465,19 +471,24 @@ Error buildDuplicateError(const std::pair<uint64_t, UnitIndexEntry> &PrevE,
       " and " + buildDWODescription(ID.Name, DWPName, ID.DWOName));
 }
 
-Error handleSection(
+} // namespace llvm
+
+// Read one input section for handleSection. Sections that are copied to the
+// output unchanged are appended to \p OtherSections instead of being emitted,
+// so that this can run before the output is written.
+static Error readSection(
     const StringMap<std::pair<MCSection *, DWARFSectionKind>> &KnownSections,
     const MCSection *StrSection, const MCSection *StrOffsetSection,
     const MCSection *TypesSection, const MCSection *CUIndexSection,
     const MCSection *TUIndexSection, const MCSection *InfoSection,
-    const SectionRef &Section, MCStreamer &Out,
+    const SectionRef &Section,
     std::deque<SmallString<32>> &UncompressedSections,
-    uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
     StringRef &CurStrSection, StringRef &CurStrOffsetSection,
     std::vector<StringRef> &CurTypesSection,
     std::vector<StringRef> &CurInfoSection, StringRef &AbbrevSection,
     StringRef &CurCUIndexSection, StringRef &CurTUIndexSection,
-    std::vector<std::pair<DWARFSectionKind, uint32_t>> &SectionLength) {
+    std::vector<std::pair<DWARFSectionKind, uint32_t>> &SectionLength,
+    std::vector<std::pair<MCSection *, StringRef>> &OtherSections) {
   if (Section.isBSS())
     return Error::success();
 
@@ -526,9 +537,200 @@ Error handleSection(
     CurTUIndexSection = Contents;
   else if (OutSection == InfoSection)
     CurInfoSection.push_back(Contents);
-  else {
-    Out.SwitchSection(OutSection);
-    Out.emitBytes(Contents);
+  else
+    OtherSections.push_back(std::make_pair(OutSection, Contents));
+  return Error::success();
+}
+
+namespace {
+// An input file, read ahead of writing the package.
+struct DWPInput {
+  OwningBinary<object::ObjectFile> Obj;
+  std::deque<SmallString<32>> UncompressedSections;
+
+  StringRef CurStrSection;
+  StringRef CurStrOffsetSection;
+  std::vector<StringRef> CurTypesSection;
+  std::vector<StringRef> CurInfoSection;
+  StringRef AbbrevSection;
+  StringRef CurCUIndexSection;
+  StringRef CurTUIndexSection;
+
+  // This maps each section contained in this file to its length.
+  // This information is later on used to calculate the contributions,
+  // i.e. offset and length, of each compile/type unit to a section.
+  std::vector<std::pair<DWARFSectionKind, uint32_t>> SectionLength;
+
+  // Sections copied to the output unchanged, in input order.
+  std::vector<std::pair<MCSection *, StringRef>> OtherSections;
+
+  // The strings this file adds to the output string section, and its string
+  // offsets section rewritten to refer to the output string section.
+  SmallString<0> NewStrings;
+  SmallString<0> StrOffsets;
+};
+
+// The strings of one input's string section, in section order.
+struct DWPInputStrings {
+  static constexpr unsigned NumShards = 64;
+
+  std::vector<CachedHashStringRef> Strings;
+  // The offset of each string in the input string section.
+  std::vector<uint64_t> InputOffsets;
+  // The offset of each string in the output string section.
+  std::vector<uint32_t> Offsets;
+  // The input and index of the first occurrence of each string.
+  std::vector<std::pair<unsigned, unsigned>> Leaders;
+  // The indexes of the strings, grouped by the shard their hash falls into.
+  std::vector<unsigned> Shards[NumShards];
+};
+} // namespace
+
+// Compute the output string section contributions and the rewritten string
+// offsets sections of all inputs. The result is the same as passing the
+// inputs to writeStringsAndOffsets one after another: each distinct string is
+// added to the end of the pool by the first input it occurs in. The strings
+// are deduplicated in shards by hash, with every shard visiting the inputs in
+// order, so that all steps can run concurrently.
+static void buildStringsAndOffsets(MutableArrayRef<DWPInput> Inputs,
+                                   support::endianness Endian) {
+  std::vector<DWPInputStrings> InputStrings(Inputs.size());
+  std::vector<uint16_t> Versions(Inputs.size());
+  auto HasStrings = [&](size_t I) {
+    const DWPInput &In = Inputs[I];
+    return !In.CurInfoSection.empty() && !In.CurStrSection.empty() &&
+           !In.CurStrOffsetSection.empty();
+  };
+  auto IsFirstOccurrence = [&](unsigned I, unsigned Index) {
+    return InputStrings[I].Leaders[Index] == std::make_pair(I, Index);
+  };
+
+  parallelForEachN(0, Inputs.size(), [&](size_t I) {
+    if (!HasStrings(I))
+      return;
+    // Inputs whose unit header cannot be parsed are diagnosed when they are
+    // written, before their strings would be used.
+    Expected<InfoSectionUnitHeader> HeaderOrErr =
+        parseInfoSectionUnitHeader(Inputs[I].CurInfoSection.front());
+    if (!HeaderOrErr) {
+      consumeError(HeaderOrErr.takeError());
+      return;
+    }
+    Versions[I] = HeaderOrErr->Version;
+
+    DWPInputStrings &S = InputStrings[I];
+    DataExtractor Data(Inputs[I].CurStrSection, true, 0);
+    uint64_t LocalOffset = 0;
+    uint64_t PrevOffset = 0;
+    while (const char *Str = Data.getCStr(&LocalOffset)) {
+      CachedHashStringRef CStr(StringRef(Str, LocalOffset - PrevOffset - 1));
+      S.Shards[CStr.hash() % DWPInputStrings::NumShards].push_back(
+          S.Strings.size());
+      S.Strings.push_back(CStr);
+      S.InputOffsets.push_back(PrevOffset);
+      PrevOffset = LocalOffset;
+    }
+    S.Offsets.resize(S.Strings.size());
+    S.Leaders.resize(S.Strings.size());
+  });
+
+  parallelForEachN(0, DWPInputStrings::NumShards, [&](size_t Shard) {
+    DenseMap<CachedHashStringRef, std::pair<unsigned, unsigned>> Pool;
+    for (unsigned I = 0, E = InputStrings.size(); I != E; ++I) {
+      DWPInputStrings &S = InputStrings[I];
+      for (unsigned Index : S.Shards[Shard])
+        S.Leaders[Index] = Pool.insert(std::make_pair(S.Strings[Index],
+                                                      std::make_pair(I, Index)))
+                               .first->second;
+    }
+  });
+
+  // Lay out the strings each input adds, relative to the start of its
+  // contribution.
+  parallelForEachN(0, Inputs.size(), [&](size_t I) {
+    DWPInputStrings &S = InputStrings[I];
+    SmallString<0> &NewStrings = Inputs[I].NewStrings;
+    for (unsigned Index = 0, E = S.Strings.size(); Index != E; ++Index) {
+      if (!IsFirstOccurrence(I, Index))
+        continue;
+      S.Offsets[Index] = NewStrings.size();
+      NewStrings += S.Strings[Index].val();
+      NewStrings.push_back('\0');
+    }
+  });
+
+  std::vector<uint32_t> Bases(Inputs.size());
+  uint32_t Offset = 0;
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    Bases[I] = Offset;
+    Offset += Inputs[I].NewStrings.size();
+  }
+
+  parallelForEachN(0, Inputs.size(), [&](size_t I) {
+    DWPInputStrings &S = InputStrings[I];
+    for (unsigned Index = 0, E = S.Strings.size(); Index != E; ++Index)
+      if (IsFirstOccurrence(I, Index))
+        S.Offsets[Index] += Bases[I];
+  });
+
+  parallelForEachN(0, Inputs.size(), [&](size_t I) {
+    if (!HasStrings(I))
+      return;
+    DWPInputStrings &S = InputStrings[I];
+    for (unsigned Index = 0, E = S.Strings.size(); Index != E; ++Index) {
+      const std::pair<unsigned, unsigned> &Leader = S.Leaders[Index];
+      if (!IsFirstOccurrence(I, Index))
+        S.Offsets[Index] = InputStrings[Leader.first].Offsets[Leader.second];
+    }
+
+    StringRef CurStrOffsetSection = Inputs[I].CurStrOffsetSection;
+    DataExtractor Data(CurStrOffsetSection, true, 0);
+    uint64_t HeaderSize = debugStrOffsetsHeaderSize(Data, Versions[I]);
+    uint64_t Offset = 0;
+    uint64_t Size = CurStrOffsetSection.size();
+    // FIXME: This can be caused by bad input and should be handled as such.
+    assert(HeaderSize <= Size &&
+           "StrOffsetSection size is less than its header");
+    raw_svector_ostream OS(Inputs[I].StrOffsets);
+    // Copy the header to the output.
+    OS << Data.getBytes(&Offset, HeaderSize);
+    while (Offset < Size) {
+      auto OldOffset = Data.getU32(&Offset);
+      // Offsets that do not start a string are mapped to zero.
+      auto It = llvm::lower_bound(S.InputOffsets, OldOffset);
+      uint32_t NewOffset = 0;
+      if (It != S.InputOffsets.end() && *It == OldOffset)
+        NewOffset = S.Offsets[It - S.InputOffsets.begin()];
+      support::endian::write<uint32_t>(OS, NewOffset, Endian);
+    }
+  });
+}
+
+namespace llvm {
+Error handleSection(
+    const StringMap<std::pair<MCSection *, DWARFSectionKind>> &KnownSections,
+    const MCSection *StrSection, const MCSection *StrOffsetSection,
+    const MCSection *TypesSection, const MCSection *CUIndexSection,
+    const MCSection *TUIndexSection, const MCSection *InfoSection,
+    const SectionRef &Section, MCStreamer &Out,
+    std::deque<SmallString<32>> &UncompressedSections,
+    uint32_t (&ContributionOffsets)[8], UnitIndexEntry &CurEntry,
+    StringRef &CurStrSection, StringRef &CurStrOffsetSection,
+    std::vector<StringRef> &CurTypesSection,
+    std::vector<StringRef> &CurInfoSection, StringRef &AbbrevSection,
+    StringRef &CurCUIndexSection, StringRef &CurTUIndexSection,
+    std::vector<std::pair<DWARFSectionKind, uint32_t>> &SectionLength) {
+  std::vector<std::pair<MCSection *, StringRef>> OtherSections;
+  if (Error Err = readSection(
+          KnownSections, StrSection, StrOffsetSection, TypesSection,
+          CUIndexSection, TUIndexSection, InfoSection, Section,
+          UncompressedSections, CurStrSection, CurStrOffsetSection,
+          CurTypesSection, CurInfoSection, AbbrevSection, CurCUIndexSection,
+          CurTUIndexSection, SectionLength, OtherSections))
+    return Err;
+  for (const auto &Other : OtherSections) {
+    Out.SwitchSection(Other.first);
+    Out.emitBytes(Other.second);
   }
   return Error::success();
 }
@@ -564,45 +766,67 @@ Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
   uint16_t Version = 0;
   uint32_t IndexVersion = 0;
 
-  DWPStringPool Strings(Out, StrSection);
-
-  SmallVector<OwningBinary<object::ObjectFile>, 128> Objects;
-  Objects.reserve(Inputs.size());
-
-  std::deque<SmallString<32>> UncompressedSections;
-
-  for (const auto &Input : Inputs) {
-    auto ErrOrObj = object::ObjectFile::createObjectFile(Input);
-    if (!ErrOrObj)
-      return ErrOrObj.takeError();
-
-    auto &Obj = *ErrOrObj->getBinary();
-    Objects.push_back(std::move(*ErrOrObj));
+  // Opening the inputs, reading and decompressing their sections, and
+  // rewriting their string offsets are independent for each input and are
+  // done according to parallel::strategy. Everything is then written in input
+  // order, so the output and the reported errors are the same as when the
+  // inputs are processed one after another.
+  std::vector<DWPInput> DWPInputs(Inputs.size());
+  std::vector<Optional<Error>> InputErrors(Inputs.size());
+  auto ConsumeInputErrors = make_scope_exit([&] {
+    for (Optional<Error> &E : InputErrors)
+      if (E)
+        consumeError(std::move(*E));
+  });
+  parallelForEachN(0, Inputs.size(), [&](size_t I) {
+    auto ErrOrObj = object::ObjectFile::createObjectFile(Inputs[I]);
+    if (!ErrOrObj) {
+      InputErrors[I] = ErrOrObj.takeError();
+      return;
+    }
+    DWPInput &In = DWPInputs[I];
+    In.Obj = std::move(*ErrOrObj);
+    for (const auto &Section : In.Obj.getBinary()->sections())
+      if (auto Err = readSection(
+              KnownSections, StrSection, StrOffsetSection, TypesSection,
+              CUIndexSection, TUIndexSection, InfoSection, Section,
+              In.UncompressedSections, In.CurStrSection,
+              In.CurStrOffsetSection, In.CurTypesSection, In.CurInfoSection,
+              In.AbbrevSection, In.CurCUIndexSection, In.CurTUIndexSection,
+              In.SectionLength, In.OtherSections)) {
+        InputErrors[I] = std::move(Err);
+        return;
+      }
+  });
+  buildStringsAndOffsets(DWPInputs,
+                         Out.getContext().getAsmInfo()->isLittleEndian()
+                             ? support::little
+                             : support::big);
+
+  for (size_t InputIndex = 0, E = Inputs.size(); InputIndex != E;
+       ++InputIndex) {
+    const std::string &Input = Inputs[InputIndex];
+    if (InputErrors[InputIndex])
+      return std::move(*InputErrors[InputIndex]);
+    DWPInput &In = DWPInputs[InputIndex];
+    auto &Obj = *In.Obj.getBinary();
 
     UnitIndexEntry CurEntry = {};
 
-    StringRef CurStrSection;
-    StringRef CurStrOffsetSection;
-    std::vector<StringRef> CurTypesSection;
-    std::vector<StringRef> CurInfoSection;
-    StringRef AbbrevSection;
-    StringRef CurCUIndexSection;
-    StringRef CurTUIndexSection;
-
-    // This maps each section contained in this file to its length.
-    // This information is later on used to calculate the contributions,
-    // i.e. offset and length, of each compile/type unit to a section.
-    std::vector<std::pair<DWARFSectionKind, uint32_t>> SectionLength;
-
-    for (const auto &Section : Obj.sections())
-      if (auto Err = handleSection(
-              KnownSections, StrSection, StrOffsetSection, TypesSection,
-              CUIndexSection, TUIndexSection, InfoSection, Section, Out,
-              UncompressedSections, ContributionOffsets, CurEntry,
-              CurStrSection, CurStrOffsetSection, CurTypesSection,
-              CurInfoSection, AbbrevSection, CurCUIndexSection,
-              CurTUIndexSection, SectionLength))
-        return Err;
+    StringRef CurStrSection = In.CurStrSection;
+    StringRef CurStrOffsetSection = In.CurStrOffsetSection;
+    std::vector<StringRef> &CurTypesSection = In.CurTypesSection;
+    std::vector<StringRef> &CurInfoSection = In.CurInfoSection;
+    StringRef AbbrevSection = In.AbbrevSection;
+    StringRef CurCUIndexSection = In.CurCUIndexSection;
+    StringRef CurTUIndexSection = In.CurTUIndexSection;
+    std::vector<std::pair<DWARFSectionKind, uint32_t>> &SectionLength =
+        In.SectionLength;
+
+    for (const auto &Other : In.OtherSections) {
+      Out.SwitchSection(Other.first);
+      Out.emitBytes(Other.second);
+    }
 
     if (CurInfoSection.empty())
       continue;
@@ -620,8 +844,14 @@ Error write(MCStreamer &Out, ArrayRef<std::string> Inputs) {
       return make_error<DWPError>("incompatible DWARF compile unit versions.");
     }
 
-    writeStringsAndOffsets(Out, Strings, StrOffsetSection, CurStrSection,
-                           CurStrOffsetSection, Header.Version);
+    if (!CurStrSection.empty() && !CurStrOffsetSection.empty()) {
+      if (!In.NewStrings.empty()) {
+        Out.SwitchSection(StrSection);
+        Out.emitBytes(In.NewStrings);
+      }
+      Out.SwitchSection(StrOffsetSection);
+      Out.emitBytes(In.StrOffsets);
+    }
 
     for (auto Pair : SectionLength) {
       auto Index = getContributionIndex(Pair.first, IndexVersion);
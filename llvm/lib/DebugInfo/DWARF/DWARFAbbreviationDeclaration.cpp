@@ -30,6 +30,8 @@ void DWARFAbbreviationDeclaration::clear() {
   HasChildren = false;
   AttributeSpecs.clear();
   FixedAttributeSize.reset();
+  SkipPlan.clear();
+  TrailingFixedSize = FixedSizeInfo();
 }
 
 DWARFAbbreviationDeclaration::DWARFAbbreviationDeclaration() {
@@ -57,6 +59,9 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
   // this member variable still has a value after the while loop below, then
   // all attribute data in this abbreviation declaration has a fixed byte size.
   FixedAttributeSize = FixedSizeInfo();
+  // The fixed size attributes seen since the last variable size one. These
+  // are skipped together in one step of the skip plan.
+  FixedSizeInfo FixedRun;
 
   // Read all of the abbreviation attributes and forms.
   while (true) {
@@ -76,11 +81,13 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
       case DW_FORM_addr:
         if (FixedAttributeSize)
           ++FixedAttributeSize->NumAddrs;
+        ++FixedRun.NumAddrs;
         break;
 
       case DW_FORM_ref_addr:
         if (FixedAttributeSize)
           ++FixedAttributeSize->NumRefAddrs;
+        ++FixedRun.NumRefAddrs;
         break;
 
       case DW_FORM_strp:
@@ -91,6 +98,7 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
       case DW_FORM_strp_sup:
         if (FixedAttributeSize)
           ++FixedAttributeSize->NumDwarfOffsets;
+        ++FixedRun.NumDwarfOffsets;
         break;
 
       default:
@@ -99,12 +107,15 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
         if ((ByteSize = dwarf::getFixedFormByteSize(F, dwarf::FormParams()))) {
           if (FixedAttributeSize)
             FixedAttributeSize->NumBytes += *ByteSize;
+          FixedRun.NumBytes += *ByteSize;
           break;
         }
         // Indicate we no longer have a fixed byte size for this
         // abbreviation by clearing the FixedAttributeSize optional value
         // so it doesn't have a value.
         FixedAttributeSize.reset();
+        SkipPlan.push_back({FixedRun, getSkipKind(F), F});
+        FixedRun = FixedSizeInfo();
         break;
       }
       // Record this attribute and its fixed size if it has one.
@@ -112,6 +123,7 @@ DWARFAbbreviationDeclaration::extract(DataExtractor Data,
     } else if (A == 0 && F == 0) {
       // We successfully reached the end of this abbreviation declaration
       // since both attribute and form are zero.
+      TrailingFixedSize = FixedRun;
       break;
     } else {
       // Attribute and form pairs must either both be non-zero, in which case
@@ -200,16 +212,99 @@ DWARFAbbreviationDeclaration::getAttributeValue(const uint64_t DIEOffset,
 
 size_t DWARFAbbreviationDeclaration::FixedSizeInfo::getByteSize(
     const DWARFUnit &U) const {
+  return getByteSize(U.getFormParams());
+}
+
+size_t DWARFAbbreviationDeclaration::FixedSizeInfo::getByteSize(
+    const dwarf::FormParams &Params) const {
   size_t ByteSize = NumBytes;
   if (NumAddrs)
-    ByteSize += NumAddrs * U.getAddressByteSize();
+    ByteSize += NumAddrs * Params.AddrSize;
   if (NumRefAddrs)
-    ByteSize += NumRefAddrs * U.getRefAddrByteSize();
+    ByteSize += NumRefAddrs * Params.getRefAddrByteSize();
   if (NumDwarfOffsets)
-    ByteSize += NumDwarfOffsets * U.getDwarfOffsetByteSize();
+    ByteSize += NumDwarfOffsets * Params.getDwarfOffsetByteSize();
   return ByteSize;
 }
 
+DWARFAbbreviationDeclaration::SkipKind
+DWARFAbbreviationDeclaration::getSkipKind(dwarf::Form F) {
+  switch (F) {
+  case DW_FORM_udata:
+  case DW_FORM_ref_udata:
+  case DW_FORM_strx:
+  case DW_FORM_addrx:
+  case DW_FORM_loclistx:
+  case DW_FORM_rnglistx:
+  case DW_FORM_GNU_addr_index:
+  case DW_FORM_GNU_str_index:
+    return SkipKind::ULEB128;
+  case DW_FORM_sdata:
+    return SkipKind::SLEB128;
+  case DW_FORM_string:
+    return SkipKind::CString;
+  case DW_FORM_block1:
+    return SkipKind::Block1;
+  case DW_FORM_block2:
+    return SkipKind::Block2;
+  case DW_FORM_block4:
+    return SkipKind::Block4;
+  case DW_FORM_block:
+  case DW_FORM_exprloc:
+    return SkipKind::BlockULEB128;
+  default:
+    return SkipKind::Generic;
+  }
+}
+
+bool DWARFAbbreviationDeclaration::skipAttributeValues(
+    const DataExtractor &Data, uint64_t *OffsetPtr, const DWARFUnit &U,
+    dwarf::Form &InvalidForm) const {
+  const dwarf::FormParams &Params = U.getFormParams();
+  for (const SkipStep &Step : SkipPlan) {
+    *OffsetPtr += Step.Fixed.getByteSize(Params);
+    switch (Step.Kind) {
+    case SkipKind::ULEB128:
+      Data.getULEB128(OffsetPtr);
+      break;
+    case SkipKind::SLEB128:
+      Data.getSLEB128(OffsetPtr);
+      break;
+    case SkipKind::CString:
+      Data.getCStr(OffsetPtr);
+      break;
+    case SkipKind::Block1: {
+      uint8_t Size = Data.getU8(OffsetPtr);
+      *OffsetPtr += Size;
+      break;
+    }
+    case SkipKind::Block2: {
+      uint16_t Size = Data.getU16(OffsetPtr);
+      *OffsetPtr += Size;
+      break;
+    }
+    case SkipKind::Block4: {
+      uint32_t Size = Data.getU32(OffsetPtr);
+      *OffsetPtr += Size;
+      break;
+    }
+    case SkipKind::BlockULEB128: {
+      uint64_t Size = Data.getULEB128(OffsetPtr);
+      *OffsetPtr += Size;
+      break;
+    }
+    case SkipKind::Generic:
+      if (!DWARFFormValue::skipValue(Step.Form, Data, OffsetPtr, Params)) {
+        InvalidForm = Step.Form;
+        return false;
+      }
+      break;
+    }
+  }
+  *OffsetPtr += TrailingFixedSize.getByteSize(Params);
+  return true;
+}
+
 Optional<int64_t> DWARFAbbreviationDeclaration::AttributeSpec::getByteSize(
     const DWARFUnit &U) const {
   if (isImplicitConst())
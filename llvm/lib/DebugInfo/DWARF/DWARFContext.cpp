@@ -7,6 +7,7 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/ADT/DenseMap.h"
 #include "llvm/ADT/MapVector.h"
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallString.h"
@@ -25,6 +26,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugLine.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugLoc.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugMacro.h"
+#include "llvm/DebugInfo/DWARF/DWARFDebugNamesBuilder.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugPubTable.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugRangeList.h"
 #include "llvm/DebugInfo/DWARF/DWARFDebugRnglists.h"
@@ -51,11 +53,13 @@
 #include "llvm/Support/LEB128.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/ThreadPool.h"
 #include "llvm/Support/raw_ostream.h"
 #include <algorithm>
 #include <cstdint>
 #include <deque>
 #include <map>
+#include <numeric>
 #include <string>
 #include <utility>
 #include <vector>
@@ -73,13 +77,32 @@ using FunctionNameKind = DILineInfoSpecifier::FunctionNameKind;
 DWARFContext::DWARFContext(std::unique_ptr<const DWARFObject> DObj,
                            std::string DWPName,
                            std::function<void(Error)> RecoverableErrorHandler,
-                           std::function<void(Error)> WarningHandler)
+                           std::function<void(Error)> WarningHandler,
+                           bool ThreadSafe)
     : DIContext(CK_DWARF), DWPName(std::move(DWPName)),
       RecoverableErrorHandler(RecoverableErrorHandler),
-      WarningHandler(WarningHandler), DObj(std::move(DObj)) {}
+      WarningHandler(WarningHandler), ThreadSafe(ThreadSafe),
+      DObj(std::move(DObj)) {}
 
 DWARFContext::~DWARFContext() = default;
 
+namespace {
+/// Buffers what a task running on a thread pool prints. Colors are used if
+/// the stream the output is written to afterwards uses them, so the escape
+/// codes end up in the buffer.
+class TaskOutputStream : public raw_string_ostream {
+  bool HasColors;
+
+public:
+  TaskOutputStream(std::string &Str, bool HasColors, bool ColorsEnabled)
+      : raw_string_ostream(Str), HasColors(HasColors) {
+    enable_colors(ColorsEnabled);
+  }
+
+  bool has_colors() const override { return HasColors; }
+};
+} // namespace
+
 /// Dump the UUID load command.
 static void dumpUUID(raw_ostream &OS, const ObjectFile &Obj) {
   auto *MachO = dyn_cast<MachOObjectFile>(&Obj);
@@ -351,7 +374,8 @@ static void dumpPubTableSection(raw_ostream &OS, DIDumpOptions DumpOpts,
 
 void DWARFContext::dump(
     raw_ostream &OS, DIDumpOptions DumpOpts,
-    std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets) {
+    std::array<Optional<uint64_t>, DIDT_ID_Count> DumpOffsets,
+    ThreadPoolStrategy S) {
   uint64_t DumpType = DumpOpts.DumpType;
 
   StringRef Extension = sys::path::extension(DObj->getFileName());
@@ -385,15 +409,26 @@ void DWARFContext::dump(
                  DObj->getAbbrevDWOSection()))
     getDebugAbbrevDWO()->dump(OS);
 
+  // Dump the DIE at Offset, only extracting the DIEs of the unit containing
+  // it.
+  auto dumpUnitsAtOffset = [&](unit_iterator_range Units, uint64_t Offset) {
+    for (const auto &U : Units)
+      if (U->getOffset() <= Offset && Offset < U->getNextUnitOffset())
+        U->getDIEForOffset(Offset).dump(OS, 0, DumpOpts.noImplicitRecursion());
+  };
+  auto dumpUnits = [&](unit_iterator_range Units) {
+    printInOrder(OS, Units.end() - Units.begin(), S,
+                 [&](raw_ostream &UnitOS, size_t Index) {
+                   Units.begin()[Index]->dump(UnitOS, DumpOpts);
+                 });
+  };
+
   auto dumpDebugInfo = [&](const char *Name, unit_iterator_range Units) {
     OS << '\n' << Name << " contents:\n";
     if (auto DumpOffset = DumpOffsets[DIDT_ID_DebugInfo])
-      for (const auto &U : Units)
-        U->getDIEForOffset(DumpOffset.getValue())
-            .dump(OS, 0, DumpOpts.noImplicitRecursion());
+      dumpUnitsAtOffset(Units, *DumpOffset);
     else
-      for (const auto &U : Units)
-        U->dump(OS, DumpOpts);
+      dumpUnits(Units);
   };
   if ((DumpType & DIDT_DebugInfo)) {
     if (Explicit || getNumCompileUnits())
@@ -404,12 +439,10 @@ void DWARFContext::dump(
 
   auto dumpDebugType = [&](const char *Name, unit_iterator_range Units) {
     OS << '\n' << Name << " contents:\n";
-    for (const auto &U : Units)
-      if (auto DumpOffset = DumpOffsets[DIDT_ID_DebugTypes])
-        U->getDIEForOffset(*DumpOffset)
-            .dump(OS, 0, DumpOpts.noImplicitRecursion());
-      else
-        U->dump(OS, DumpOpts);
+    if (auto DumpOffset = DumpOffsets[DIDT_ID_DebugTypes])
+      dumpUnitsAtOffset(Units, *DumpOffset);
+    else
+      dumpUnits(Units);
   };
   if ((DumpType & DIDT_DebugTypes)) {
     if (Explicit || getNumTypeUnits())
@@ -702,6 +735,11 @@ void DWARFContext::dump(
 DWARFTypeUnit *DWARFContext::getTypeUnitForHash(uint16_t Version, uint64_t Hash,
                                                 bool IsDWO) {
   parseDWOUnits(LazyParse);
+  // Parse the units before taking the lock so that the type unit map below
+  // is built from an already complete unit vector.
+  if (ThreadSafe && !IsDWO)
+    parseNormalUnits();
+  auto Lock = lockIfThreadSafe();
 
   if (const auto &TUI = getTUIndex()) {
     if (const auto *R = TUI.getFromHash(Hash))
@@ -731,9 +769,11 @@ DWARFCompileUnit *DWARFContext::getDWOCompileUnitForHash(uint64_t Hash) {
   parseDWOUnits(LazyParse);
 
   if (const auto &CUI = getCUIndex()) {
-    if (const auto *R = CUI.getFromHash(Hash))
+    if (const auto *R = CUI.getFromHash(Hash)) {
+      auto Lock = lockIfThreadSafe();
       return dyn_cast_or_null<DWARFCompileUnit>(
           DWOUnits.getUnitForIndexEntry(*R));
+    }
     return nullptr;
   }
 
@@ -764,9 +804,10 @@ DWARFDie DWARFContext::getDIEForOffset(uint64_t Offset) {
   return DWARFDie();
 }
 
-bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts) {
+bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts,
+                          ThreadPoolStrategy S) {
   bool Success = true;
-  DWARFVerifier verifier(OS, *this, DumpOpts);
+  DWARFVerifier verifier(OS, *this, DumpOpts, S);
 
   Success &= verifier.handleDebugAbbrev();
   if (DumpOpts.DumpType & DIDT_DebugInfo)
@@ -778,6 +819,7 @@ bool DWARFContext::verify(raw_ostream &OS, DIDumpOptions DumpOpts) {
 }
 
 const DWARFUnitIndex &DWARFContext::getCUIndex() {
+  auto Lock = lockIfThreadSafe();
   if (CUIndex)
     return *CUIndex;
 
@@ -789,6 +831,7 @@ const DWARFUnitIndex &DWARFContext::getCUIndex() {
 }
 
 const DWARFUnitIndex &DWARFContext::getTUIndex() {
+  auto Lock = lockIfThreadSafe();
   if (TUIndex)
     return *TUIndex;
 
@@ -800,6 +843,7 @@ const DWARFUnitIndex &DWARFContext::getTUIndex() {
 }
 
 DWARFGdbIndex &DWARFContext::getGdbIndex() {
+  auto Lock = lockIfThreadSafe();
   if (GdbIndex)
     return *GdbIndex;
 
@@ -810,50 +854,48 @@ DWARFGdbIndex &DWARFContext::getGdbIndex() {
 }
 
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrev() {
-  if (Abbrev)
-    return Abbrev.get();
-
-  DataExtractor abbrData(DObj->getAbbrevSection(), isLittleEndian(), 0);
+  llvm::call_once(AbbrevOnce, [&] {
+    DataExtractor abbrData(DObj->getAbbrevSection(), isLittleEndian(), 0);
 
-  Abbrev.reset(new DWARFDebugAbbrev());
-  Abbrev->extract(abbrData);
+    Abbrev.reset(new DWARFDebugAbbrev());
+    Abbrev->extract(abbrData);
+  });
   return Abbrev.get();
 }
 
 const DWARFDebugAbbrev *DWARFContext::getDebugAbbrevDWO() {
-  if (AbbrevDWO)
-    return AbbrevDWO.get();
-
-  DataExtractor abbrData(DObj->getAbbrevDWOSection(), isLittleEndian(), 0);
-  AbbrevDWO.reset(new DWARFDebugAbbrev());
-  AbbrevDWO->extract(abbrData);
+  llvm::call_once(AbbrevDWOOnce, [&] {
+    DataExtractor abbrData(DObj->getAbbrevDWOSection(), isLittleEndian(), 0);
+    AbbrevDWO.reset(new DWARFDebugAbbrev());
+    AbbrevDWO->extract(abbrData);
+  });
   return AbbrevDWO.get();
 }
 
 const DWARFDebugLoc *DWARFContext::getDebugLoc() {
-  if (Loc)
-    return Loc.get();
-
-  // Assume all units have the same address byte size.
-  auto LocData =
-      getNumCompileUnits()
-          ? DWARFDataExtractor(*DObj, DObj->getLocSection(), isLittleEndian(),
-                               getUnitAtIndex(0)->getAddressByteSize())
-          : DWARFDataExtractor("", isLittleEndian(), 0);
-  Loc.reset(new DWARFDebugLoc(std::move(LocData)));
+  llvm::call_once(LocOnce, [&] {
+    // Assume all units have the same address byte size.
+    auto LocData =
+        getNumCompileUnits()
+            ? DWARFDataExtractor(*DObj, DObj->getLocSection(),
+                                 isLittleEndian(),
+                                 getUnitAtIndex(0)->getAddressByteSize())
+            : DWARFDataExtractor("", isLittleEndian(), 0);
+    Loc.reset(new DWARFDebugLoc(std::move(LocData)));
+  });
   return Loc.get();
 }
 
 const DWARFDebugAranges *DWARFContext::getDebugAranges() {
-  if (Aranges)
-    return Aranges.get();
-
-  Aranges.reset(new DWARFDebugAranges());
-  Aranges->generate(this);
+  llvm::call_once(ArangesOnce, [&] {
+    Aranges.reset(new DWARFDebugAranges());
+    Aranges->generate(this);
+  });
   return Aranges.get();
 }
 
 Expected<const DWARFDebugFrame *> DWARFContext::getDebugFrame() {
+  auto Lock = lockIfThreadSafe();
   if (DebugFrame)
     return DebugFrame.get();
 
@@ -880,6 +922,7 @@ Expected<const DWARFDebugFrame *> DWARFContext::getDebugFrame() {
 }
 
 Expected<const DWARFDebugFrame *> DWARFContext::getEHFrame() {
+  auto Lock = lockIfThreadSafe();
   if (EHFrame)
     return EHFrame.get();
 
@@ -896,26 +939,27 @@ Expected<const DWARFDebugFrame *> DWARFContext::getEHFrame() {
 }
 
 const DWARFDebugMacro *DWARFContext::getDebugMacro() {
-  if (!Macro)
-    Macro = parseMacroOrMacinfo(MacroSection);
+  llvm::call_once(MacroOnce,
+                  [&] { Macro = parseMacroOrMacinfo(MacroSection); });
   return Macro.get();
 }
 
 const DWARFDebugMacro *DWARFContext::getDebugMacroDWO() {
-  if (!MacroDWO)
-    MacroDWO = parseMacroOrMacinfo(MacroDwoSection);
+  llvm::call_once(MacroDWOOnce,
+                  [&] { MacroDWO = parseMacroOrMacinfo(MacroDwoSection); });
   return MacroDWO.get();
 }
 
 const DWARFDebugMacro *DWARFContext::getDebugMacinfo() {
-  if (!Macinfo)
-    Macinfo = parseMacroOrMacinfo(MacinfoSection);
+  llvm::call_once(MacinfoOnce,
+                  [&] { Macinfo = parseMacroOrMacinfo(MacinfoSection); });
   return Macinfo.get();
 }
 
 const DWARFDebugMacro *DWARFContext::getDebugMacinfoDWO() {
-  if (!MacinfoDWO)
+  llvm::call_once(MacinfoDWOOnce, [&] {
     MacinfoDWO = parseMacroOrMacinfo(MacinfoDwoSection);
+  });
   return MacinfoDWO.get();
 }
 
@@ -934,27 +978,98 @@ static T &getAccelTable(std::unique_ptr<T> &Cache, const DWARFObject &Obj,
 }
 
 const DWARFDebugNames &DWARFContext::getDebugNames() {
+  auto Lock = lockIfThreadSafe();
   return getAccelTable(Names, *DObj, DObj->getNamesSection(),
                        DObj->getStrSection(), isLittleEndian());
 }
 
+/// Parse the .debug_names table of an index built by DWARFDebugNamesBuilder.
+static Expected<std::unique_ptr<DWARFDebugNames>>
+parseDebugNamesIndex(DWARFContext &Ctx, MemoryBufferRef Index) {
+  Expected<std::pair<StringRef, StringRef>> SectionsOrErr =
+      DWARFDebugNamesBuilder::getSections(Ctx, Index);
+  if (!SectionsOrErr)
+    return SectionsOrErr.takeError();
+  DWARFDataExtractor AccelSection(SectionsOrErr->first,
+                                  /*IsLittleEndian=*/true, 0);
+  DataExtractor StrData(SectionsOrErr->second, /*IsLittleEndian=*/true, 0);
+  auto Table = std::make_unique<DWARFDebugNames>(AccelSection, StrData);
+  if (Error E = Table->extract())
+    return std::move(E);
+  return std::move(Table);
+}
+
+const DWARFDebugNames &
+DWARFContext::getOrBuildDebugNames(ThreadPoolStrategy S) {
+  if (!DObj->getNamesSection().Data.empty())
+    return getDebugNames();
+  llvm::call_once(BuiltNamesOnce, [&] {
+    BuiltNamesIndex = DWARFDebugNamesBuilder::build(*this, S);
+    Expected<std::unique_ptr<DWARFDebugNames>> TableOrErr =
+        parseDebugNamesIndex(*this, BuiltNamesIndex->getMemBufferRef());
+    if (TableOrErr) {
+      BuiltNames = std::move(*TableOrErr);
+      return;
+    }
+    RecoverableErrorHandler(TableOrErr.takeError());
+    BuiltNames = std::make_unique<DWARFDebugNames>(
+        DWARFDataExtractor(StringRef(), isLittleEndian(), 0),
+        DataExtractor(StringRef(), isLittleEndian(), 0));
+  });
+  return *BuiltNames;
+}
+
+Error DWARFContext::writeDebugNamesIndex(raw_ostream &OS,
+                                         ThreadPoolStrategy S) {
+  if (!DObj->getNamesSection().Data.empty())
+    return createStringError(errc::invalid_argument,
+                             "the object has a .debug_names section");
+  getOrBuildDebugNames(S);
+  OS << BuiltNamesIndex->getBuffer();
+  return Error::success();
+}
+
+Error DWARFContext::loadDebugNamesIndex(std::unique_ptr<MemoryBuffer> Index) {
+  if (!DObj->getNamesSection().Data.empty())
+    return createStringError(errc::invalid_argument,
+                             "the object has a .debug_names section");
+  Expected<std::unique_ptr<DWARFDebugNames>> TableOrErr =
+      parseDebugNamesIndex(*this, Index->getMemBufferRef());
+  if (!TableOrErr)
+    return TableOrErr.takeError();
+  bool Loaded = false;
+  llvm::call_once(BuiltNamesOnce, [&] {
+    BuiltNamesIndex = std::move(Index);
+    BuiltNames = std::move(*TableOrErr);
+    Loaded = true;
+  });
+  if (!Loaded)
+    return createStringError(errc::invalid_argument,
+                             "a name index is in use already");
+  return Error::success();
+}
+
 const AppleAcceleratorTable &DWARFContext::getAppleNames() {
+  auto Lock = lockIfThreadSafe();
   return getAccelTable(AppleNames, *DObj, DObj->getAppleNamesSection(),
                        DObj->getStrSection(), isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleTypes() {
+  auto Lock = lockIfThreadSafe();
   return getAccelTable(AppleTypes, *DObj, DObj->getAppleTypesSection(),
                        DObj->getStrSection(), isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleNamespaces() {
+  auto Lock = lockIfThreadSafe();
   return getAccelTable(AppleNamespaces, *DObj,
                        DObj->getAppleNamespacesSection(),
                        DObj->getStrSection(), isLittleEndian());
 }
 
 const AppleAcceleratorTable &DWARFContext::getAppleObjC() {
+  auto Lock = lockIfThreadSafe();
   return getAccelTable(AppleObjC, *DObj, DObj->getAppleObjCSection(),
                        DObj->getStrSection(), isLittleEndian());
 }
@@ -972,9 +1087,6 @@ DWARFContext::getLineTableForUnit(DWARFUnit *U) {
 
 Expected<const DWARFDebugLine::LineTable *> DWARFContext::getLineTableForUnit(
     DWARFUnit *U, function_ref<void(Error)> RecoverableErrorHandler) {
-  if (!Line)
-    Line.reset(new DWARFDebugLine);
-
   auto UnitDIE = U->getUnitDIE();
   if (!UnitDIE)
     return nullptr;
@@ -984,9 +1096,17 @@ Expected<const DWARFDebugLine::LineTable *> DWARFContext::getLineTableForUnit(
     return nullptr; // No line table for this compile unit.
 
   uint64_t stmtOffset = *Offset + U->getLineTableOffset();
-  // See if the line table is cached.
-  if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
-    return lt;
+  if (&U->getContext() == this)
+    recordUnitAccess(*U);
+  {
+    auto Lock = lockIfThreadSafe();
+    if (!Line)
+      Line.reset(new DWARFDebugLine);
+
+    // See if the line table is cached.
+    if (const DWARFLineTable *lt = Line->getLineTable(stmtOffset))
+      return lt;
+  }
 
   // Make sure the offset is good before we try to parse.
   if (stmtOffset >= U->getLineSection().Data.size())
@@ -995,23 +1115,51 @@ Expected<const DWARFDebugLine::LineTable *> DWARFContext::getLineTableForUnit(
   // We have to parse it first.
   DWARFDataExtractor lineData(*DObj, U->getLineSection(), isLittleEndian(),
                               U->getAddressByteSize());
-  return Line->getOrParseLineTable(lineData, stmtOffset, *this, U,
-                                   RecoverableErrorHandler);
+  if (!ThreadSafe)
+    return Line->getOrParseLineTable(lineData, stmtOffset, *this, U,
+                                     RecoverableErrorHandler);
+
+  // Parse outside of the lock so that distinct line tables are parsed
+  // concurrently. If another thread cached the same table in the meantime,
+  // its copy is kept and ours is dropped.
+  DWARFLineTable LT;
+  uint64_t ParseOffset = stmtOffset;
+  Error Err = LT.parse(lineData, &ParseOffset, *this, U,
+                       RecoverableErrorHandler);
+  auto Lock = lockIfThreadSafe();
+  const DWARFLineTable *Cached = Line->addLineTable(stmtOffset, std::move(LT));
+  if (Err)
+    return std::move(Err);
+  return Cached;
 }
 
 void DWARFContext::parseNormalUnits() {
-  if (!NormalUnits.empty())
-    return;
-  DObj->forEachInfoSections([&](const DWARFSection &S) {
-    NormalUnits.addUnitsForSection(*this, S, DW_SECT_INFO);
-  });
-  NormalUnits.finishedInfoUnits();
-  DObj->forEachTypesSections([&](const DWARFSection &S) {
-    NormalUnits.addUnitsForSection(*this, S, DW_SECT_EXT_TYPES);
+  llvm::call_once(NormalUnitsOnce, [&] {
+    DObj->forEachInfoSections([&](const DWARFSection &S) {
+      NormalUnits.addUnitsForSection(*this, S, DW_SECT_INFO);
+    });
+    NormalUnits.finishedInfoUnits();
+    DObj->forEachTypesSections([&](const DWARFSection &S) {
+      NormalUnits.addUnitsForSection(*this, S, DW_SECT_EXT_TYPES);
+    });
   });
 }
 
 void DWARFContext::parseDWOUnits(bool Lazy) {
+  // Lazily parsed units are added to DWOUnits on lookup, which would race
+  // with concurrent readers. Parse all of them up front instead.
+  if (ThreadSafe) {
+    llvm::call_once(DWOUnitsOnce, [&] {
+      DObj->forEachInfoDWOSections([&](const DWARFSection &S) {
+        DWOUnits.addUnitsForDWOSection(*this, S, DW_SECT_INFO);
+      });
+      DWOUnits.finishedInfoUnits();
+      DObj->forEachTypesDWOSections([&](const DWARFSection &S) {
+        DWOUnits.addUnitsForDWOSection(*this, S, DW_SECT_EXT_TYPES);
+      });
+    });
+    return;
+  }
   if (!DWOUnits.empty())
     return;
   DObj->forEachInfoDWOSections([&](const DWARFSection &S) {
@@ -1023,6 +1171,194 @@ void DWARFContext::parseDWOUnits(bool Lazy) {
   });
 }
 
+void DWARFContext::prefetchAllUnits(ThreadPoolStrategy S) {
+  parseNormalUnits();
+
+  // Collect problems per unit and report them afterwards, so that the
+  // handlers are called from this thread and in a deterministic order.
+  struct UnitErrors {
+    Error DIEs = Error::success();
+    Error Line = Error::success();
+  };
+  std::vector<UnitErrors> Errors(NormalUnits.size());
+  auto PrefetchUnit = [&](size_t Index) {
+    DWARFUnit *U = NormalUnits[Index].get();
+    UnitErrors &Errs = Errors[Index];
+    Errs.DIEs = joinErrors(std::move(Errs.DIEs),
+                           U->tryExtractDIEsIfNeeded(/*CUDieOnly=*/false));
+    if (U->isTypeUnit())
+      return;
+    Expected<const DWARFLineTable *> LT =
+        getLineTableForUnit(U, [&](Error E) {
+          Errs.Line = joinErrors(std::move(Errs.Line), std::move(E));
+        });
+    if (!LT)
+      Errs.Line = joinErrors(std::move(Errs.Line), LT.takeError());
+  };
+
+  if (ThreadSafe && S.compute_thread_count() > 1) {
+    ThreadPool Pool(S);
+    for (size_t I = 0, E = NormalUnits.size(); I != E; ++I)
+      Pool.async(PrefetchUnit, I);
+    Pool.wait();
+  } else {
+    for (size_t I = 0, E = NormalUnits.size(); I != E; ++I)
+      PrefetchUnit(I);
+  }
+
+  for (UnitErrors &Errs : Errors) {
+    if (Errs.DIEs)
+      RecoverableErrorHandler(std::move(Errs.DIEs));
+    if (Errs.Line)
+      WarningHandler(std::move(Errs.Line));
+  }
+
+  // The unit DIEs are in memory now, so building the aranges only decodes
+  // the unit ranges.
+  getDebugAranges();
+}
+
+void DWARFContext::printInOrder(
+    raw_ostream &OS, size_t Count, ThreadPoolStrategy S,
+    function_ref<void(raw_ostream &, size_t)> Print) {
+  unsigned NumThreads = S.compute_thread_count();
+  if (!ThreadSafe || NumThreads < 2 || Count < 2) {
+    for (size_t I = 0; I != Count; ++I) {
+      Print(OS, I);
+      pruneDIECache();
+    }
+    return;
+  }
+
+  // Keep a few calls per thread in flight, so that the pool stays busy while
+  // the buffers wait for the calls before them.
+  size_t MaxInFlight = 4 * NumThreads;
+  bool HasColors = OS.has_colors();
+  bool ColorsEnabled = OS.colors_enabled();
+  std::vector<std::string> Output(Count);
+  std::vector<std::shared_future<void>> Done(Count);
+  ThreadPool Pool(S);
+  auto Start = [&](size_t I) {
+    Done[I] = Pool.async([&, I]() {
+      TaskOutputStream TaskOS(Output[I], HasColors, ColorsEnabled);
+      Print(TaskOS, I);
+    });
+  };
+  for (size_t I = 0, E = std::min(Count, MaxInFlight); I != E; ++I)
+    Start(I);
+  for (size_t I = 0; I != Count; ++I) {
+    Done[I].wait();
+    if (I + MaxInFlight < Count)
+      Start(I + MaxInFlight);
+    OS << Output[I];
+    Output[I] = std::string();
+  }
+  Pool.wait();
+}
+
+void DWARFContext::setDIEMemoryBudget(uint64_t Bytes) {
+  DIEMemoryBudget = ThreadSafe ? 0 : Bytes;
+  if (!DIEMemoryBudget) {
+    UnitLRU.clear();
+    UnitLRUPos.clear();
+  }
+  forEachDWOContext([&](DWARFContext &DWOCtx) {
+    DWOCtx.setDIEMemoryBudget(Bytes);
+  });
+}
+
+void DWARFContext::forEachDWOContext(function_ref<void(DWARFContext &)> F) {
+  if (std::shared_ptr<DWOFile> S = DWP.lock())
+    F(*S->Context);
+  for (auto &Entry : DWOFiles)
+    if (std::shared_ptr<DWOFile> S = Entry.second.lock())
+      F(*S->Context);
+}
+
+void DWARFContext::recordUnitAccess(DWARFUnit &U) {
+  if (!DIEMemoryBudget)
+    return;
+  auto Pos = UnitLRUPos.find(&U);
+  if (Pos != UnitLRUPos.end())
+    UnitLRU.splice(UnitLRU.end(), UnitLRU, Pos->second);
+  else
+    UnitLRUPos[&U] = UnitLRU.insert(UnitLRU.end(), &U);
+}
+
+/// Returns the offset of the line table of \p U, if it has one.
+static Optional<uint64_t> getUnitLineTableOffset(DWARFUnit &U) {
+  Optional<uint64_t> Offset =
+      toSectionOffset(U.getUnitDIE().find(DW_AT_stmt_list));
+  if (!Offset)
+    return None;
+  return *Offset + U.getLineTableOffset();
+}
+
+uint64_t DWARFContext::getLineTableMemoryUsage(uint64_t Offset) {
+  if (Line)
+    if (const DWARFLineTable *LT = Line->getLineTable(Offset))
+      return LT->getMemoryUsage();
+  return 0;
+}
+
+uint64_t DWARFContext::getDIEMemoryUsage(
+    DenseMap<uint64_t, unsigned> *LineTableUsers) {
+  DenseMap<uint64_t, unsigned> Users;
+  if (!LineTableUsers)
+    LineTableUsers = &Users;
+  uint64_t Usage = 0;
+  for (DWARFUnit *U : UnitLRU) {
+    Usage += U->getDIEMemoryUsage();
+    // A type unit shares the line table of the compile unit it came from, so
+    // count each line table once.
+    if (Optional<uint64_t> Offset = getUnitLineTableOffset(*U))
+      if ((*LineTableUsers)[*Offset]++ == 0)
+        Usage += getLineTableMemoryUsage(*Offset);
+  }
+  return Usage;
+}
+
+void DWARFContext::releaseUnit(DWARFUnit &U) {
+  if (Line)
+    if (Optional<uint64_t> Offset = getUnitLineTableOffset(U))
+      Line->clearLineTable(*Offset);
+  U.releaseDIEs();
+}
+
+void DWARFContext::releaseDIEs() {
+  if (ThreadSafe)
+    return;
+  for (const auto &U : normal_units())
+    releaseUnit(*U);
+  UnitLRU.clear();
+  UnitLRUPos.clear();
+  forEachDWOContext([](DWARFContext &DWOCtx) { DWOCtx.releaseDIEs(); });
+}
+
+void DWARFContext::pruneDIECache() {
+  if (!DIEMemoryBudget)
+    return;
+  forEachDWOContext([](DWARFContext &DWOCtx) { DWOCtx.pruneDIECache(); });
+
+  DenseMap<uint64_t, unsigned> LineTableUsers;
+  uint64_t Usage = getDIEMemoryUsage(&LineTableUsers);
+  // Keep the most recently used unit, which the caller is likely to query
+  // again next.
+  while (Usage > DIEMemoryBudget && UnitLRU.size() > 1) {
+    DWARFUnit *U = UnitLRU.front();
+    Usage -= U->getDIEMemoryUsage();
+    // Keep a shared line table until the last tracked unit using it goes.
+    if (Optional<uint64_t> Offset = getUnitLineTableOffset(*U))
+      if (--LineTableUsers[*Offset] == 0 && Line) {
+        Usage -= getLineTableMemoryUsage(*Offset);
+        Line->clearLineTable(*Offset);
+      }
+    U->releaseDIEs();
+    UnitLRUPos.erase(U);
+    UnitLRU.pop_front();
+  }
+}
+
 DWARFCompileUnit *DWARFContext::getCompileUnitForOffset(uint64_t Offset) {
   parseNormalUnits();
   return dyn_cast_or_null<DWARFCompileUnit>(
@@ -1259,27 +1595,106 @@ DWARFContext::getLocalsForAddress(object::SectionedAddress Address) {
   return Result;
 }
 
-DILineInfo DWARFContext::getLineInfoForAddress(object::SectionedAddress Address,
-                                               DILineInfoSpecifier Spec) {
+/// Build the line info for \p Address in \p CU, given its row in \p LineTable
+/// (which may be null).
+static DILineInfo getLineInfoForAddressInUnit(
+    DWARFCompileUnit *CU, uint64_t Address, DILineInfoSpecifier Spec,
+    const DWARFDebugLine::LineTable *LineTable, uint32_t RowIndex) {
   DILineInfo Result;
+  getFunctionNameAndStartLineForAddress(
+      CU, Address, Spec.FNKind, Spec.FLIKind, Result.FunctionName,
+      Result.StartFileName, Result.StartLine, Result.StartAddress);
+  if (Spec.FLIKind != FileLineInfoKind::None && LineTable)
+    LineTable->getFileLineInfoForRow(RowIndex, CU->getCompilationDir(),
+                                     Spec.FLIKind, Result);
+  return Result;
+}
 
+DILineInfo DWARFContext::getLineInfoForAddress(object::SectionedAddress Address,
+                                               DILineInfoSpecifier Spec) {
   DWARFCompileUnit *CU = getCompileUnitForAddress(Address.Address);
   if (!CU)
-    return Result;
+    return DILineInfo();
 
-  getFunctionNameAndStartLineForAddress(
-      CU, Address.Address, Spec.FNKind, Spec.FLIKind, Result.FunctionName,
-      Result.StartFileName, Result.StartLine, Result.StartAddress);
+  const DWARFLineTable *LineTable = nullptr;
+  uint32_t RowIndex = -1U;
   if (Spec.FLIKind != FileLineInfoKind::None) {
-    if (const DWARFLineTable *LineTable = getLineTableForUnit(CU)) {
-      LineTable->getFileLineInfoForAddress(
-          {Address.Address, Address.SectionIndex}, CU->getCompilationDir(),
-          Spec.FLIKind, Result);
-    }
+    LineTable = getLineTableForUnit(CU);
+    if (LineTable)
+      RowIndex = LineTable->lookupAddress(Address);
   }
+  return getLineInfoForAddressInUnit(CU, Address.Address, Spec, LineTable,
+                                     RowIndex);
+}
+
+std::vector<DILineInfo> DWARFContext::getLineInfoForAddresses(
+    ArrayRef<object::SectionedAddress> Addresses, DILineInfoSpecifier Spec) {
+  std::vector<DILineInfo> Result(Addresses.size());
+  resolveAddresses(Addresses, Spec.FLIKind != FileLineInfoKind::None,
+                   [&](size_t I, DWARFCompileUnit *CU,
+                       const DWARFLineTable *LineTable, uint32_t RowIndex) {
+                     Result[I] = getLineInfoForAddressInUnit(
+                         CU, Addresses[I].Address, Spec, LineTable, RowIndex);
+                   });
   return Result;
 }
 
+void DWARFContext::resolveAddresses(
+    ArrayRef<object::SectionedAddress> Addresses, bool NeedLineRows,
+    function_ref<void(size_t, DWARFCompileUnit *, const DWARFLineTable *,
+                      uint32_t)>
+        Callback) {
+  // Sort the addresses once, so that the aranges and the line tables can be
+  // searched in forward sweeps rather than with a binary search per address.
+  std::vector<size_t> Order(Addresses.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  llvm::stable_sort(Order, [&](size_t LHS, size_t RHS) {
+    return std::tie(Addresses[LHS].SectionIndex, Addresses[LHS].Address) <
+           std::tie(Addresses[RHS].SectionIndex, Addresses[RHS].Address);
+  });
+
+  std::vector<uint64_t> SortedAddresses;
+  SortedAddresses.reserve(Order.size());
+  for (size_t I : Order)
+    SortedAddresses.push_back(Addresses[I].Address);
+  std::vector<uint64_t> CUOffsets(Order.size());
+  getDebugAranges()->findAddresses(SortedAddresses, CUOffsets);
+
+  // Group the addresses by unit, keeping them sorted within each unit, so
+  // that each line table is swept once.
+  std::vector<size_t> ByUnit(Order.size());
+  std::iota(ByUnit.begin(), ByUnit.end(), 0);
+  llvm::stable_sort(ByUnit, [&](size_t LHS, size_t RHS) {
+    return CUOffsets[LHS] < CUOffsets[RHS];
+  });
+
+  SmallVector<object::SectionedAddress, 32> UnitAddresses;
+  SmallVector<uint32_t, 32> RowIndices;
+  for (auto Begin = ByUnit.begin(), End = ByUnit.end(); Begin != End;) {
+    uint64_t CUOffset = CUOffsets[*Begin];
+    auto GroupEnd = std::find_if(Begin, End, [&](size_t I) {
+      return CUOffsets[I] != CUOffset;
+    });
+    auto Group = make_range(Begin, GroupEnd);
+    Begin = GroupEnd;
+
+    DWARFCompileUnit *CU = getCompileUnitForOffset(CUOffset);
+    if (!CU)
+      continue;
+    const DWARFLineTable *LineTable =
+        NeedLineRows ? getLineTableForUnit(CU) : nullptr;
+    UnitAddresses.clear();
+    for (size_t I : Group)
+      UnitAddresses.push_back(Addresses[Order[I]]);
+    RowIndices.assign(UnitAddresses.size(), -1U);
+    if (LineTable)
+      LineTable->lookupAddresses(UnitAddresses, RowIndices);
+    size_t K = 0;
+    for (size_t I : Group)
+      Callback(Order[I], CU, LineTable, RowIndices[K++]);
+  }
+}
+
 DILineInfoTable DWARFContext::getLineInfoForAddressRange(
     object::SectionedAddress Address, uint64_t Size, DILineInfoSpecifier Spec) {
   DILineInfoTable Lines;
@@ -1334,27 +1749,22 @@ DILineInfoTable DWARFContext::getLineInfoForAddressRange(
   return Lines;
 }
 
-DIInliningInfo
-DWARFContext::getInliningInfoForAddress(object::SectionedAddress Address,
-                                        DILineInfoSpecifier Spec) {
+/// Build the inlining info for \p Address in \p CU, given its row in
+/// \p LineTable (which may be null).
+static DIInliningInfo getInliningInfoForAddressInUnit(
+    DWARFCompileUnit *CU, uint64_t Address, DILineInfoSpecifier Spec,
+    const DWARFDebugLine::LineTable *LineTable, uint32_t RowIndex) {
   DIInliningInfo InliningInfo;
-
-  DWARFCompileUnit *CU = getCompileUnitForAddress(Address.Address);
-  if (!CU)
-    return InliningInfo;
-
-  const DWARFLineTable *LineTable = nullptr;
   SmallVector<DWARFDie, 4> InlinedChain;
-  CU->getInlinedChainForAddress(Address.Address, InlinedChain);
+  CU->getInlinedChainForAddress(Address, InlinedChain);
   if (InlinedChain.size() == 0) {
     // If there is no DIE for address (e.g. it is in unavailable .dwo file),
     // try to at least get file/line info from symbol table.
     if (Spec.FLIKind != FileLineInfoKind::None) {
       DILineInfo Frame;
-      LineTable = getLineTableForUnit(CU);
-      if (LineTable && LineTable->getFileLineInfoForAddress(
-                           {Address.Address, Address.SectionIndex},
-                           CU->getCompilationDir(), Spec.FLIKind, Frame))
+      if (LineTable &&
+          LineTable->getFileLineInfoForRow(RowIndex, CU->getCompilationDir(),
+                                           Spec.FLIKind, Frame))
         InliningInfo.addFrame(Frame);
     }
     return InliningInfo;
@@ -1374,14 +1784,10 @@ DWARFContext::getInliningInfoForAddress(object::SectionedAddress Address,
       Frame.StartAddress = LowPcAddr->Address;
     if (Spec.FLIKind != FileLineInfoKind::None) {
       if (i == 0) {
-        // For the topmost frame, initialize the line table of this
-        // compile unit and fetch file/line info from it.
-        LineTable = getLineTableForUnit(CU);
         // For the topmost routine, get file/line info from line table.
         if (LineTable)
-          LineTable->getFileLineInfoForAddress(
-              {Address.Address, Address.SectionIndex}, CU->getCompilationDir(),
-              Spec.FLIKind, Frame);
+          LineTable->getFileLineInfoForRow(RowIndex, CU->getCompilationDir(),
+                                           Spec.FLIKind, Frame);
       } else {
         // Otherwise, use call file, call line and call column from
         // previous DIE in inlined chain.
@@ -1403,8 +1809,39 @@ DWARFContext::getInliningInfoForAddress(object::SectionedAddress Address,
   return InliningInfo;
 }
 
+DIInliningInfo
+DWARFContext::getInliningInfoForAddress(object::SectionedAddress Address,
+                                        DILineInfoSpecifier Spec) {
+  DWARFCompileUnit *CU = getCompileUnitForAddress(Address.Address);
+  if (!CU)
+    return DIInliningInfo();
+
+  const DWARFLineTable *LineTable = nullptr;
+  uint32_t RowIndex = -1U;
+  if (Spec.FLIKind != FileLineInfoKind::None) {
+    LineTable = getLineTableForUnit(CU);
+    if (LineTable)
+      RowIndex = LineTable->lookupAddress(Address);
+  }
+  return getInliningInfoForAddressInUnit(CU, Address.Address, Spec, LineTable,
+                                         RowIndex);
+}
+
+std::vector<DIInliningInfo> DWARFContext::getInliningInfoForAddresses(
+    ArrayRef<object::SectionedAddress> Addresses, DILineInfoSpecifier Spec) {
+  std::vector<DIInliningInfo> Result(Addresses.size());
+  resolveAddresses(Addresses, Spec.FLIKind != FileLineInfoKind::None,
+                   [&](size_t I, DWARFCompileUnit *CU,
+                       const DWARFLineTable *LineTable, uint32_t RowIndex) {
+                     Result[I] = getInliningInfoForAddressInUnit(
+                         CU, Addresses[I].Address, Spec, LineTable, RowIndex);
+                   });
+  return Result;
+}
+
 std::shared_ptr<DWARFContext>
 DWARFContext::getDWOContext(StringRef AbsolutePath) {
+  auto Lock = lockIfThreadSafe();
   if (auto S = DWP.lock()) {
     DWARFContext *Ctxt = S->Context.get();
     return std::shared_ptr<DWARFContext>(std::move(S), Ctxt);
@@ -1446,8 +1883,11 @@ DWARFContext::getDWOContext(StringRef AbsolutePath) {
 
   auto S = std::make_shared<DWOFile>();
   S->File = std::move(Obj.get());
-  S->Context = DWARFContext::create(*S->File.getBinary(),
-                                    ProcessDebugRelocations::Ignore);
+  S->Context = DWARFContext::create(
+      *S->File.getBinary(), ProcessDebugRelocations::Ignore, nullptr, "",
+      WithColor::defaultErrorHandler, WithColor::defaultWarningHandler,
+      ThreadSafe);
+  S->Context->setDIEMemoryBudget(DIEMemoryBudget);
   *Entry = S;
   auto *Ctxt = S->Context.get();
   return std::shared_ptr<DWARFContext>(std::move(S), Ctxt);
@@ -1622,9 +2062,27 @@ class DWARFObjInMemory final : public DWARFObject {
   StringRef TUIndexSection;
   StringRef LineStrSection;
 
-  // A deque holding section data whose iterators are not invalidated when
-  // new decompressed sections are inserted at the end.
-  std::deque<SmallString<0>> UncompressedSections;
+  /// A compressed section whose decompression is deferred until one of the
+  /// members it is mapped to is first accessed.
+  struct LazySection {
+    LazySection(StringRef Name, StringRef CompressedData)
+        : Name(Name), CompressedData(CompressedData) {}
+
+    StringRef Name;
+    StringRef CompressedData;
+    SmallString<0> UncompressedData;
+    /// The members that receive UncompressedData.
+    SmallVector<StringRef *, 1> Targets;
+    llvm::once_flag Once;
+  };
+
+  // A deque so that the once_flags are never moved and the data stays put
+  // when new compressed sections are appended.
+  mutable std::deque<LazySection> LazySections;
+  // Maps each member holding the data of a compressed section to the section.
+  // It is only modified by the constructor, so lookups need no locking.
+  DenseMap<const StringRef *, LazySection *> LazySectionMap;
+  std::function<void(Error)> HandleError;
 
   StringRef *mapSectionToMember(StringRef Name) {
     if (DWARFSection *Sec = mapNameToDWARFSection(Name))
@@ -1646,26 +2104,49 @@ class DWARFObjInMemory final : public DWARFObject {
         .Default(nullptr);
   }
 
-  /// If Sec is compressed section, decompresses and updates its contents
-  /// provided by Data. Otherwise leaves it unchanged.
-  Error maybeDecompress(const object::SectionRef &Sec, StringRef Name,
-                        StringRef &Data) {
-    if (!Decompressor::isCompressed(Sec))
-      return Error::success();
-
-    Expected<Decompressor> Decompressor =
-        Decompressor::create(Name, Data, IsLittleEndian, AddressSize == 8);
-    if (!Decompressor)
-      return Decompressor.takeError();
-
-    SmallString<0> Out;
-    if (auto Err = Decompressor->resizeAndDecompress(Out))
-      return Err;
+  /// Set the contents of \p Member to \p Data, or, if \p Lazy is not null,
+  /// to the contents of \p Lazy once it is decompressed.
+  void setSectionData(StringRef &Member, StringRef Data, LazySection *Lazy) {
+    if (Lazy) {
+      Member = StringRef();
+      LazySectionMap[&Member] = Lazy;
+    } else {
+      Member = Data;
+      LazySectionMap.erase(&Member);
+    }
+  }
 
-    UncompressedSections.push_back(std::move(Out));
-    Data = UncompressedSections.back();
+  /// Decompress the section whose data \p Member refers to, if that has not
+  /// happened yet. Sections that fail to decompress are left empty.
+  void decompressIfNeeded(const StringRef &Member) const {
+    if (LazySectionMap.empty())
+      return;
+    auto It = LazySectionMap.find(&Member);
+    if (It == LazySectionMap.end())
+      return;
+    LazySection &Sec = *It->second;
+    llvm::call_once(Sec.Once, [&] {
+      Expected<Decompressor> Dec = Decompressor::create(
+          Sec.Name, Sec.CompressedData, IsLittleEndian, AddressSize == 8);
+      Error Err = Dec ? Dec->resizeAndDecompress(Sec.UncompressedData)
+                      : Dec.takeError();
+      if (Err) {
+        HandleError(createError("failed to decompress '" + Sec.Name + "', ",
+                                std::move(Err)));
+        return;
+      }
+      for (StringRef *Target : Sec.Targets)
+        *Target = Sec.UncompressedData;
+    });
+  }
 
-    return Error::success();
+  const DWARFSection &load(const DWARFSection &S) const {
+    decompressIfNeeded(S.Data);
+    return S;
+  }
+  StringRef load(const StringRef &S) const {
+    decompressIfNeeded(S);
+    return S;
   }
 
 public:
@@ -1688,12 +2169,17 @@ public:
     }
   }
   DWARFObjInMemory(const object::ObjectFile &Obj, const LoadedObjectInfo *L,
-                   function_ref<void(Error)> HandleError,
+                   std::function<void(Error)> HandleError,
                    function_ref<void(Error)> HandleWarning,
                    DWARFContext::ProcessDebugRelocations RelocAction)
       : IsLittleEndian(Obj.isLittleEndian()),
         AddressSize(Obj.getBytesInAddress()), FileName(Obj.getFileName()),
-        Obj(&Obj) {
+        Obj(&Obj), HandleError(HandleError) {
+    // The data of the info and types sections lives in MapVectors that may
+    // still grow, so their lazily decompressed sections are only registered
+    // once all sections have been seen.
+    SmallVector<std::tuple<InfoSectionMap *, SectionRef, LazySection *>, 0>
+        LazyInfoSections;
 
     StringMap<unsigned> SectionAmountMap;
     for (const SectionRef &Section : Obj.sections()) {
@@ -1732,18 +2218,20 @@ public:
         if (E)
           Data = *E;
         else
-          // maybeDecompress below will error.
+          // Decompressing the section will error.
           consumeError(E.takeError());
       }
 
-      if (auto Err = maybeDecompress(Section, Name, Data)) {
-        HandleError(createError("failed to decompress '" + Name + "', ",
-                                std::move(Err)));
-        continue;
+      // Compressed sections are only decompressed when they are first
+      // accessed, as most clients use just a few of them.
+      LazySection *Lazy = nullptr;
+      if (Decompressor::isCompressed(Section)) {
+        LazySections.emplace_back(Name, Data);
+        Lazy = &LazySections.back();
       }
 
       // Compressed sections names in GNU style starts from ".z",
-      // at this point section is decompressed and we drop compression prefix.
+      // drop the compression prefix.
       Name = Name.substr(
           Name.find_first_not_of("._z")); // Skip ".", "z" and "_" prefixes.
 
@@ -1752,10 +2240,10 @@ public:
       Name = Obj.mapDebugSectionName(Name);
 
       if (StringRef *SectionData = mapSectionToMember(Name)) {
-        *SectionData = Data;
+        setSectionData(*SectionData, Data, Lazy);
         if (Name == "debug_ranges") {
           // FIXME: Use the other dwo range section when we emit it.
-          RangesDWOSection.Data = Data;
+          setSectionData(RangesDWOSection.Data, Data, Lazy);
         } else if (Name == "debug_frame" || Name == "eh_frame") {
           if (DWARFSection *S = mapNameToDWARFSection(Name))
             S->Address = Section.getAddress();
@@ -1770,7 +2258,9 @@ public:
         // Find debug_info and debug_types data by section rather than name as
         // there are multiple, comdat grouped, of these sections.
         DWARFSectionMap &S = (*Sections)[Section];
-        S.Data = Data;
+        S.Data = Lazy ? StringRef() : Data;
+        if (Lazy)
+          LazyInfoSections.emplace_back(Sections, Section, Lazy);
       }
 
       if (RelocatedSection != Obj.section_end() && Name.contains(".dwo"))
@@ -1880,6 +2370,11 @@ public:
     for (SectionName &S : SectionNames)
       if (SectionAmountMap[S.Name] > 1)
         S.IsNameUnique = false;
+
+    for (const auto &I : LazyInfoSections)
+      LazySectionMap[&(*std::get<0>(I))[std::get<1>(I)].Data] = std::get<2>(I);
+    for (const auto &P : LazySectionMap)
+      P.second->Targets.push_back(const_cast<StringRef *>(P.first));
   }
 
   Optional<RelocAddrEntry> find(const DWARFSection &S,
@@ -1898,91 +2393,115 @@ public:
   }
 
   bool isLittleEndian() const override { return IsLittleEndian; }
-  StringRef getAbbrevDWOSection() const override { return AbbrevDWOSection; }
+  StringRef getAbbrevDWOSection() const override {
+    return load(AbbrevDWOSection);
+  }
   const DWARFSection &getLineDWOSection() const override {
-    return LineDWOSection;
+    return load(LineDWOSection);
   }
   const DWARFSection &getLocDWOSection() const override {
-    return LocDWOSection;
+    return load(LocDWOSection);
   }
-  StringRef getStrDWOSection() const override { return StrDWOSection; }
+  StringRef getStrDWOSection() const override { return load(StrDWOSection); }
   const DWARFSection &getStrOffsetsDWOSection() const override {
-    return StrOffsetsDWOSection;
+    return load(StrOffsetsDWOSection);
   }
   const DWARFSection &getRangesDWOSection() const override {
-    return RangesDWOSection;
+    return load(RangesDWOSection);
   }
   const DWARFSection &getRnglistsDWOSection() const override {
-    return RnglistsDWOSection;
+    return load(RnglistsDWOSection);
   }
   const DWARFSection &getLoclistsDWOSection() const override {
-    return LoclistsDWOSection;
+    return load(LoclistsDWOSection);
+  }
+  const DWARFSection &getAddrSection() const override {
+    return load(AddrSection);
   }
-  const DWARFSection &getAddrSection() const override { return AddrSection; }
-  StringRef getCUIndexSection() const override { return CUIndexSection; }
-  StringRef getGdbIndexSection() const override { return GdbIndexSection; }
-  StringRef getTUIndexSection() const override { return TUIndexSection; }
+  StringRef getCUIndexSection() const override { return load(CUIndexSection); }
+  StringRef getGdbIndexSection() const override {
+    return load(GdbIndexSection);
+  }
+  StringRef getTUIndexSection() const override { return load(TUIndexSection); }
 
   // DWARF v5
   const DWARFSection &getStrOffsetsSection() const override {
-    return StrOffsetsSection;
+    return load(StrOffsetsSection);
   }
-  StringRef getLineStrSection() const override { return LineStrSection; }
+  StringRef getLineStrSection() const override { return load(LineStrSection); }
 
   // Sections for DWARF5 split dwarf proposal.
   void forEachInfoDWOSections(
       function_ref<void(const DWARFSection &)> F) const override {
     for (auto &P : InfoDWOSections)
-      F(P.second);
+      F(load(P.second));
   }
   void forEachTypesDWOSections(
       function_ref<void(const DWARFSection &)> F) const override {
     for (auto &P : TypesDWOSections)
-      F(P.second);
+      F(load(P.second));
   }
 
-  StringRef getAbbrevSection() const override { return AbbrevSection; }
-  const DWARFSection &getLocSection() const override { return LocSection; }
-  const DWARFSection &getLoclistsSection() const override { return LoclistsSection; }
-  StringRef getArangesSection() const override { return ArangesSection; }
+  StringRef getAbbrevSection() const override { return load(AbbrevSection); }
+  const DWARFSection &getLocSection() const override {
+    return load(LocSection);
+  }
+  const DWARFSection &getLoclistsSection() const override {
+    return load(LoclistsSection);
+  }
+  StringRef getArangesSection() const override { return load(ArangesSection); }
   const DWARFSection &getFrameSection() const override {
-    return FrameSection;
+    return load(FrameSection);
   }
   const DWARFSection &getEHFrameSection() const override {
-    return EHFrameSection;
+    return load(EHFrameSection);
+  }
+  const DWARFSection &getLineSection() const override {
+    return load(LineSection);
+  }
+  StringRef getStrSection() const override { return load(StrSection); }
+  const DWARFSection &getRangesSection() const override {
+    return load(RangesSection);
   }
-  const DWARFSection &getLineSection() const override { return LineSection; }
-  StringRef getStrSection() const override { return StrSection; }
-  const DWARFSection &getRangesSection() const override { return RangesSection; }
   const DWARFSection &getRnglistsSection() const override {
-    return RnglistsSection;
-  }
-  const DWARFSection &getMacroSection() const override { return MacroSection; }
-  StringRef getMacroDWOSection() const override { return MacroDWOSection; }
-  StringRef getMacinfoSection() const override { return MacinfoSection; }
-  StringRef getMacinfoDWOSection() const override { return MacinfoDWOSection; }
-  const DWARFSection &getPubnamesSection() const override { return PubnamesSection; }
-  const DWARFSection &getPubtypesSection() const override { return PubtypesSection; }
+    return load(RnglistsSection);
+  }
+  const DWARFSection &getMacroSection() const override {
+    return load(MacroSection);
+  }
+  StringRef getMacroDWOSection() const override {
+    return load(MacroDWOSection);
+  }
+  StringRef getMacinfoSection() const override { return load(MacinfoSection); }
+  StringRef getMacinfoDWOSection() const override {
+    return load(MacinfoDWOSection);
+  }
+  const DWARFSection &getPubnamesSection() const override {
+    return load(PubnamesSection);
+  }
+  const DWARFSection &getPubtypesSection() const override {
+    return load(PubtypesSection);
+  }
   const DWARFSection &getGnuPubnamesSection() const override {
-    return GnuPubnamesSection;
+    return load(GnuPubnamesSection);
   }
   const DWARFSection &getGnuPubtypesSection() const override {
-    return GnuPubtypesSection;
+    return load(GnuPubtypesSection);
   }
   const DWARFSection &getAppleNamesSection() const override {
-    return AppleNamesSection;
+    return load(AppleNamesSection);
   }
   const DWARFSection &getAppleTypesSection() const override {
-    return AppleTypesSection;
+    return load(AppleTypesSection);
   }
   const DWARFSection &getAppleNamespacesSection() const override {
-    return AppleNamespacesSection;
+    return load(AppleNamespacesSection);
   }
   const DWARFSection &getAppleObjCSection() const override {
-    return AppleObjCSection;
+    return load(AppleObjCSection);
   }
   const DWARFSection &getNamesSection() const override {
-    return NamesSection;
+    return load(NamesSection);
   }
 
   StringRef getFileName() const override { return FileName; }
@@ -1990,12 +2509,12 @@ public:
   void forEachInfoSections(
       function_ref<void(const DWARFSection &)> F) const override {
     for (auto &P : InfoSections)
-      F(P.second);
+      F(load(P.second));
   }
   void forEachTypesSections(
       function_ref<void(const DWARFSection &)> F) const override {
     for (auto &P : TypesSections)
-      F(P.second);
+      F(load(P.second));
   }
 };
 } // namespace
@@ -2005,23 +2524,26 @@ DWARFContext::create(const object::ObjectFile &Obj,
                      ProcessDebugRelocations RelocAction,
                      const LoadedObjectInfo *L, std::string DWPName,
                      std::function<void(Error)> RecoverableErrorHandler,
-                     std::function<void(Error)> WarningHandler) {
+                     std::function<void(Error)> WarningHandler,
+                     bool ThreadSafe) {
   auto DObj = std::make_unique<DWARFObjInMemory>(
       Obj, L, RecoverableErrorHandler, WarningHandler, RelocAction);
   return std::make_unique<DWARFContext>(std::move(DObj), std::move(DWPName),
                                         RecoverableErrorHandler,
-                                        WarningHandler);
+                                        WarningHandler, ThreadSafe);
 }
 
 std::unique_ptr<DWARFContext>
 DWARFContext::create(const StringMap<std::unique_ptr<MemoryBuffer>> &Sections,
                      uint8_t AddrSize, bool isLittleEndian,
                      std::function<void(Error)> RecoverableErrorHandler,
-                     std::function<void(Error)> WarningHandler) {
+                     std::function<void(Error)> WarningHandler,
+                     bool ThreadSafe) {
   auto DObj =
       std::make_unique<DWARFObjInMemory>(Sections, AddrSize, isLittleEndian);
-  return std::make_unique<DWARFContext>(
-      std::move(DObj), "", RecoverableErrorHandler, WarningHandler);
+  return std::make_unique<DWARFContext>(std::move(DObj), "",
+                                        RecoverableErrorHandler,
+                                        WarningHandler, ThreadSafe);
 }
 
 Error DWARFContext::loadRegisterInfo(const object::ObjectFile &Obj) {
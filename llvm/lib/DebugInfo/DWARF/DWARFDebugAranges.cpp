@@ -13,6 +13,7 @@
 #include "llvm/DebugInfo/DWARF/DWARFDebugArangeSet.h"
 #include "llvm/DebugInfo/DWARF/DWARFObject.h"
 #include "llvm/DebugInfo/DWARF/DWARFUnit.h"
+#include "llvm/Support/ThreadPool.h"
 #include <algorithm>
 #include <cassert>
 #include <cstdint>
@@ -44,7 +45,7 @@ void DWARFDebugAranges::extract(
   }
 }
 
-void DWARFDebugAranges::generate(DWARFContext *CTX) {
+void DWARFDebugAranges::generate(DWARFContext *CTX, ThreadPoolStrategy S) {
   clear();
   if (!CTX)
     return;
@@ -57,16 +58,38 @@ void DWARFDebugAranges::generate(DWARFContext *CTX) {
   // Generate aranges from DIEs: even if .debug_aranges section is present,
   // it may describe only a small subset of compilation units, so we need to
   // manually build aranges for the rest of them.
-  for (const auto &CU : CTX->compile_units()) {
-    uint64_t CUOffset = CU->getOffset();
-    if (ParsedCUOffsets.insert(CUOffset).second) {
-      Expected<DWARFAddressRangesVector> CURanges = CU->collectAddressRanges();
-      if (!CURanges)
-        CTX->getRecoverableErrorHandler()(CURanges.takeError());
-      else
-        for (const auto &R : *CURanges)
-          appendRange(CUOffset, R.LowPC, R.HighPC);
+  std::vector<DWARFUnit *> CUs;
+  for (const auto &CU : CTX->compile_units())
+    if (ParsedCUOffsets.insert(CU->getOffset()).second)
+      CUs.push_back(CU.get());
+
+  // Decoding the ranges of a unit may parse its DIEs, so do that for all
+  // units in parallel when the context allows it. The ranges are appended in
+  // unit order afterwards, which keeps the result independent of the number
+  // of threads.
+  std::vector<Optional<Expected<DWARFAddressRangesVector>>> CURanges(
+      CUs.size());
+  auto CollectRanges = [&](size_t I) {
+    CURanges[I].emplace(CUs[I]->collectAddressRanges());
+  };
+  if (CTX->isThreadSafe() && CUs.size() > 1 && S.compute_thread_count() > 1) {
+    ThreadPool Pool(S);
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      Pool.async(CollectRanges, I);
+    Pool.wait();
+  } else {
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      CollectRanges(I);
+  }
+
+  for (size_t I = 0, E = CUs.size(); I != E; ++I) {
+    Expected<DWARFAddressRangesVector> &Ranges = *CURanges[I];
+    if (!Ranges) {
+      CTX->getRecoverableErrorHandler()(Ranges.takeError());
+      continue;
     }
+    for (const auto &R : *Ranges)
+      appendRange(CUs[I]->getOffset(), R.LowPC, R.HighPC);
   }
 
   construct();
@@ -127,3 +150,22 @@ uint64_t DWARFDebugAranges::findAddress(uint64_t Address) const {
     return It->CUOffset;
   return -1ULL;
 }
+
+void DWARFDebugAranges::findAddresses(ArrayRef<uint64_t> Addresses,
+                                      MutableArrayRef<uint64_t> Result) const {
+  assert(Addresses.size() == Result.size());
+  RangeCollIterator From = Aranges.begin();
+  uint64_t Prev = 0;
+  for (size_t I = 0, E = Addresses.size(); I != E; ++I) {
+    uint64_t Address = Addresses[I];
+    // The sweep only moves forward; restart it if the input is not sorted.
+    if (Address < Prev)
+      From = Aranges.begin();
+    Prev = Address;
+    From = std::partition_point(From, Aranges.end(), [=](const Range &R) {
+      return R.HighPC() <= Address;
+    });
+    Result[I] = From != Aranges.end() && From->LowPC <= Address ? From->CUOffset
+                                                                 : -1ULL;
+  }
+}
@@ -20,12 +20,15 @@
 using namespace llvm;
 using namespace dwarf;
 
+static_assert(sizeof(DWARFDebugInfoEntry) == 16,
+              "DWARFDebugInfoEntry is expected to stay packed");
+
 bool DWARFDebugInfoEntry::extractFast(const DWARFUnit &U, uint64_t *OffsetPtr,
                                       const DWARFDataExtractor &DebugInfoData,
                                       uint64_t UEndOffset, uint32_t ParentIdx) {
-  Offset = *OffsetPtr;
+  uint64_t DIEOffset = *OffsetPtr;
   this->ParentIdx = ParentIdx;
-  if (Offset >= UEndOffset) {
+  if (DIEOffset >= UEndOffset) {
     U.getContext().getWarningHandler()(
         createStringError(errc::invalid_argument,
                           "DWARF unit from offset 0x%8.8" PRIx64 " incl. "
@@ -34,11 +37,21 @@ bool DWARFDebugInfoEntry::extractFast(const DWARFUnit &U, uint64_t *OffsetPtr,
                           U.getOffset(), U.getNextUnitOffset(), *OffsetPtr));
     return false;
   }
+  if (DIEOffset - U.getOffset() > UINT32_MAX) {
+    U.getContext().getWarningHandler()(
+        createStringError(errc::invalid_argument,
+                          "DWARF unit at offset 0x%8.8" PRIx64 " "
+                          "contains a DIE at offset 0x%8.8" PRIx64 " "
+                          "which is more than 4 GiB into the unit",
+                          U.getOffset(), DIEOffset));
+    return false;
+  }
+  Offset = DIEOffset - U.getOffset();
   assert(DebugInfoData.isValidOffset(UEndOffset - 1));
   uint64_t AbbrCode = DebugInfoData.getULEB128(OffsetPtr);
   if (0 == AbbrCode) {
     // NULL debug tag entry.
-    AbbrevDecl = nullptr;
+    AbbrevIdx = 0;
     return true;
   }
   const auto *AbbrevSet = U.getAbbreviations();
@@ -49,10 +62,11 @@ bool DWARFDebugInfoEntry::extractFast(const DWARFUnit &U, uint64_t *OffsetPtr,
                           "contains invalid abbreviation set offset 0x%" PRIx64,
                           U.getOffset(), U.getAbbreviationsOffset()));
     // Restore the original offset.
-    *OffsetPtr = Offset;
+    *OffsetPtr = DIEOffset;
     return false;
   }
-  AbbrevDecl = AbbrevSet->getAbbreviationDeclaration(AbbrCode);
+  const DWARFAbbreviationDeclaration *AbbrevDecl =
+      AbbrevSet->getAbbreviationDeclaration(AbbrCode);
   if (!AbbrevDecl) {
     U.getContext().getWarningHandler()(
         createStringError(errc::invalid_argument,
@@ -62,34 +76,25 @@ bool DWARFDebugInfoEntry::extractFast(const DWARFUnit &U, uint64_t *OffsetPtr,
                           U.getOffset(), AbbrCode, *OffsetPtr,
                           AbbrevSet->getCodeRange().c_str()));
     // Restore the original offset.
-    *OffsetPtr = Offset;
+    *OffsetPtr = DIEOffset;
     return false;
   }
-  // See if all attributes in this DIE have fixed byte sizes. If so, we can
-  // just add this size to the offset to skip to the next DIE.
-  if (Optional<size_t> FixedSize = AbbrevDecl->getFixedAttributesByteSize(U)) {
-    *OffsetPtr += *FixedSize;
+  AbbrevIdx = AbbrevSet->getAbbreviationIndex(AbbrevDecl) + 1;
+  // Skip all data in the .debug_info for the attributes. The abbreviation's
+  // skip plan only needs to look at forms with a variable size; DIEs whose
+  // attributes all have fixed byte sizes are skipped with a single addition.
+  dwarf::Form InvalidForm;
+  if (AbbrevDecl->skipAttributeValues(DebugInfoData, OffsetPtr, U,
+                                      InvalidForm))
     return true;
-  }
 
-  // Skip all data in the .debug_info for the attributes
-  for (const auto &AttrSpec : AbbrevDecl->attributes()) {
-    // Check if this attribute has a fixed byte size.
-    if (auto FixedSize = AttrSpec.getByteSize(U)) {
-      // Attribute byte size if fixed, just add the size to the offset.
-      *OffsetPtr += *FixedSize;
-    } else if (!DWARFFormValue::skipValue(AttrSpec.Form, DebugInfoData,
-                                          OffsetPtr, U.getFormParams())) {
-      // We failed to skip this attribute's value, restore the original offset
-      // and return the failure status.
-      U.getContext().getWarningHandler()(createStringError(
-          errc::invalid_argument,
-          "DWARF unit at offset 0x%8.8" PRIx64 " "
-          "contains invalid FORM_* 0x%" PRIx16 " at offset 0x%8.8" PRIx64,
-          U.getOffset(), AttrSpec.Form, *OffsetPtr));
-      *OffsetPtr = Offset;
-      return false;
-    }
-  }
-  return true;
+  // We failed to skip an attribute's value, restore the original offset
+  // and return the failure status.
+  U.getContext().getWarningHandler()(createStringError(
+      errc::invalid_argument,
+      "DWARF unit at offset 0x%8.8" PRIx64 " "
+      "contains invalid FORM_* 0x%" PRIx16 " at offset 0x%8.8" PRIx64,
+      U.getOffset(), InvalidForm, *OffsetPtr));
+  *OffsetPtr = DIEOffset;
+  return false;
 }
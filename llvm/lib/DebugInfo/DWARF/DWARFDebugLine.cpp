@@ -243,12 +243,15 @@ parseV5EntryFormat(const DWARFDataExtractor &DebugLineData, uint64_t *OffsetPtr,
   Error Err = Error::success();
   ContentDescriptors Descriptors;
   int FormatCount = DebugLineData.getU8(OffsetPtr, &Err);
+  // Each descriptor is a pair of ULEB128 values, the content type and the
+  // form, so decode them all at once.
+  SmallVector<uint64_t, 8> Fields(2 * FormatCount);
+  DebugLineData.getULEB128(OffsetPtr, Fields, &Err);
   bool HasPath = false;
   for (int I = 0; I != FormatCount && !Err; ++I) {
     ContentDescriptor Descriptor;
-    Descriptor.Type =
-        dwarf::LineNumberEntryFormat(DebugLineData.getULEB128(OffsetPtr, &Err));
-    Descriptor.Form = dwarf::Form(DebugLineData.getULEB128(OffsetPtr, &Err));
+    Descriptor.Type = dwarf::LineNumberEntryFormat(Fields[2 * I]);
+    Descriptor.Form = dwarf::Form(Fields[2 * I + 1]);
     if (Descriptor.Type == dwarf::DW_LNCT_path)
       HasPath = true;
     if (ContentTypes)
@@ -540,6 +543,13 @@ void DWARFDebugLine::LineTable::clear() {
   Sequences.clear();
 }
 
+size_t DWARFDebugLine::LineTable::getMemoryUsage() const {
+  return sizeof(LineTable) + Rows.capacity() * sizeof(Row) +
+         Sequences.capacity() * sizeof(Sequence) +
+         Prologue.IncludeDirectories.capacity() * sizeof(DWARFFormValue) +
+         Prologue.FileNames.capacity() * sizeof(FileNameEntry);
+}
+
 DWARFDebugLine::ParsingState::ParsingState(
     struct LineTable *LT, uint64_t TableOffset,
     function_ref<void(Error)> ErrorHandler)
@@ -601,6 +611,11 @@ Expected<const DWARFDebugLine::LineTable *> DWARFDebugLine::getOrParseLineTable(
   return LT;
 }
 
+const DWARFDebugLine::LineTable *
+DWARFDebugLine::addLineTable(uint64_t Offset, LineTable Table) {
+  return &LineTableMap.emplace(Offset, std::move(Table)).first->second;
+}
+
 static StringRef getOpcodeName(uint8_t Opcode, uint8_t OpcodeBase) {
   assert(Opcode != 0);
   if (Opcode < OpcodeBase)
@@ -1266,6 +1281,59 @@ uint32_t DWARFDebugLine::LineTable::lookupAddressImpl(
   return findRowInSeq(*It, Address);
 }
 
+void DWARFDebugLine::LineTable::lookupAddresses(
+    ArrayRef<object::SectionedAddress> Addresses,
+    MutableArrayRef<uint32_t> Result) const {
+  assert(Addresses.size() == Result.size());
+  // Sequences are sorted by section index and high PC, and rows within a
+  // sequence by address, so for sorted input both the sequence and the row
+  // searches can start where the previous address was found.
+  SequenceIter SeqPos = Sequences.begin();
+  SequenceIter RowSeq = Sequences.end();
+  RowIter RowFrom = Rows.begin();
+  object::SectionedAddress Prev = {0, 0};
+  for (size_t I = 0, E = Addresses.size(); I != E; ++I) {
+    object::SectionedAddress Address = Addresses[I];
+    // The sweep only moves forward; restart it if the input is not sorted.
+    if (std::tie(Address.SectionIndex, Address.Address) <
+        std::tie(Prev.SectionIndex, Prev.Address)) {
+      SeqPos = Sequences.begin();
+      RowSeq = Sequences.end();
+    }
+    Prev = Address;
+
+    DWARFDebugLine::Sequence Sequence;
+    Sequence.SectionIndex = Address.SectionIndex;
+    Sequence.HighPC = Address.Address;
+    SeqPos = std::upper_bound(SeqPos, Sequences.end(), Sequence,
+                              DWARFDebugLine::Sequence::orderByHighPC);
+    if (SeqPos == Sequences.end() || !SeqPos->containsPC(Address)) {
+      // Fall back to absolute addresses, as lookupAddress() does.
+      Result[I] =
+          Address.SectionIndex == object::SectionedAddress::UndefSection
+              ? UnknownRowIndex
+              : lookupAddressImpl(
+                    {Address.Address, object::SectionedAddress::UndefSection});
+      continue;
+    }
+
+    if (SeqPos != RowSeq) {
+      RowSeq = SeqPos;
+      RowFrom = Rows.begin() + SeqPos->FirstRowIndex + 1;
+    }
+    // As in findRowInSeq(), we want the last row whose address is less than or
+    // equal to Address.
+    DWARFDebugLine::Row Row;
+    Row.Address = Address;
+    RowIter RowPos =
+        std::upper_bound(RowFrom, Rows.begin() + SeqPos->LastRowIndex - 1, Row,
+                         DWARFDebugLine::Row::orderByAddress) -
+        1;
+    RowFrom = RowPos + 1;
+    Result[I] = RowPos - Rows.begin();
+  }
+}
+
 bool DWARFDebugLine::LineTable::lookupAddressRange(
     object::SectionedAddress Address, uint64_t Size,
     std::vector<uint32_t> &Result) const {
@@ -1403,7 +1471,12 @@ bool DWARFDebugLine::LineTable::getFileLineInfoForAddress(
     object::SectionedAddress Address, const char *CompDir,
     FileLineInfoKind Kind, DILineInfo &Result) const {
   // Get the index of row we're looking for in the line table.
-  uint32_t RowIndex = lookupAddress(Address);
+  return getFileLineInfoForRow(lookupAddress(Address), CompDir, Kind, Result);
+}
+
+bool DWARFDebugLine::LineTable::getFileLineInfoForRow(
+    uint32_t RowIndex, const char *CompDir, FileLineInfoKind Kind,
+    DILineInfo &Result) const {
   if (RowIndex == -1U)
     return false;
   // Take file number and line/column from the row.
@@ -0,0 +1,425 @@
+//===- DWARFDebugNamesBuilder.cpp -----------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/DWARF/DWARFDebugNamesBuilder.h"
+#include "llvm/ADT/DenseMap.h"
+#include "llvm/ADT/STLExtras.h"
+#include "llvm/ADT/SmallVector.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/BinaryFormat/Dwarf.h"
+#include "llvm/DebugInfo/DWARF/DWARFCompileUnit.h"
+#include "llvm/DebugInfo/DWARF/DWARFContext.h"
+#include "llvm/DebugInfo/DWARF/DWARFDie.h"
+#include "llvm/DebugInfo/DWARF/DWARFExpression.h"
+#include "llvm/DebugInfo/DWARF/DWARFUnit.h"
+#include "llvm/Support/DJB.h"
+#include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/EndianStream.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/LEB128.h"
+#include "llvm/Support/SmallVectorMemoryBuffer.h"
+#include "llvm/Support/ThreadPool.h"
+#include "llvm/Support/raw_ostream.h"
+#include "llvm/Support/xxhash.h"
+#include <algorithm>
+#include <numeric>
+#include <vector>
+
+using namespace llvm;
+using namespace dwarf;
+
+// The index buffer starts with a header identifying the object it was built
+// for, followed by the .debug_names contents and the string section. All
+// header fields are little-endian.
+static const char IndexMagic[8] = {'L', 'L', 'V', 'M', 'D', 'N', 'A', 'M'};
+static const uint32_t IndexVersion = 2;
+// Magic, version, padding, and the hash of the debug sections, compile unit
+// count, .debug_names size and string section size.
+static const uint64_t IndexHeaderSize = 8 + 4 + 4 + 4 * 8;
+
+namespace {
+
+/// A DIE indexed under a name.
+struct NameEntry {
+  StringRef Name;
+  uint32_t CUIndex;
+  uint32_t DIEOffset;
+  Tag DIETag;
+};
+
+/// Identifies the object an index is built for.
+struct ObjectSummary {
+  uint64_t SectionsHash = 0;
+  uint64_t NumCompileUnits = 0;
+};
+
+} // end anonymous namespace
+
+static ObjectSummary getObjectSummary(DWARFContext &Context) {
+  // Hash the contents of every section the index is derived from: the DIEs,
+  // their abbreviations, the strings they refer to and the locations
+  // isVariableIndexable looks at. Objects that only agree in section sizes,
+  // e.g. two builds of the same source, then get different summaries.
+  SmallVector<uint64_t, 16> Hashes;
+  auto AddSection = [&](StringRef Data) {
+    Hashes.push_back(Data.size());
+    Hashes.push_back(xxHash64(Data));
+  };
+  const DWARFObject &DObj = Context.getDWARFObj();
+  DObj.forEachInfoSections([&](const DWARFSection &S) { AddSection(S.Data); });
+  AddSection(DObj.getAbbrevSection());
+  AddSection(DObj.getStrSection());
+  AddSection(DObj.getStrOffsetsSection().Data);
+  AddSection(DObj.getAddrSection().Data);
+  AddSection(DObj.getLocSection().Data);
+  AddSection(DObj.getLoclistsSection().Data);
+
+  ObjectSummary Summary;
+  Summary.SectionsHash = xxHash64(
+      StringRef(reinterpret_cast<const char *>(Hashes.data()),
+                Hashes.size() * sizeof(uint64_t)));
+  Summary.NumCompileUnits = Context.getNumCompileUnits();
+  return Summary;
+}
+
+static bool isVariableIndexable(const DWARFDie &Die) {
+  Expected<std::vector<DWARFLocationExpression>> Loc =
+      Die.getLocations(DW_AT_location);
+  if (!Loc) {
+    consumeError(Loc.takeError());
+    return false;
+  }
+  DWARFUnit *U = Die.getDwarfUnit();
+  for (const auto &Entry : *Loc) {
+    DataExtractor Data(toStringRef(Entry.Expr),
+                       U->getContext().isLittleEndian(),
+                       U->getAddressByteSize());
+    DWARFExpression Expression(Data, U->getAddressByteSize(),
+                               U->getFormParams().Format);
+    if (any_of(Expression, [](const DWARFExpression::Operation &Op) {
+          return !Op.isError() && (Op.getCode() == DW_OP_addr ||
+                                   Op.getCode() == DW_OP_form_tls_address ||
+                                   Op.getCode() == DW_OP_GNU_push_tls_address);
+        }))
+      return true;
+  }
+  return false;
+}
+
+void DWARFDebugNamesBuilder::getIndexedNames(
+    const DWARFDie &Die, SmallVectorImpl<StringRef> &Names) {
+  // Exclude the tags which DWARFVerifier does not expect to be indexed.
+  Tag DieTag = Die.getTag();
+  switch (DieTag) {
+  case DW_TAG_null:
+  case DW_TAG_compile_unit:
+  case DW_TAG_module:
+  case DW_TAG_formal_parameter:
+  case DW_TAG_template_value_parameter:
+  case DW_TAG_template_type_parameter:
+  case DW_TAG_GNU_template_parameter_pack:
+  case DW_TAG_GNU_template_template_param:
+  case DW_TAG_member:
+  case DW_TAG_enumerator:
+  case DW_TAG_imported_declaration:
+    return;
+  default:
+    break;
+  }
+
+  // "All non-defining declarations (that is, debugging information entries
+  // with a DW_AT_declaration attribute) are excluded."
+  if (Die.find(DW_AT_declaration))
+    return;
+
+  // "DW_TAG_namespace debugging information entries without a DW_AT_name
+  // attribute are included with the name “(anonymous namespace)”."
+  // "If a subprogram or inlined subroutine is included, and has a
+  // DW_AT_linkage_name attribute, there will be an additional index entry for
+  // the linkage name."
+  SmallVector<StringRef, 2> DieNames;
+  if (const char *Str = Die.getShortName())
+    DieNames.emplace_back(Str);
+  else if (DieTag == DW_TAG_namespace)
+    DieNames.emplace_back("(anonymous namespace)");
+  if (DieTag == DW_TAG_subprogram || DieTag == DW_TAG_inlined_subroutine)
+    if (const char *Str = Die.getLinkageName())
+      DieNames.emplace_back(Str);
+  if (DieNames.empty())
+    return;
+
+  switch (DieTag) {
+  // "DW_TAG_subprogram, DW_TAG_inlined_subroutine, and DW_TAG_label debugging
+  // information entries without an address attribute (DW_AT_low_pc,
+  // DW_AT_high_pc, DW_AT_ranges, or DW_AT_entry_pc) are excluded."
+  case DW_TAG_subprogram:
+  case DW_TAG_inlined_subroutine:
+  case DW_TAG_label:
+    if (!Die.findRecursively(
+            {DW_AT_low_pc, DW_AT_high_pc, DW_AT_ranges, DW_AT_entry_pc}))
+      return;
+    break;
+  // "DW_TAG_variable debugging information entries with a DW_AT_location
+  // attribute that includes a DW_OP_addr or DW_OP_form_tls_address operator
+  // are included; otherwise, they are excluded."
+  case DW_TAG_variable:
+    if (!isVariableIndexable(Die))
+      return;
+    break;
+  default:
+    break;
+  }
+  Names.append(DieNames.begin(), DieNames.end());
+}
+
+/// Collect the indexed names of the DIEs of \p CU, or of its split unit if it
+/// is a skeleton unit.
+static Error collectUnitNames(DWARFCompileUnit &CU, uint32_t CUIndex,
+                              std::vector<NameEntry> &Entries) {
+  DWARFUnit *U = CU.getNonSkeletonUnitDIE().getDwarfUnit();
+  if (!U)
+    return Error::success();
+  if (Error E = U->tryExtractDIEsIfNeeded(/*CUDieOnly=*/false))
+    return E;
+
+  SmallVector<StringRef, 2> Names;
+  for (const DWARFDebugInfoEntry &Entry : U->dies()) {
+    DWARFDie Die(U, &Entry);
+    Names.clear();
+    DWARFDebugNamesBuilder::getIndexedNames(Die, Names);
+    for (StringRef Name : Names)
+      Entries.push_back(
+          {Name, CUIndex, Entry.getUnitRelativeOffset(), Die.getTag()});
+  }
+  return Error::success();
+}
+
+/// Returns the bucket count for \p NumHashes unique hashes, the same way as
+/// the accelerator tables emitted by the AsmPrinter.
+static uint32_t getBucketCount(uint32_t NumHashes) {
+  if (NumHashes > 1024)
+    return NumHashes / 4;
+  if (NumHashes > 16)
+    return NumHashes / 2;
+  return std::max<uint32_t>(NumHashes, 1);
+}
+
+std::unique_ptr<MemoryBuffer>
+DWARFDebugNamesBuilder::build(DWARFContext &Context, ThreadPoolStrategy S) {
+  std::vector<DWARFCompileUnit *> CUs;
+  for (const auto &U : Context.compile_units())
+    CUs.push_back(cast<DWARFCompileUnit>(U.get()));
+
+  // Collect the names of each unit, then report problems from this thread and
+  // in a deterministic order.
+  std::vector<std::vector<NameEntry>> UnitEntries(CUs.size());
+  std::vector<Error> UnitErrors;
+  UnitErrors.reserve(CUs.size());
+  for (size_t I = 0, E = CUs.size(); I != E; ++I)
+    UnitErrors.push_back(Error::success());
+  auto CollectUnit = [&](size_t I) {
+    UnitErrors[I] = joinErrors(std::move(UnitErrors[I]),
+                               collectUnitNames(*CUs[I], I, UnitEntries[I]));
+  };
+  if (Context.isThreadSafe() && S.compute_thread_count() > 1) {
+    ThreadPool Pool(S);
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      Pool.async(CollectUnit, I);
+    Pool.wait();
+  } else {
+    for (size_t I = 0, E = CUs.size(); I != E; ++I)
+      CollectUnit(I);
+  }
+  for (Error &Err : UnitErrors)
+    if (Err)
+      Context.getRecoverableErrorHandler()(std::move(Err));
+
+  // Unique the names in order of first appearance, so that the index only
+  // depends on the object.
+  struct IndexedName {
+    StringRef Name;
+    uint32_t Hash;
+    uint64_t StringOffset;
+    uint64_t EntryOffset = 0;
+    std::vector<const NameEntry *> Entries;
+  };
+  std::vector<IndexedName> Names;
+  StringMap<uint32_t> NameIndices;
+  SmallString<0> StrSection;
+  for (const std::vector<NameEntry> &Entries : UnitEntries)
+    for (const NameEntry &Entry : Entries) {
+      auto Inserted = NameIndices.try_emplace(Entry.Name, Names.size());
+      if (Inserted.second) {
+        Names.push_back({Entry.Name, caseFoldingDjbHash(Entry.Name),
+                         StrSection.size(), /*EntryOffset=*/0, {}});
+        StrSection += Entry.Name;
+        StrSection.push_back('\0');
+      }
+      Names[Inserted.first->second].Entries.push_back(&Entry);
+    }
+
+  // Sort the names into hash buckets.
+  std::vector<uint32_t> Hashes;
+  Hashes.reserve(Names.size());
+  for (const IndexedName &Name : Names)
+    Hashes.push_back(Name.Hash);
+  llvm::sort(Hashes);
+  uint32_t BucketCount = getBucketCount(
+      std::unique(Hashes.begin(), Hashes.end()) - Hashes.begin());
+  std::vector<uint32_t> Order(Names.size());
+  std::iota(Order.begin(), Order.end(), 0);
+  llvm::stable_sort(Order, [&](uint32_t LHS, uint32_t RHS) {
+    return Names[LHS].Hash % BucketCount < Names[RHS].Hash % BucketCount;
+  });
+
+  // Emit the entry pool, with one abbreviation per tag.
+  DenseMap<unsigned, uint32_t> AbbrevCodes;
+  std::vector<Tag> AbbrevTags;
+  SmallString<0> EntryPool;
+  raw_svector_ostream PoolOS(EntryPool);
+  support::endian::Writer PoolWriter(PoolOS, support::little);
+  for (uint32_t Idx : Order) {
+    IndexedName &Name = Names[Idx];
+    Name.EntryOffset = EntryPool.size();
+    for (const NameEntry *Entry : Name.Entries) {
+      auto Code = AbbrevCodes.try_emplace(Entry->DIETag, AbbrevTags.size() + 1);
+      if (Code.second)
+        AbbrevTags.push_back(Entry->DIETag);
+      encodeULEB128(Code.first->second, PoolOS);
+      encodeULEB128(Entry->CUIndex, PoolOS);
+      PoolWriter.write<uint32_t>(Entry->DIEOffset);
+    }
+    encodeULEB128(0, PoolOS);
+  }
+
+  SmallString<0> AbbrevTable;
+  raw_svector_ostream AbbrevOS(AbbrevTable);
+  for (size_t I = 0, E = AbbrevTags.size(); I != E; ++I) {
+    encodeULEB128(I + 1, AbbrevOS);
+    encodeULEB128(AbbrevTags[I], AbbrevOS);
+    encodeULEB128(DW_IDX_compile_unit, AbbrevOS);
+    encodeULEB128(DW_FORM_udata, AbbrevOS);
+    encodeULEB128(DW_IDX_die_offset, AbbrevOS);
+    encodeULEB128(DW_FORM_ref4, AbbrevOS);
+    encodeULEB128(0, AbbrevOS);
+    encodeULEB128(0, AbbrevOS);
+  }
+  encodeULEB128(0, AbbrevOS);
+
+  // Only switch to DWARF64 if some offset does not fit into 32 bits.
+  DwarfFormat Format = DWARF32;
+  if ((!CUs.empty() && CUs.back()->getOffset() > UINT32_MAX) ||
+      StrSection.size() > UINT32_MAX || EntryPool.size() > UINT32_MAX)
+    Format = DWARF64;
+  uint64_t OffsetSize = getDwarfOffsetByteSize(Format);
+  uint64_t NameCount = Names.size();
+
+  SmallString<0> NamesSection;
+  raw_svector_ostream NamesOS(NamesSection);
+  support::endian::Writer W(NamesOS, support::little);
+  auto WriteOffset = [&](uint64_t Offset) {
+    if (Format == DWARF64)
+      W.write<uint64_t>(Offset);
+    else
+      W.write<uint32_t>(Offset);
+  };
+  if (!CUs.empty()) {
+    // The header after the unit length, the CU list, the buckets, the hashes,
+    // the string and entry offsets, the abbreviations and the entry pool.
+    uint64_t UnitLength = 2 + 2 + 7 * 4 + CUs.size() * OffsetSize +
+                          BucketCount * 4 + NameCount * 4 +
+                          NameCount * OffsetSize * 2 + AbbrevTable.size() +
+                          EntryPool.size();
+    if (Format == DWARF64) {
+      W.write<uint32_t>(dwarf::DW_LENGTH_DWARF64);
+      W.write<uint64_t>(UnitLength);
+    } else {
+      W.write<uint32_t>(UnitLength);
+    }
+    W.write<uint16_t>(5); // Version
+    W.write<uint16_t>(0); // Padding
+    W.write<uint32_t>(CUs.size());
+    W.write<uint32_t>(0); // Local type units
+    W.write<uint32_t>(0); // Foreign type units
+    W.write<uint32_t>(BucketCount);
+    W.write<uint32_t>(NameCount);
+    W.write<uint32_t>(AbbrevTable.size());
+    W.write<uint32_t>(0); // Augmentation string size
+
+    for (DWARFCompileUnit *CU : CUs)
+      WriteOffset(CU->getOffset());
+
+    // Each bucket holds the 1-based position of its first name, or 0.
+    std::vector<uint32_t> Buckets(BucketCount, 0);
+    for (size_t I = Order.size(); I != 0; --I)
+      Buckets[Names[Order[I - 1]].Hash % BucketCount] = I;
+    for (uint32_t Bucket : Buckets)
+      W.write<uint32_t>(Bucket);
+    for (uint32_t Idx : Order)
+      W.write<uint32_t>(Names[Idx].Hash);
+    for (uint32_t Idx : Order)
+      WriteOffset(Names[Idx].StringOffset);
+    for (uint32_t Idx : Order)
+      WriteOffset(Names[Idx].EntryOffset);
+    NamesOS << AbbrevTable << EntryPool;
+  }
+
+  ObjectSummary Summary = getObjectSummary(Context);
+  SmallString<0> Index;
+  raw_svector_ostream IndexOS(Index);
+  support::endian::Writer IndexWriter(IndexOS, support::little);
+  IndexOS.write(IndexMagic, sizeof(IndexMagic));
+  IndexWriter.write<uint32_t>(IndexVersion);
+  IndexWriter.write<uint32_t>(0);
+  IndexWriter.write<uint64_t>(Summary.SectionsHash);
+  IndexWriter.write<uint64_t>(Summary.NumCompileUnits);
+  IndexWriter.write<uint64_t>(NamesSection.size());
+  IndexWriter.write<uint64_t>(StrSection.size());
+  assert(Index.size() == IndexHeaderSize);
+  IndexOS << NamesSection << StrSection;
+  return std::make_unique<SmallVectorMemoryBuffer>(
+      std::move(Index), "<debug names index>",
+      /*RequiresNullTerminator=*/false);
+}
+
+Expected<std::pair<StringRef, StringRef>>
+DWARFDebugNamesBuilder::getSections(DWARFContext &Context,
+                                    MemoryBufferRef Index) {
+  auto Malformed = [&](const Twine &Reason) {
+    return createStringError(errc::invalid_argument,
+                             "invalid name index '" +
+                                 Index.getBufferIdentifier() +
+                                 "': " + Reason);
+  };
+
+  StringRef Data = Index.getBuffer();
+  if (Data.size() < IndexHeaderSize)
+    return Malformed("truncated header");
+  if (!Data.startswith(StringRef(IndexMagic, sizeof(IndexMagic))))
+    return Malformed("bad magic");
+  DataExtractor Header(Data.take_front(IndexHeaderSize),
+                       /*IsLittleEndian=*/true, /*AddressSize=*/0);
+  uint64_t Offset = sizeof(IndexMagic);
+  uint32_t Version = Header.getU32(&Offset);
+  if (Version != IndexVersion)
+    return Malformed("unsupported version " + Twine(Version));
+  Offset += 4;
+  ObjectSummary Summary = getObjectSummary(Context);
+  if (Header.getU64(&Offset) != Summary.SectionsHash ||
+      Header.getU64(&Offset) != Summary.NumCompileUnits)
+    return Malformed("built for a different object");
+  uint64_t NamesSize = Header.getU64(&Offset);
+  uint64_t StrSize = Header.getU64(&Offset);
+  uint64_t Remaining = Data.size() - IndexHeaderSize;
+  if (NamesSize > Remaining || StrSize != Remaining - NamesSize)
+    return Malformed("bad section sizes");
+  if (StrSize != 0 && Data.back() != '\0')
+    return Malformed("unterminated string section");
+  StringRef Names = Data.substr(IndexHeaderSize, NamesSize);
+  return std::make_pair(Names, Data.take_back(StrSize));
+}
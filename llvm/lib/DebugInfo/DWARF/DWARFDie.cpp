@@ -815,6 +815,17 @@ void DWARFDie::getFullName(raw_string_ostream &OS,
   dumpTypeUnqualifiedName(*this, OS, OriginalFullName);
 }
 
+const DWARFAbbreviationDeclaration *
+DWARFDie::getAbbreviationDeclarationPtr() const {
+  assert(isValid() && "must check validity prior to calling");
+  return U->getDIEAbbreviationDeclaration(*Die);
+}
+
+uint64_t DWARFDie::getOffset() const {
+  assert(isValid() && "must check validity prior to calling");
+  return U->getDIEOffset(*Die);
+}
+
 bool DWARFDie::isSubprogramDIE() const { return getTag() == DW_TAG_subprogram; }
 
 bool DWARFDie::isSubroutineDIE() const {
@@ -442,7 +442,7 @@ void DWARFUnit::extractDIEsToVector(
 
     // Check for new children scope.
     if (const DWARFAbbreviationDeclaration *AbbrDecl =
-            DIE.getAbbreviationDeclarationPtr()) {
+            getDIEAbbreviationDeclaration(DIE)) {
       if (AbbrDecl->hasChildren()) {
         if (AppendCUDie || !IsCUDie) {
           assert(Dies.size() > 0 && "Dies does not contain any die");
@@ -471,6 +471,27 @@ void DWARFUnit::extractDIEsIfNeeded(bool CUDieOnly) {
 }
 
 Error DWARFUnit::tryExtractDIEsIfNeeded(bool CUDieOnly) {
+  if (!Context.isThreadSafe()) {
+    Error Err = tryExtractDIEsIfNeededImpl(CUDieOnly);
+    // Only the full DIE array counts towards the context's memory budget;
+    // the unit DIE is never released.
+    if (!CUDieOnly)
+      Context.recordUnitAccess(*this);
+    return Err;
+  }
+
+  // Extract the whole unit in one step: growing DieArray from the unit DIE
+  // to all DIEs would reallocate it underneath DWARFDie handles held by
+  // other threads.
+  Error Err = Error::success();
+  llvm::call_once(ExtractDIEsOnce, [&] {
+    Err = joinErrors(std::move(Err),
+                     tryExtractDIEsIfNeededImpl(/*CUDieOnly=*/false));
+  });
+  return Err;
+}
+
+Error DWARFUnit::tryExtractDIEsIfNeededImpl(bool CUDieOnly) {
   if ((CUDieOnly && !DieArray.empty()) ||
       DieArray.size() > 1)
     return Error::success(); // Already parsed.
@@ -575,6 +596,15 @@ Error DWARFUnit::tryExtractDIEsIfNeeded(bool CUDieOnly) {
 }
 
 bool DWARFUnit::parseDWO() {
+  if (!Context.isThreadSafe())
+    return parseDWOImpl();
+
+  bool Parsed = false;
+  llvm::call_once(DWOOnce, [&] { Parsed = parseDWOImpl(); });
+  return Parsed;
+}
+
+bool DWARFUnit::parseDWOImpl() {
   if (IsDWO)
     return false;
   if (DWO.get())
@@ -628,6 +658,20 @@ void DWARFUnit::clearDIEs(bool KeepCUDie) {
                  : std::vector<DWARFDebugInfoEntry>();
 }
 
+void DWARFUnit::releaseDIEs() {
+  assert(!Context.isThreadSafe() &&
+         "DIEs of a thread-safe context cannot be released");
+  clearDIEs(/*KeepCUDie=*/true);
+  AddrDieLowPCs = std::vector<uint64_t>();
+  AddrDieRanges = std::vector<AddrDieRange>();
+}
+
+size_t DWARFUnit::getDIEMemoryUsage() const {
+  return DieArray.capacity() * sizeof(DWARFDebugInfoEntry) +
+         AddrDieLowPCs.capacity() * sizeof(uint64_t) +
+         AddrDieRanges.capacity() * sizeof(AddrDieRange);
+}
+
 Expected<DWARFAddressRangesVector>
 DWARFUnit::findRnglistFromOffset(uint64_t Offset) {
   if (getVersion() <= 4) {
@@ -694,49 +738,83 @@ DWARFUnit::findLoclistFromOffset(uint64_t Offset) {
   return Result;
 }
 
-void DWARFUnit::updateAddressDieMap(DWARFDie Die) {
-  if (Die.isSubroutineDIE()) {
+void DWARFUnit::buildAddressDieIndex() {
+  struct SubroutineRange {
+    uint64_t LowPC;
+    uint64_t HighPC;
+    uint32_t DieIdx;
+  };
+
+  // DieArray is in pre-order, so a subroutine DIE always comes after the
+  // subroutine DIEs enclosing it. The stable sort keeps that order for ranges
+  // starting at the same address.
+  std::vector<SubroutineRange> Ranges;
+  for (const DWARFDebugInfoEntry &Entry : DieArray) {
+    DWARFDie Die(this, &Entry);
+    if (!Die.isSubroutineDIE())
+      continue;
     auto DIERangesOrError = Die.getAddressRanges();
-    if (DIERangesOrError) {
-      for (const auto &R : DIERangesOrError.get()) {
-        // Ignore 0-sized ranges.
-        if (R.LowPC == R.HighPC)
-          continue;
-        auto B = AddrDieMap.upper_bound(R.LowPC);
-        if (B != AddrDieMap.begin() && R.LowPC < (--B)->second.first) {
-          // The range is a sub-range of existing ranges, we need to split the
-          // existing range.
-          if (R.HighPC < B->second.first)
-            AddrDieMap[R.HighPC] = B->second;
-          if (R.LowPC > B->first)
-            AddrDieMap[B->first].first = R.LowPC;
-        }
-        AddrDieMap[R.LowPC] = std::make_pair(R.HighPC, Die);
-      }
-    } else
+    if (!DIERangesOrError) {
       llvm::consumeError(DIERangesOrError.takeError());
+      continue;
+    }
+    for (const auto &R : DIERangesOrError.get())
+      // Ignore 0-sized ranges.
+      if (R.LowPC < R.HighPC)
+        Ranges.push_back({R.LowPC, R.HighPC, getDIEIndex(&Entry)});
   }
-  // Parent DIEs are added to the AddrDieMap prior to the Children DIEs to
-  // simplify the logic to update AddrDieMap. The child's range will always
-  // be equal or smaller than the parent's range. With this assumption, when
-  // adding one range into the map, it will at most split a range into 3
-  // sub-ranges.
-  for (DWARFDie Child = Die.getFirstChild(); Child; Child = Child.getSibling())
-    updateAddressDieMap(Child);
+  llvm::stable_sort(Ranges,
+                    [](const SubroutineRange &LHS, const SubroutineRange &RHS) {
+                      return LHS.LowPC < RHS.LowPC;
+                    });
+
+  // Sweep the ranges in address order, keeping the ranges covering the
+  // current address on a stack. The innermost range is on top and owns the
+  // addresses up to the next range boundary.
+  SmallVector<const SubroutineRange *, 8> Open;
+  uint64_t Cur = 0;
+  auto EmitUpTo = [&](uint64_t End) {
+    if (Open.empty() || Cur >= End)
+      return;
+    uint32_t DieIdx = Open.back()->DieIdx;
+    if (!AddrDieRanges.empty() && AddrDieRanges.back().HighPC == Cur &&
+        AddrDieRanges.back().DieIdx == DieIdx) {
+      AddrDieRanges.back().HighPC = End;
+    } else {
+      AddrDieLowPCs.push_back(Cur);
+      AddrDieRanges.push_back({End, DieIdx});
+    }
+    Cur = End;
+  };
+  auto CloseUpTo = [&](uint64_t Address) {
+    while (!Open.empty() && Open.back()->HighPC <= Address) {
+      EmitUpTo(Open.back()->HighPC);
+      Open.pop_back();
+    }
+  };
+  for (const SubroutineRange &R : Ranges) {
+    CloseUpTo(R.LowPC);
+    EmitUpTo(R.LowPC);
+    Cur = R.LowPC;
+    Open.push_back(&R);
+  }
+  CloseUpTo(UINT64_MAX);
 }
 
 DWARFDie DWARFUnit::getSubroutineForAddress(uint64_t Address) {
   extractDIEsIfNeeded(false);
-  if (AddrDieMap.empty())
-    updateAddressDieMap(getUnitDIE());
-  auto R = AddrDieMap.upper_bound(Address);
-  if (R == AddrDieMap.begin())
+  if (Context.isThreadSafe())
+    llvm::call_once(AddrDieIndexOnce, [&] { buildAddressDieIndex(); });
+  else if (AddrDieLowPCs.empty())
+    buildAddressDieIndex();
+  auto R = llvm::upper_bound(AddrDieLowPCs, Address);
+  if (R == AddrDieLowPCs.begin())
     return DWARFDie();
   // upper_bound's previous item contains Address.
-  --R;
-  if (Address >= R->second.first)
+  const AddrDieRange &Range = AddrDieRanges[R - AddrDieLowPCs.begin() - 1];
+  if (Address >= Range.HighPC)
     return DWARFDie();
-  return R->second.second;
+  return DWARFDie(this, &DieArray[Range.DieIdx]);
 }
 
 void
@@ -826,7 +904,7 @@ DWARFDie DWARFUnit::getPreviousSibling(const DWARFDebugInfoEntry *Die) {
 }
 
 DWARFDie DWARFUnit::getFirstChild(const DWARFDebugInfoEntry *Die) {
-  if (!Die->hasChildren())
+  if (!DWARFDie(this, Die).hasChildren())
     return DWARFDie();
 
   // TODO: Instead of checking here for invalid die we might reject
@@ -839,14 +917,13 @@ DWARFDie DWARFUnit::getFirstChild(const DWARFDebugInfoEntry *Die) {
 }
 
 DWARFDie DWARFUnit::getLastChild(const DWARFDebugInfoEntry *Die) {
-  if (!Die->hasChildren())
+  if (!DWARFDie(this, Die).hasChildren())
     return DWARFDie();
 
   if (Optional<uint32_t> SiblingIdx = Die->getSiblingIdx()) {
     assert(*SiblingIdx < DieArray.size() &&
            "SiblingIdx is out of DieArray boundaries");
-    assert(DieArray[*SiblingIdx - 1].getTag() == dwarf::DW_TAG_null &&
-           "Bad end of children marker");
+    assert(DieArray[*SiblingIdx - 1].isNULL() && "Bad end of children marker");
     return DWARFDie(this, &DieArray[*SiblingIdx - 1]);
   }
 
@@ -860,7 +937,7 @@ DWARFDie DWARFUnit::getLastChild(const DWARFDebugInfoEntry *Die) {
   // TODO: Instead of checking here for invalid die we might reject
   // invalid dies at parsing stage(DWARFUnit::extractDIEsToVector).
   if (getDIEIndex(Die) == 0 && DieArray.size() > 1 &&
-      DieArray.back().getTag() == dwarf::DW_TAG_null) {
+      DieArray.back().isNULL()) {
     // For the unit die we might take last item from DieArray.
     assert(getDIEIndex(Die) == getDIEIndex(getUnitDIE()) && "Bad unit die");
     return DWARFDie(this, &DieArray.back());
@@ -870,18 +947,30 @@ DWARFDie DWARFUnit::getLastChild(const DWARFDebugInfoEntry *Die) {
 }
 
 const DWARFAbbreviationDeclarationSet *DWARFUnit::getAbbreviations() const {
+  if (Context.isThreadSafe()) {
+    // DWARFDebugAbbrev caches its last lookup, so serialize access to it.
+    llvm::call_once(AbbrevsOnce, [&] {
+      auto Lock = Context.lockIfThreadSafe();
+      Abbrevs =
+          Abbrev->getAbbreviationDeclarationSet(getAbbreviationsOffset());
+    });
+    return Abbrevs;
+  }
   if (!Abbrevs)
     Abbrevs = Abbrev->getAbbreviationDeclarationSet(getAbbreviationsOffset());
   return Abbrevs;
 }
 
 llvm::Optional<object::SectionedAddress> DWARFUnit::getBaseAddress() {
-  if (BaseAddr)
-    return BaseAddr;
-
-  DWARFDie UnitDie = getUnitDIE();
-  Optional<DWARFFormValue> PC = UnitDie.find({DW_AT_low_pc, DW_AT_entry_pc});
-  BaseAddr = toSectionedAddress(PC);
+  auto ComputeBaseAddress = [&] {
+    DWARFDie UnitDie = getUnitDIE();
+    Optional<DWARFFormValue> PC = UnitDie.find({DW_AT_low_pc, DW_AT_entry_pc});
+    BaseAddr = toSectionedAddress(PC);
+  };
+  if (Context.isThreadSafe())
+    llvm::call_once(BaseAddrOnce, ComputeBaseAddress);
+  else if (!BaseAddr)
+    ComputeBaseAddress();
   return BaseAddr;
 }
 
@@ -28,9 +28,11 @@
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FormatVariadic.h"
+#include "llvm/Support/MathExtras.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
 #include <map>
+#include <numeric>
 #include <set>
 #include <vector>
 
@@ -42,6 +44,9 @@ namespace llvm {
 class DWARFDebugInfoEntry;
 }
 
+/// Number of reference targets or names checked by one parallel task.
+static const size_t ItemsPerTask = 1024;
+
 Optional<DWARFAddressRange>
 DWARFVerifier::DieRangeInfo::insert(const DWARFAddressRange &R) {
   auto Begin = Ranges.begin();
@@ -333,22 +338,32 @@ bool DWARFVerifier::handleDebugAbbrev() {
 }
 
 unsigned DWARFVerifier::verifyUnits(const DWARFUnitVector &Units) {
-  unsigned NumDebugInfoErrors = 0;
-  ReferenceMap CrossUnitReferences;
+  // The references into other units are collected per unit and merged once
+  // all units have been verified.
+  std::vector<ReferenceMap> UnitCrossUnitReferences(Units.size());
+  unsigned NumDebugInfoErrors = verifyInParallel(
+      Units.size(), [&](DWARFVerifier &Verifier, size_t Index) {
+        DWARFUnit *Unit = Units[Index].get();
+        raw_ostream &OS = Verifier.OS;
+        OS << "Verifying unit: " << Index + 1 << " / " << Units.getNumUnits();
+        if (const char *Name = Unit->getUnitDIE(true).getShortName())
+          OS << ", \"" << Name << '\"';
+        OS << '\n';
+        OS.flush();
+        ReferenceMap UnitLocalReferences;
+        unsigned NumErrors = Verifier.verifyUnitContents(
+            *Unit, UnitLocalReferences, UnitCrossUnitReferences[Index]);
+        NumErrors += Verifier.verifyDebugInfoReferences(
+            UnitLocalReferences, [&](uint64_t Offset) { return Unit; });
+        return NumErrors;
+      });
 
-  unsigned Index = 1;
-  for (const auto &Unit : Units) {
-    OS << "Verifying unit: " << Index << " / " << Units.getNumUnits();
-    if (const char* Name = Unit->getUnitDIE(true).getShortName())
-      OS << ", \"" << Name << '\"';
-    OS << '\n';
-    OS.flush();
-    ReferenceMap UnitLocalReferences;
-    NumDebugInfoErrors +=
-        verifyUnitContents(*Unit, UnitLocalReferences, CrossUnitReferences);
-    NumDebugInfoErrors += verifyDebugInfoReferences(
-        UnitLocalReferences, [&](uint64_t Offset) { return Unit.get(); });
-    ++Index;
+  ReferenceMap CrossUnitReferences;
+  for (ReferenceMap &References : UnitCrossUnitReferences) {
+    for (auto &Pair : References)
+      CrossUnitReferences[Pair.first].insert(Pair.second.begin(),
+                                             Pair.second.end());
+    References.clear();
   }
 
   NumDebugInfoErrors += verifyDebugInfoReferences(
@@ -737,19 +752,30 @@ unsigned DWARFVerifier::verifyDebugInfoReferences(
       return U->getDIEForOffset(Offset);
     return DWARFDie();
   };
-  unsigned NumErrors = 0;
-  for (const std::pair<const uint64_t, std::set<uint64_t>> &Pair :
-       References) {
-    if (GetDIEForOffset(Pair.first))
-      continue;
-    ++NumErrors;
-    error() << "invalid DIE reference " << format("0x%08" PRIx64, Pair.first)
-            << ". Offset is in between DIEs:\n";
-    for (auto Offset : Pair.second)
-      dump(GetDIEForOffset(Offset)) << '\n';
-    OS << "\n";
-  }
-  return NumErrors;
+  std::vector<const ReferenceMap::value_type *> Entries;
+  Entries.reserve(References.size());
+  for (const ReferenceMap::value_type &Pair : References)
+    Entries.push_back(&Pair);
+  return verifyInParallel(
+      divideCeil(Entries.size(), ItemsPerTask),
+      [&](DWARFVerifier &Verifier, size_t Index) {
+        unsigned NumErrors = 0;
+        size_t Begin = Index * ItemsPerTask;
+        size_t End = std::min(Begin + ItemsPerTask, Entries.size());
+        for (const ReferenceMap::value_type *Pair :
+             makeArrayRef(Entries).slice(Begin, End - Begin)) {
+          if (GetDIEForOffset(Pair->first))
+            continue;
+          ++NumErrors;
+          Verifier.error() << "invalid DIE reference "
+                           << format("0x%08" PRIx64, Pair->first)
+                           << ". Offset is in between DIEs:\n";
+          for (auto Offset : Pair->second)
+            Verifier.dump(GetDIEForOffset(Offset)) << '\n';
+          Verifier.OS << "\n";
+        }
+        return NumErrors;
+      });
 }
 
 void DWARFVerifier::verifyDebugLineStmtOffsets() {
@@ -886,9 +912,9 @@ void DWARFVerifier::verifyDebugLineRows() {
 }
 
 DWARFVerifier::DWARFVerifier(raw_ostream &S, DWARFContext &D,
-                             DIDumpOptions DumpOpts)
+                             DIDumpOptions DumpOpts, ThreadPoolStrategy Threads)
     : OS(S), DCtx(D), DumpOpts(std::move(DumpOpts)), IsObjectFile(false),
-      IsMachOObject(false) {
+      IsMachOObject(false), Strategy(Threads) {
   if (const auto *F = DCtx.getDWARFObj().getFile()) {
     IsObjectFile = F->isRelocatableObject();
     IsMachOObject = F->isMachO();
@@ -1525,21 +1551,49 @@ unsigned DWARFVerifier::verifyDebugNames(const DWARFSection &AccelSection,
   // Don't attempt Entry validation if any of the previous checks found errors
   if (NumErrors > 0)
     return NumErrors;
+  struct NameRange {
+    const DWARFDebugNames::NameIndex *NI;
+    uint32_t Begin;
+    uint32_t End;
+  };
+  std::vector<NameRange> NameRanges;
   for (const auto &NI : AccelTable)
-    for (const DWARFDebugNames::NameTableEntry &NTE : NI)
-      NumErrors += verifyNameIndexEntries(NI, NTE);
+    for (uint32_t Begin = 1, End = NI.getNameCount() + 1; Begin < End;
+         Begin += ItemsPerTask)
+      NameRanges.push_back(
+          {&NI, Begin, std::min<uint32_t>(Begin + ItemsPerTask, End)});
+  NumErrors += verifyInParallel(
+      NameRanges.size(), [&](DWARFVerifier &Verifier, size_t Index) {
+        const NameRange &Range = NameRanges[Index];
+        unsigned NumErrors = 0;
+        for (uint32_t Name = Range.Begin; Name != Range.End; ++Name)
+          NumErrors += Verifier.verifyNameIndexEntries(
+              *Range.NI, Range.NI->getNameTableEntry(Name));
+        return NumErrors;
+      });
 
   if (NumErrors > 0)
     return NumErrors;
 
-  for (const std::unique_ptr<DWARFUnit> &U : DCtx.compile_units()) {
+  // Find the name index of each unit up front, as the lookup fills a cache.
+  struct UnitNameIndex {
+    DWARFCompileUnit *CU;
+    const DWARFDebugNames::NameIndex *NI;
+  };
+  std::vector<UnitNameIndex> UnitIndexes;
+  for (const std::unique_ptr<DWARFUnit> &U : DCtx.compile_units())
     if (const DWARFDebugNames::NameIndex *NI =
-            AccelTable.getCUNameIndex(U->getOffset())) {
-      auto *CU = cast<DWARFCompileUnit>(U.get());
-      for (const DWARFDebugInfoEntry &Die : CU->dies())
-        NumErrors += verifyNameIndexCompleteness(DWARFDie(CU, &Die), *NI);
-    }
-  }
+            AccelTable.getCUNameIndex(U->getOffset()))
+      UnitIndexes.push_back({cast<DWARFCompileUnit>(U.get()), NI});
+  NumErrors += verifyInParallel(
+      UnitIndexes.size(), [&](DWARFVerifier &Verifier, size_t Index) {
+        DWARFCompileUnit *CU = UnitIndexes[Index].CU;
+        unsigned NumErrors = 0;
+        for (const DWARFDebugInfoEntry &Die : CU->dies())
+          NumErrors += Verifier.verifyNameIndexCompleteness(
+              DWARFDie(CU, &Die), *UnitIndexes[Index].NI);
+        return NumErrors;
+      });
   return NumErrors;
 }
 
@@ -1565,6 +1619,27 @@ bool DWARFVerifier::handleAccelTables() {
   return NumErrors == 0;
 }
 
+unsigned DWARFVerifier::verifyInParallel(
+    size_t NumTasks, function_ref<unsigned(DWARFVerifier &, size_t)> Task) {
+  if (!DCtx.isThreadSafe() || NumTasks < 2 ||
+      Strategy.compute_thread_count() < 2) {
+    unsigned NumErrors = 0;
+    for (size_t I = 0; I != NumTasks; ++I)
+      NumErrors += Task(*this, I);
+    return NumErrors;
+  }
+
+  std::vector<unsigned> NumTaskErrors(NumTasks);
+  DCtx.printInOrder(OS, NumTasks, Strategy,
+                    [&](raw_ostream &TaskOS, size_t I) {
+                      DWARFVerifier Verifier(TaskOS, DCtx, DumpOpts,
+                                             hardware_concurrency(1));
+                      NumTaskErrors[I] = Task(Verifier, I);
+                    });
+  OS.flush();
+  return std::accumulate(NumTaskErrors.begin(), NumTaskErrors.end(), 0u);
+}
+
 raw_ostream &DWARFVerifier::error() const { return WithColor::error(OS); }
 
 raw_ostream &DWARFVerifier::warn() const { return WithColor::warning(OS); }
@@ -19,6 +19,7 @@
 #include "llvm/Support/BinaryStreamReader.h"
 #include "llvm/Support/DataExtractor.h"
 #include "llvm/Support/MemoryBuffer.h"
+#include <numeric>
 
 using namespace llvm;
 using namespace gsym;
@@ -34,7 +35,8 @@ GsymReader::~GsymReader() = default;
 llvm::Expected<GsymReader> GsymReader::openFile(StringRef Filename) {
   // Open the input file and return an appropriate error if needed.
   ErrorOr<std::unique_ptr<MemoryBuffer>> BuffOrErr =
-      MemoryBuffer::getFileOrSTDIN(Filename);
+      MemoryBuffer::getFileOrSTDIN(Filename, /*IsText=*/false,
+                                   /*RequiresNullTerminator=*/false);
   auto Err = BuffOrErr.getError();
   if (Err)
     return llvm::errorCodeToError(Err);
@@ -224,22 +226,22 @@ Optional<uint64_t> GsymReader::getAddressInfoOffset(size_t Index) const {
 }
 
 Expected<uint64_t>
-GsymReader::getAddressIndex(const uint64_t Addr) const {
+GsymReader::getAddressIndex(const uint64_t Addr, uint64_t Start) const {
   if (Addr >= Hdr->BaseAddress) {
     const uint64_t AddrOffset = Addr - Hdr->BaseAddress;
     Optional<uint64_t> AddrOffsetIndex;
     switch (Hdr->AddrOffSize) {
     case 1:
-      AddrOffsetIndex = getAddressOffsetIndex<uint8_t>(AddrOffset);
+      AddrOffsetIndex = getAddressOffsetIndex<uint8_t>(AddrOffset, Start);
       break;
     case 2:
-      AddrOffsetIndex = getAddressOffsetIndex<uint16_t>(AddrOffset);
+      AddrOffsetIndex = getAddressOffsetIndex<uint16_t>(AddrOffset, Start);
       break;
     case 4:
-      AddrOffsetIndex = getAddressOffsetIndex<uint32_t>(AddrOffset);
+      AddrOffsetIndex = getAddressOffsetIndex<uint32_t>(AddrOffset, Start);
       break;
     case 8:
-      AddrOffsetIndex = getAddressOffsetIndex<uint64_t>(AddrOffset);
+      AddrOffsetIndex = getAddressOffsetIndex<uint64_t>(AddrOffset, Start);
       break;
     default:
       return createStringError(std::errc::invalid_argument,
@@ -280,15 +282,66 @@ llvm::Expected<LookupResult> GsymReader::lookup(uint64_t Addr) const {
   Expected<uint64_t> AddressIndex = getAddressIndex(Addr);
   if (!AddressIndex)
     return AddressIndex.takeError();
+  return lookupAddressIndex(Addr, *AddressIndex);
+}
+
+llvm::Expected<LookupResult>
+GsymReader::lookupAddressIndex(uint64_t Addr, uint64_t AddressIndex) const {
   // Address info offsets size should have been checked in parse().
-  assert(*AddressIndex < AddrInfoOffsets.size());
-  auto AddrInfoOffset = AddrInfoOffsets[*AddressIndex];
+  assert(AddressIndex < AddrInfoOffsets.size());
+  auto AddrInfoOffset = AddrInfoOffsets[AddressIndex];
   DataExtractor Data(MemBuffer->getBuffer().substr(AddrInfoOffset), Endian, 4);
-  if (Optional<uint64_t> OptAddr = getAddress(*AddressIndex))
+  if (Optional<uint64_t> OptAddr = getAddress(AddressIndex))
     return FunctionInfo::lookup(Data, *this, *OptAddr, Addr);
   return createStringError(std::errc::invalid_argument,
                            "failed to extract address[%" PRIu64 "]",
-                           *AddressIndex);
+                           AddressIndex);
+}
+
+std::vector<llvm::Expected<LookupResult>>
+GsymReader::lookupAddresses(ArrayRef<uint64_t> Addrs) const {
+  // Visit the addresses in ascending order. The address index of an address
+  // is never below the one of a smaller address, so each search of the
+  // address table starts at the index found last.
+  std::vector<size_t> Order;
+  bool IsSorted = llvm::is_sorted(Addrs);
+  if (!IsSorted) {
+    Order.resize(Addrs.size());
+    std::iota(Order.begin(), Order.end(), 0);
+    llvm::stable_sort(Order, [&](size_t LHS, size_t RHS) {
+      return Addrs[LHS] < Addrs[RHS];
+    });
+  }
+
+  std::vector<llvm::Expected<LookupResult>> Results;
+  Results.reserve(Addrs.size());
+  uint64_t Start = 0;
+  for (size_t I = 0, E = Addrs.size(); I != E; ++I) {
+    uint64_t Addr = Addrs[IsSorted ? I : Order[I]];
+    Expected<uint64_t> AddressIndex = getAddressIndex(Addr, Start);
+    if (!AddressIndex) {
+      Results.push_back(AddressIndex.takeError());
+      continue;
+    }
+    Start = *AddressIndex;
+    Results.push_back(lookupAddressIndex(Addr, *AddressIndex));
+  }
+  if (IsSorted)
+    return Results;
+
+  // Put the results back in the order of the addresses.
+  std::vector<size_t> Position(Order.size());
+  for (size_t I = 0, E = Order.size(); I != E; ++I)
+    Position[Order[I]] = I;
+  std::vector<llvm::Expected<LookupResult>> OrderedResults;
+  OrderedResults.reserve(Results.size());
+  for (size_t I : Position)
+    OrderedResults.push_back(std::move(Results[I]));
+  return OrderedResults;
+}
+
+size_t GsymReader::getBufferSize() const {
+  return MemBuffer->getBufferSize();
 }
 
 void GsymReader::dump(raw_ostream &OS) {
@@ -0,0 +1,144 @@
+//===- GsymRegistry.cpp ---------------------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/GSYM/GsymRegistry.h"
+
+#include "llvm/ADT/StringExtras.h"
+#include "llvm/DebugInfo/GSYM/GsymReader.h"
+#include "llvm/DebugInfo/GSYM/Header.h"
+
+using namespace llvm;
+using namespace gsym;
+
+static StringRef toKey(ArrayRef<uint8_t> UUID) {
+  return StringRef(reinterpret_cast<const char *>(UUID.data()), UUID.size());
+}
+
+static ArrayRef<uint8_t> getUUID(const GsymReader &Reader) {
+  const Header &Hdr = Reader.getHeader();
+  return makeArrayRef(Hdr.UUID, Hdr.UUIDSize);
+}
+
+GsymRegistry::GsymRegistry(uint64_t MaxMappedBytes)
+    : MaxMappedBytes(MaxMappedBytes) {}
+
+GsymRegistry::~GsymRegistry() = default;
+
+void GsymRegistry::addFile(ArrayRef<uint8_t> UUID, StringRef Path) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Entry &E = Entries[toKey(UUID)];
+  unmap(E);
+  E.Path = Path.str();
+}
+
+llvm::Error GsymRegistry::addFile(StringRef Path) {
+  Expected<GsymReader> ReaderOrErr = GsymReader::openFile(Path);
+  if (!ReaderOrErr)
+    return createFileError(Path, ReaderOrErr.takeError());
+  auto Reader = std::make_shared<const GsymReader>(std::move(*ReaderOrErr));
+  ArrayRef<uint8_t> UUID = getUUID(*Reader);
+  if (UUID.empty())
+    return createFileError(Path,
+                           createStringError(std::errc::invalid_argument,
+                                             "GSYM file has no UUID"));
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Entry &E = Entries[toKey(UUID)];
+  unmap(E);
+  E.Path = Path.str();
+  map(E, std::move(Reader));
+  return Error::success();
+}
+
+llvm::Expected<std::shared_ptr<const GsymReader>>
+GsymRegistry::getReader(ArrayRef<uint8_t> UUID) {
+  std::string Path;
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto It = Entries.find(toKey(UUID));
+    if (It == Entries.end())
+      return createStringError(std::errc::invalid_argument,
+                               "no GSYM file registered for UUID %s",
+                               toHex(UUID).c_str());
+    Entry &E = It->second;
+    if (E.Reader) {
+      MappedLRU.splice(MappedLRU.end(), MappedLRU, E.LRUPos);
+      return E.Reader;
+    }
+    Path = E.Path;
+  }
+
+  // Open the file without holding the lock, so that lookups in files that
+  // are already mapped don't wait for it.
+  Expected<GsymReader> ReaderOrErr = GsymReader::openFile(Path);
+  if (!ReaderOrErr)
+    return createFileError(Path, ReaderOrErr.takeError());
+  auto Reader = std::make_shared<const GsymReader>(std::move(*ReaderOrErr));
+  if (getUUID(*Reader) != UUID)
+    return createFileError(
+        Path, createStringError(std::errc::invalid_argument,
+                                "GSYM file has UUID %s instead of %s",
+                                toHex(getUUID(*Reader)).c_str(),
+                                toHex(UUID).c_str()));
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto It = Entries.find(toKey(UUID));
+  // Use the file only if it is still the one registered for UUID.
+  if (It == Entries.end() || It->second.Path != Path)
+    return Reader;
+  Entry &E = It->second;
+  // Another thread may have opened the file in the meantime.
+  if (E.Reader) {
+    MappedLRU.splice(MappedLRU.end(), MappedLRU, E.LRUPos);
+    return E.Reader;
+  }
+  map(E, Reader);
+  return Reader;
+}
+
+llvm::Expected<LookupResult> GsymRegistry::lookup(ArrayRef<uint8_t> UUID,
+                                                  uint64_t Addr) {
+  Expected<std::shared_ptr<const GsymReader>> ReaderOrErr = getReader(UUID);
+  if (!ReaderOrErr)
+    return ReaderOrErr.takeError();
+  return (*ReaderOrErr)->lookup(Addr);
+}
+
+llvm::Expected<std::vector<llvm::Expected<LookupResult>>>
+GsymRegistry::lookupAddresses(ArrayRef<uint8_t> UUID,
+                              ArrayRef<uint64_t> Addrs) {
+  Expected<std::shared_ptr<const GsymReader>> ReaderOrErr = getReader(UUID);
+  if (!ReaderOrErr)
+    return ReaderOrErr.takeError();
+  return (*ReaderOrErr)->lookupAddresses(Addrs);
+}
+
+uint64_t GsymRegistry::getMappedBytes() const {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  return MappedBytes;
+}
+
+void GsymRegistry::map(Entry &E, std::shared_ptr<const GsymReader> Reader) {
+  assert(!E.Reader && "file is mapped already");
+  MappedBytes += Reader->getBufferSize();
+  E.Reader = std::move(Reader);
+  E.LRUPos = MappedLRU.insert(MappedLRU.end(), &E);
+
+  // Unmap the least recently used files, but never the one just mapped.
+  while (MaxMappedBytes && MappedBytes > MaxMappedBytes &&
+         MappedLRU.front() != &E)
+    unmap(*MappedLRU.front());
+}
+
+void GsymRegistry::unmap(Entry &E) {
+  if (!E.Reader)
+    return;
+  MappedBytes -= E.Reader->getBufferSize();
+  MappedLRU.erase(E.LRUPos);
+  E.Reader.reset();
+}
@@ -0,0 +1,288 @@
+//===- IndexedSymbolizableModule.cpp --------------------------------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+//
+// Implementation of IndexedSymbolizableModule class.
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/DebugInfo/Symbolize/IndexedSymbolizableModule.h"
+#include "llvm/ADT/StringMap.h"
+#include "llvm/DebugInfo/Symbolize/SymbolizableObjectFile.h"
+#include "llvm/Support/Errc.h"
+#include "llvm/Support/raw_ostream.h"
+#include <algorithm>
+#include <cstring>
+
+using namespace llvm;
+using namespace object;
+using namespace symbolize;
+
+namespace {
+
+bool isSameFrame(const DILineInfo &LHS, const DILineInfo &RHS) {
+  return LHS == RHS && LHS.StartAddress == RHS.StartAddress &&
+         LHS.Source == RHS.Source;
+}
+
+bool isSameContext(const DIInliningInfo &LHS, const DIInliningInfo &RHS) {
+  if (LHS.getNumberOfFrames() != RHS.getNumberOfFrames())
+    return false;
+  for (uint32_t I = 0, E = LHS.getNumberOfFrames(); I != E; ++I)
+    if (!isSameFrame(LHS.getFrame(I), RHS.getFrame(I)))
+      return false;
+  return true;
+}
+
+class IndexBuilder {
+public:
+  uint32_t addFrame(const DILineInfo &LI) {
+    index::Frame F;
+    F.FileName = addString(LI.FileName);
+    F.FunctionName = addString(LI.FunctionName);
+    F.StartFileName = addString(LI.StartFileName);
+    F.Source = LI.Source ? addString(*LI.Source) : index::NoString;
+    F.Line = LI.Line;
+    F.Column = LI.Column;
+    F.StartLine = LI.StartLine;
+    F.Discriminator = LI.Discriminator;
+    F.HasStartAddress = LI.StartAddress.hasValue();
+    F.StartAddress = LI.StartAddress.getValueOr(0);
+    Frames.push_back(F);
+    return Frames.size() - 1;
+  }
+
+  uint32_t addString(StringRef S) {
+    auto Inserted = StringOffsets.try_emplace(S, Strings.size());
+    if (Inserted.second) {
+      Strings.append(S.begin(), S.end());
+      Strings.push_back('\0');
+    }
+    return Inserted.first->second;
+  }
+
+  bool overflowed() const {
+    return Frames.size() >= UINT32_MAX || Strings.size() >= UINT32_MAX;
+  }
+
+  std::vector<index::Range> Ranges;
+  std::vector<index::Frame> Frames;
+  std::string Strings;
+
+private:
+  StringMap<uint32_t> StringOffsets;
+};
+
+template <typename T> void writeArray(raw_ostream &OS, ArrayRef<T> Array) {
+  OS.write(reinterpret_cast<const char *>(Array.data()),
+           Array.size() * sizeof(T));
+}
+
+} // end anonymous namespace
+
+Error IndexedSymbolizableModule::writeIndex(
+    const SymbolizableObjectFile &Module,
+    DILineInfoSpecifier LineInfoSpecifier, bool UseSymbolTable,
+    raw_ostream &OS) {
+  Expected<std::vector<uint64_t>> BoundariesOrErr =
+      Module.getSymbolizationBoundaries();
+  if (!BoundariesOrErr)
+    return BoundariesOrErr.takeError();
+
+  // Query both the inlined context and the plain line info at every boundary,
+  // and only start a new range when either of them changes.
+  IndexBuilder Builder;
+  DIInliningInfo PrevInlined;
+  DILineInfo PrevCode;
+  for (uint64_t Address : *BoundariesOrErr) {
+    SectionedAddress ModuleOffset{Address, SectionedAddress::UndefSection};
+    DIInliningInfo Inlined = Module.symbolizeInlinedCode(
+        ModuleOffset, LineInfoSpecifier, UseSymbolTable);
+    DILineInfo Code =
+        Module.symbolizeCode(ModuleOffset, LineInfoSpecifier, UseSymbolTable);
+    if (!Builder.Ranges.empty() && isSameContext(Inlined, PrevInlined) &&
+        isSameFrame(Code, PrevCode))
+      continue;
+
+    index::Range R;
+    R.Address = Address;
+    R.FirstInlinedFrame = Builder.Frames.size();
+    R.NumInlinedFrames = Inlined.getNumberOfFrames();
+    for (uint32_t I = 0, E = Inlined.getNumberOfFrames(); I != E; ++I)
+      Builder.addFrame(Inlined.getFrame(I));
+    // The plain line info usually matches the innermost inlined frame.
+    if (Inlined.getNumberOfFrames() != 0 &&
+        isSameFrame(Code, Inlined.getFrame(0)))
+      R.CodeFrame = R.FirstInlinedFrame;
+    else
+      R.CodeFrame = Builder.addFrame(Code);
+    Builder.Ranges.push_back(R);
+    if (Builder.overflowed())
+      return createStringError(errc::file_too_large,
+                               "symbolization index is too large");
+
+    PrevInlined = std::move(Inlined);
+    PrevCode = std::move(Code);
+  }
+
+  index::Header Hdr;
+  std::memcpy(Hdr.Magic, index::Magic, sizeof(Hdr.Magic));
+  Hdr.Version = index::Version;
+  Hdr.FileLineInfoKind = static_cast<uint32_t>(LineInfoSpecifier.FLIKind);
+  Hdr.FunctionNameKind = static_cast<uint32_t>(LineInfoSpecifier.FNKind);
+  Hdr.UseSymbolTable = UseSymbolTable;
+  Hdr.PreferredBase = Module.getModulePreferredBase();
+  Hdr.NumRanges = Builder.Ranges.size();
+  Hdr.NumFrames = Builder.Frames.size();
+  Hdr.StringTableSize = Builder.Strings.size();
+
+  writeArray(OS, makeArrayRef(Hdr));
+  writeArray(OS, makeArrayRef(Builder.Ranges));
+  writeArray(OS, makeArrayRef(Builder.Frames));
+  OS << Builder.Strings;
+  return Error::success();
+}
+
+Expected<std::unique_ptr<IndexedSymbolizableModule>>
+IndexedSymbolizableModule::create(std::unique_ptr<MemoryBuffer> Index,
+                                  std::unique_ptr<SymbolizableModule> &&Module) {
+  assert(Module);
+  auto Malformed = [&](const Twine &Reason) {
+    return createStringError(errc::invalid_argument,
+                             "malformed symbolization index '" +
+                                 Index->getBufferIdentifier() +
+                                 "': " + Reason);
+  };
+
+  StringRef Data = Index->getBuffer();
+  if (Data.size() < sizeof(index::Header))
+    return Malformed("truncated header");
+  const auto *Hdr = reinterpret_cast<const index::Header *>(Data.data());
+  if (std::memcmp(Hdr->Magic, index::Magic, sizeof(index::Magic)) != 0)
+    return Malformed("bad magic");
+  if (Hdr->Version != index::Version)
+    return Malformed("unsupported version " + Twine(Hdr->Version));
+
+  uint64_t Offset = sizeof(index::Header);
+  uint64_t Remaining = Data.size() - Offset;
+  if (Hdr->NumRanges == 0 ||
+      Hdr->NumRanges > Remaining / sizeof(index::Range))
+    return Malformed("bad range count");
+  Remaining -= Hdr->NumRanges * sizeof(index::Range);
+  if (Hdr->NumFrames > Remaining / sizeof(index::Frame))
+    return Malformed("bad frame count");
+  Remaining -= Hdr->NumFrames * sizeof(index::Frame);
+  if (Hdr->StringTableSize != Remaining ||
+      (Remaining != 0 && Data.back() != '\0'))
+    return Malformed("bad string table");
+
+  std::unique_ptr<IndexedSymbolizableModule> Res(
+      new IndexedSymbolizableModule(std::move(Index), std::move(Module)));
+  Res->Hdr = Hdr;
+  Res->Ranges = makeArrayRef(
+      reinterpret_cast<const index::Range *>(Data.data() + Offset),
+      Hdr->NumRanges);
+  Offset += Hdr->NumRanges * sizeof(index::Range);
+  Res->Frames = makeArrayRef(
+      reinterpret_cast<const index::Frame *>(Data.data() + Offset),
+      Hdr->NumFrames);
+  Offset += Hdr->NumFrames * sizeof(index::Frame);
+  Res->StringTable = Data.drop_front(Offset);
+  return std::move(Res);
+}
+
+const index::Range *IndexedSymbolizableModule::lookup(
+    SectionedAddress ModuleOffset, DILineInfoSpecifier LineInfoSpecifier,
+    bool UseSymbolTable) const {
+  if (ModuleOffset.SectionIndex != SectionedAddress::UndefSection ||
+      Hdr->FileLineInfoKind !=
+          static_cast<uint32_t>(LineInfoSpecifier.FLIKind) ||
+      Hdr->FunctionNameKind !=
+          static_cast<uint32_t>(LineInfoSpecifier.FNKind) ||
+      Hdr->UseSymbolTable != UseSymbolTable)
+    return nullptr;
+
+  auto It = std::upper_bound(
+      Ranges.begin(), Ranges.end(), ModuleOffset.Address,
+      [](uint64_t Address, const index::Range &R) { return Address < R.Address; });
+  if (It == Ranges.begin())
+    return nullptr;
+  return &It[-1];
+}
+
+StringRef IndexedSymbolizableModule::getString(uint32_t Offset) const {
+  if (Offset >= StringTable.size())
+    return DILineInfo::BadString;
+  return StringRef(StringTable.data() + Offset);
+}
+
+DILineInfo IndexedSymbolizableModule::getFrame(uint32_t Idx) const {
+  DILineInfo LI;
+  if (Idx >= Frames.size())
+    return LI;
+  const index::Frame &F = Frames[Idx];
+  LI.FileName = getString(F.FileName).str();
+  LI.FunctionName = getString(F.FunctionName).str();
+  LI.StartFileName = getString(F.StartFileName).str();
+  if (F.Source != index::NoString)
+    LI.Source = getString(F.Source);
+  LI.Line = F.Line;
+  LI.Column = F.Column;
+  LI.StartLine = F.StartLine;
+  LI.Discriminator = F.Discriminator;
+  if (F.HasStartAddress)
+    LI.StartAddress = F.StartAddress;
+  return LI;
+}
+
+DILineInfo
+IndexedSymbolizableModule::symbolizeCode(SectionedAddress ModuleOffset,
+                                         DILineInfoSpecifier LineInfoSpecifier,
+                                         bool UseSymbolTable) const {
+  const index::Range *R =
+      lookup(ModuleOffset, LineInfoSpecifier, UseSymbolTable);
+  if (!R)
+    return Module->symbolizeCode(ModuleOffset, LineInfoSpecifier,
+                                 UseSymbolTable);
+  return getFrame(R->CodeFrame);
+}
+
+DIInliningInfo IndexedSymbolizableModule::symbolizeInlinedCode(
+    SectionedAddress ModuleOffset, DILineInfoSpecifier LineInfoSpecifier,
+    bool UseSymbolTable) const {
+  const index::Range *R =
+      lookup(ModuleOffset, LineInfoSpecifier, UseSymbolTable);
+  if (!R)
+    return Module->symbolizeInlinedCode(ModuleOffset, LineInfoSpecifier,
+                                        UseSymbolTable);
+  DIInliningInfo InlinedContext;
+  if (uint64_t(R->FirstInlinedFrame) + R->NumInlinedFrames <= Frames.size())
+    for (uint32_t I = 0; I != R->NumInlinedFrames; ++I)
+      InlinedContext.addFrame(getFrame(R->FirstInlinedFrame + I));
+  // Make sure there is at least one frame in context.
+  if (InlinedContext.getNumberOfFrames() == 0)
+    InlinedContext.addFrame(DILineInfo());
+  return InlinedContext;
+}
+
+DIGlobal
+IndexedSymbolizableModule::symbolizeData(SectionedAddress ModuleOffset) const {
+  return Module->symbolizeData(ModuleOffset);
+}
+
+std::vector<DILocal>
+IndexedSymbolizableModule::symbolizeFrame(SectionedAddress ModuleOffset) const {
+  return Module->symbolizeFrame(ModuleOffset);
+}
+
+bool IndexedSymbolizableModule::isWin32Module() const {
+  return Module->isWin32Module();
+}
+
+uint64_t IndexedSymbolizableModule::getModulePreferredBase() const {
+  return Hdr->PreferredBase;
+}
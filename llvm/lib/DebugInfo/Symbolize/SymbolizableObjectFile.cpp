@@ -21,6 +21,7 @@
 #include "llvm/Object/SymbolSize.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/DataExtractor.h"
+#include "llvm/Support/Errc.h"
 #include <algorithm>
 
 using namespace llvm;
@@ -226,6 +227,59 @@ uint64_t SymbolizableObjectFile::getModulePreferredBase() const {
   return 0;
 }
 
+Expected<std::vector<uint64_t>>
+SymbolizableObjectFile::getSymbolizationBoundaries() const {
+  auto *DICtx = dyn_cast<DWARFContext>(DebugInfoContext.get());
+  if (!DICtx)
+    return createStringError(errc::not_supported,
+                             "symbolization boundaries are only available "
+                             "for DWARF debug info");
+
+  std::vector<uint64_t> Boundaries{0};
+  auto AddRanges = [&](Expected<DWARFAddressRangesVector> RangesOrErr) {
+    if (!RangesOrErr) {
+      consumeError(RangesOrErr.takeError());
+      return;
+    }
+    for (const DWARFAddressRange &R : *RangesOrErr) {
+      Boundaries.push_back(R.LowPC);
+      Boundaries.push_back(R.HighPC);
+    }
+  };
+
+  for (SectionRef Sec : Module->sections()) {
+    if (!Sec.isText() || Sec.isVirtual())
+      continue;
+    Boundaries.push_back(Sec.getAddress());
+    Boundaries.push_back(Sec.getAddress() + Sec.getSize());
+  }
+  for (const SymbolDesc &Sym : Symbols) {
+    Boundaries.push_back(Sym.Addr);
+    if (Sym.Size != 0)
+      Boundaries.push_back(Sym.Addr + Sym.Size);
+  }
+  for (const auto &CU : DICtx->compile_units()) {
+    AddRanges(CU->collectAddressRanges());
+    if (const DWARFDebugLine::LineTable *LT =
+            DICtx->getLineTableForUnit(CU.get()))
+      for (const DWARFDebugLine::Row &Row : LT->Rows)
+        Boundaries.push_back(Row.Address.Address);
+    DWARFUnit *U = CU->getNonSkeletonUnitDIE(false).getDwarfUnit();
+    if (!U)
+      continue;
+    for (const DWARFDebugInfoEntry &Entry : U->dies()) {
+      DWARFDie Die(U, &Entry);
+      if (Die.isSubroutineDIE())
+        AddRanges(Die.getAddressRanges());
+    }
+  }
+
+  llvm::sort(Boundaries);
+  Boundaries.erase(std::unique(Boundaries.begin(), Boundaries.end()),
+                   Boundaries.end());
+  return Boundaries;
+}
+
 bool SymbolizableObjectFile::getNameFromSymbolTable(
     uint64_t Address, std::string &Name, uint64_t &Addr, uint64_t &Size,
     std::string &FileName) const {
@@ -265,6 +319,30 @@ bool SymbolizableObjectFile::shouldOverrideWithSymbolTable(
          isa<DWARFContext>(DebugInfoContext.get());
 }
 
+void SymbolizableObjectFile::overrideWithSymbolTable(
+    uint64_t Address, DILineInfo &LineInfo) const {
+  std::string FunctionName, FileName;
+  uint64_t Start, Size;
+  if (getNameFromSymbolTable(Address, FunctionName, Start, Size, FileName)) {
+    LineInfo.FunctionName = FunctionName;
+    LineInfo.StartAddress = Start;
+    if (LineInfo.FileName == DILineInfo::BadString && !FileName.empty())
+      LineInfo.FileName = FileName;
+  }
+}
+
+std::vector<object::SectionedAddress>
+SymbolizableObjectFile::getSectionedAddresses(
+    ArrayRef<object::SectionedAddress> ModuleOffsets) const {
+  std::vector<object::SectionedAddress> Result(ModuleOffsets.begin(),
+                                               ModuleOffsets.end());
+  for (object::SectionedAddress &ModuleOffset : Result)
+    if (ModuleOffset.SectionIndex == object::SectionedAddress::UndefSection)
+      ModuleOffset.SectionIndex =
+          getModuleSectionIndexForAddress(ModuleOffset.Address);
+  return Result;
+}
+
 DILineInfo
 SymbolizableObjectFile::symbolizeCode(object::SectionedAddress ModuleOffset,
                                       DILineInfoSpecifier LineInfoSpecifier,
@@ -276,20 +354,25 @@ SymbolizableObjectFile::symbolizeCode(object::SectionedAddress ModuleOffset,
       DebugInfoContext->getLineInfoForAddress(ModuleOffset, LineInfoSpecifier);
 
   // Override function name from symbol table if necessary.
-  if (shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable)) {
-    std::string FunctionName, FileName;
-    uint64_t Start, Size;
-    if (getNameFromSymbolTable(ModuleOffset.Address, FunctionName, Start, Size,
-                               FileName)) {
-      LineInfo.FunctionName = FunctionName;
-      LineInfo.StartAddress = Start;
-      if (LineInfo.FileName == DILineInfo::BadString && !FileName.empty())
-        LineInfo.FileName = FileName;
-    }
-  }
+  if (shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable))
+    overrideWithSymbolTable(ModuleOffset.Address, LineInfo);
   return LineInfo;
 }
 
+std::vector<DILineInfo> SymbolizableObjectFile::symbolizeCodeBatch(
+    ArrayRef<object::SectionedAddress> ModuleOffsets,
+    DILineInfoSpecifier LineInfoSpecifier, bool UseSymbolTable) const {
+  std::vector<object::SectionedAddress> Addresses =
+      getSectionedAddresses(ModuleOffsets);
+  std::vector<DILineInfo> LineInfos =
+      DebugInfoContext->getLineInfoForAddresses(Addresses, LineInfoSpecifier);
+
+  if (shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable))
+    for (size_t I = 0, E = Addresses.size(); I != E; ++I)
+      overrideWithSymbolTable(Addresses[I].Address, LineInfos[I]);
+  return LineInfos;
+}
+
 DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
     object::SectionedAddress ModuleOffset,
     DILineInfoSpecifier LineInfoSpecifier, bool UseSymbolTable) const {
@@ -304,23 +387,37 @@ DIInliningInfo SymbolizableObjectFile::symbolizeInlinedCode(
     InlinedContext.addFrame(DILineInfo());
 
   // Override the function name in lower frame with name from symbol table.
-  if (shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable)) {
-    std::string FunctionName, FileName;
-    uint64_t Start, Size;
-    if (getNameFromSymbolTable(ModuleOffset.Address, FunctionName, Start, Size,
-                               FileName)) {
-      DILineInfo *LI = InlinedContext.getMutableFrame(
-          InlinedContext.getNumberOfFrames() - 1);
-      LI->FunctionName = FunctionName;
-      LI->StartAddress = Start;
-      if (LI->FileName == DILineInfo::BadString && !FileName.empty())
-        LI->FileName = FileName;
-    }
-  }
+  if (shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable))
+    overrideWithSymbolTable(ModuleOffset.Address,
+                            *InlinedContext.getMutableFrame(
+                                InlinedContext.getNumberOfFrames() - 1));
 
   return InlinedContext;
 }
 
+std::vector<DIInliningInfo> SymbolizableObjectFile::symbolizeInlinedCodeBatch(
+    ArrayRef<object::SectionedAddress> ModuleOffsets,
+    DILineInfoSpecifier LineInfoSpecifier, bool UseSymbolTable) const {
+  std::vector<object::SectionedAddress> Addresses =
+      getSectionedAddresses(ModuleOffsets);
+  std::vector<DIInliningInfo> InlinedContexts =
+      DebugInfoContext->getInliningInfoForAddresses(Addresses,
+                                                    LineInfoSpecifier);
+
+  bool Override =
+      shouldOverrideWithSymbolTable(LineInfoSpecifier.FNKind, UseSymbolTable);
+  for (size_t I = 0, E = Addresses.size(); I != E; ++I) {
+    DIInliningInfo &InlinedContext = InlinedContexts[I];
+    if (InlinedContext.getNumberOfFrames() == 0)
+      InlinedContext.addFrame(DILineInfo());
+    if (Override)
+      overrideWithSymbolTable(Addresses[I].Address,
+                              *InlinedContext.getMutableFrame(
+                                  InlinedContext.getNumberOfFrames() - 1));
+  }
+  return InlinedContexts;
+}
+
 DIGlobal SymbolizableObjectFile::symbolizeData(
     object::SectionedAddress ModuleOffset) const {
   DIGlobal Res;
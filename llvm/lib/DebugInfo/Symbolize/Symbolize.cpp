@@ -17,14 +17,19 @@
 #include "llvm/DebugInfo/PDB/PDB.h"
 #include "llvm/DebugInfo/PDB/PDBContext.h"
 #include "llvm/DebugInfo/Symbolize/DIFetcher.h"
+#include "llvm/DebugInfo/Symbolize/IndexedSymbolizableModule.h"
 #include "llvm/DebugInfo/Symbolize/SymbolizableObjectFile.h"
 #include "llvm/Demangle/Demangle.h"
+#include "llvm/Object/BuildID.h"
 #include "llvm/Object/COFF.h"
 #include "llvm/Object/ELF.h"
 #include "llvm/Object/ELFObjectFile.h"
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
+#include "llvm/Object/SharedBinaryCache.h"
 #include "llvm/Support/CRC.h"
+#include "llvm/Support/CachePruning.h"
+#include "llvm/Support/Caching.h"
 #include "llvm/Support/Casting.h"
 #include "llvm/Support/Compression.h"
 #include "llvm/Support/DataExtractor.h"
@@ -32,6 +37,7 @@
 #include "llvm/Support/FileSystem.h"
 #include "llvm/Support/MemoryBuffer.h"
 #include "llvm/Support/Path.h"
+#include "llvm/Support/xxhash.h"
 #include <algorithm>
 #include <cassert>
 #include <cstring>
@@ -141,6 +147,107 @@ LLVMSymbolizer::symbolizeInlinedCode(ArrayRef<uint8_t> BuildID,
   return symbolizeInlinedCodeCommon(BuildID, ModuleOffset);
 }
 
+template <typename T>
+Expected<std::vector<DILineInfo>> LLVMSymbolizer::symbolizeCodeBatchCommon(
+    const T &ModuleSpecifier,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  auto InfoOrErr = getOrCreateModuleInfo(ModuleSpecifier);
+  if (!InfoOrErr)
+    return InfoOrErr.takeError();
+
+  SymbolizableModule *Info = *InfoOrErr;
+
+  // A null module means an error has already been reported. Return empty
+  // results.
+  if (!Info)
+    return std::vector<DILineInfo>(ModuleOffsets.size());
+
+  std::vector<object::SectionedAddress> Addresses(ModuleOffsets.begin(),
+                                                  ModuleOffsets.end());
+  if (Opts.RelativeAddresses)
+    for (object::SectionedAddress &Address : Addresses)
+      Address.Address += Info->getModulePreferredBase();
+
+  std::vector<DILineInfo> LineInfos = Info->symbolizeCodeBatch(
+      Addresses, DILineInfoSpecifier(Opts.PathStyle, Opts.PrintFunctions),
+      Opts.UseSymbolTable);
+  if (Opts.Demangle)
+    for (DILineInfo &LineInfo : LineInfos)
+      LineInfo.FunctionName = DemangleName(LineInfo.FunctionName, Info);
+  return LineInfos;
+}
+
+Expected<std::vector<DILineInfo>> LLVMSymbolizer::symbolizeCodeBatch(
+    const ObjectFile &Obj, ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeCodeBatchCommon(Obj, ModuleOffsets);
+}
+
+Expected<std::vector<DILineInfo>> LLVMSymbolizer::symbolizeCodeBatch(
+    const std::string &ModuleName,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeCodeBatchCommon(ModuleName, ModuleOffsets);
+}
+
+Expected<std::vector<DILineInfo>> LLVMSymbolizer::symbolizeCodeBatch(
+    ArrayRef<uint8_t> BuildID,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeCodeBatchCommon(BuildID, ModuleOffsets);
+}
+
+template <typename T>
+Expected<std::vector<DIInliningInfo>>
+LLVMSymbolizer::symbolizeInlinedCodeBatchCommon(
+    const T &ModuleSpecifier,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  auto InfoOrErr = getOrCreateModuleInfo(ModuleSpecifier);
+  if (!InfoOrErr)
+    return InfoOrErr.takeError();
+
+  SymbolizableModule *Info = *InfoOrErr;
+
+  // A null module means an error has already been reported. Return empty
+  // results.
+  if (!Info)
+    return std::vector<DIInliningInfo>(ModuleOffsets.size());
+
+  std::vector<object::SectionedAddress> Addresses(ModuleOffsets.begin(),
+                                                  ModuleOffsets.end());
+  if (Opts.RelativeAddresses)
+    for (object::SectionedAddress &Address : Addresses)
+      Address.Address += Info->getModulePreferredBase();
+
+  std::vector<DIInliningInfo> InlinedContexts =
+      Info->symbolizeInlinedCodeBatch(
+          Addresses, DILineInfoSpecifier(Opts.PathStyle, Opts.PrintFunctions),
+          Opts.UseSymbolTable);
+  if (Opts.Demangle) {
+    for (DIInliningInfo &InlinedContext : InlinedContexts) {
+      for (int i = 0, n = InlinedContext.getNumberOfFrames(); i < n; i++) {
+        auto *Frame = InlinedContext.getMutableFrame(i);
+        Frame->FunctionName = DemangleName(Frame->FunctionName, Info);
+      }
+    }
+  }
+  return InlinedContexts;
+}
+
+Expected<std::vector<DIInliningInfo>> LLVMSymbolizer::symbolizeInlinedCodeBatch(
+    const ObjectFile &Obj, ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeInlinedCodeBatchCommon(Obj, ModuleOffsets);
+}
+
+Expected<std::vector<DIInliningInfo>> LLVMSymbolizer::symbolizeInlinedCodeBatch(
+    const std::string &ModuleName,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeInlinedCodeBatchCommon(ModuleName, ModuleOffsets);
+}
+
+Expected<std::vector<DIInliningInfo>> LLVMSymbolizer::symbolizeInlinedCodeBatch(
+    ArrayRef<uint8_t> BuildID,
+    ArrayRef<object::SectionedAddress> ModuleOffsets) {
+  return symbolizeInlinedCodeBatchCommon(BuildID, ModuleOffsets);
+}
+
 template <typename T>
 Expected<DIGlobal>
 LLVMSymbolizer::symbolizeDataCommon(const T &ModuleSpecifier,
@@ -234,6 +341,7 @@ void LLVMSymbolizer::flush() {
   BinaryForPath.clear();
   ObjectPairForPathArch.clear();
   Modules.clear();
+  DWARFContexts.clear();
   BuildIDPaths.clear();
 }
 
@@ -303,41 +411,6 @@ bool darwinDsymMatchesBinary(const MachOObjectFile *DbgObj,
   return !memcmp(dbg_uuid.data(), bin_uuid.data(), dbg_uuid.size());
 }
 
-template <typename ELFT>
-Optional<ArrayRef<uint8_t>> getBuildID(const ELFFile<ELFT> &Obj) {
-  auto PhdrsOrErr = Obj.program_headers();
-  if (!PhdrsOrErr) {
-    consumeError(PhdrsOrErr.takeError());
-    return {};
-  }
-  for (const auto &P : *PhdrsOrErr) {
-    if (P.p_type != ELF::PT_NOTE)
-      continue;
-    Error Err = Error::success();
-    for (auto N : Obj.notes(P, Err))
-      if (N.getType() == ELF::NT_GNU_BUILD_ID &&
-          N.getName() == ELF::ELF_NOTE_GNU)
-        return N.getDesc();
-    consumeError(std::move(Err));
-  }
-  return {};
-}
-
-Optional<ArrayRef<uint8_t>> getBuildID(const ELFObjectFileBase *Obj) {
-  Optional<ArrayRef<uint8_t>> BuildID;
-  if (auto *O = dyn_cast<ELFObjectFile<ELF32LE>>(Obj))
-    BuildID = getBuildID(O->getELFFile());
-  else if (auto *O = dyn_cast<ELFObjectFile<ELF32BE>>(Obj))
-    BuildID = getBuildID(O->getELFFile());
-  else if (auto *O = dyn_cast<ELFObjectFile<ELF64LE>>(Obj))
-    BuildID = getBuildID(O->getELFFile());
-  else if (auto *O = dyn_cast<ELFObjectFile<ELF64BE>>(Obj))
-    BuildID = getBuildID(O->getELFFile());
-  else
-    llvm_unreachable("unsupported file format");
-  return BuildID;
-}
-
 } // end anonymous namespace
 
 ObjectFile *LLVMSymbolizer::lookUpDsymFile(const std::string &ExePath,
@@ -454,6 +527,20 @@ bool LLVMSymbolizer::findDebugBinary(const std::string &OrigPath,
   return false;
 }
 
+// Returns true if Obj has DWARF debug info of its own.
+static bool hasDWARFInfo(const ObjectFile &Obj) {
+  for (const SectionRef &Sec : Obj.sections()) {
+    Expected<StringRef> NameOrErr = Sec.getName();
+    if (!NameOrErr) {
+      consumeError(NameOrErr.takeError());
+      continue;
+    }
+    if (*NameOrErr == ".debug_info" || *NameOrErr == ".zdebug_info")
+      return true;
+  }
+  return false;
+}
+
 static StringRef getBuildIDStr(ArrayRef<uint8_t> BuildID) {
   return StringRef(reinterpret_cast<const char *>(BuildID.data()),
                    BuildID.size());
@@ -474,6 +561,17 @@ bool LLVMSymbolizer::getOrFindDebugBinary(const ArrayRef<uint8_t> BuildID,
     (void)InsertResult;
   };
 
+  // A binary with debug info for this build ID may already be open in the
+  // process, e.g. one fetched by another symbolizer instance.
+  if (SharedBinaryCache::SharedBinary Bin =
+          SharedBinaryCache::get().lookupBuildID(BuildID)) {
+    const auto *Obj = dyn_cast<ObjectFile>(Bin->getBinary());
+    if (Obj && hasDWARFInfo(*Obj)) {
+      recordPath(Obj->getFileName());
+      return true;
+    }
+  }
+
   Optional<std::string> Path;
   Path = LocalDIFetcher(Opts.DebugFileDirectory).fetchBuildID(BuildID);
   if (Path) {
@@ -535,12 +633,15 @@ Expected<ObjectFile *>
 LLVMSymbolizer::getOrCreateObject(const std::string &Path,
                                   const std::string &ArchName) {
   Binary *Bin;
-  auto Pair = BinaryForPath.emplace(Path, OwningBinary<Binary>());
+  auto Pair = BinaryForPath.emplace(Path, CachedBinary());
   if (!Pair.second) {
-    Bin = Pair.first->second->getBinary();
+    Bin = Pair.first->second.getBinary();
     recordAccess(Pair.first->second);
   } else {
-    Expected<OwningBinary<Binary>> BinOrErr = createBinary(Path);
+    // Share the binary with other symbolizers and tools in the process that
+    // have the same file open.
+    Expected<SharedBinaryCache::SharedBinary> BinOrErr =
+        SharedBinaryCache::get().getOrOpen(Path);
     if (!BinOrErr)
       return BinOrErr.takeError();
 
@@ -549,7 +650,7 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
     CachedBin.pushEvictor([this, I = Pair.first]() { BinaryForPath.erase(I); });
     LRUBinaries.push_back(CachedBin);
     CacheSize += CachedBin.size();
-    Bin = CachedBin->getBinary();
+    Bin = CachedBin.getBinary();
   }
 
   if (!Bin)
@@ -580,15 +681,46 @@ LLVMSymbolizer::getOrCreateObject(const std::string &Path,
   return errorCodeToError(object_error::arch_not_found);
 }
 
+/// Returns whether a compile unit of \p Context is the skeleton of a split
+/// unit in a .dwo or .dwp file.
+static bool hasSkeletonUnits(DWARFContext &Context) {
+  for (const auto &CU : Context.compile_units())
+    if (CU->getUnitDIE().find(
+            {dwarf::DW_AT_dwo_name, dwarf::DW_AT_GNU_dwo_name}))
+      return true;
+  return false;
+}
+
 Expected<SymbolizableModule *>
 LLVMSymbolizer::createModuleInfo(const ObjectFile *Obj,
                                  std::unique_ptr<DIContext> Context,
                                  StringRef ModuleName) {
+  // An index answers queries from the debug info the module is created
+  // with, so it is keyed on where that debug info came from. Otherwise an
+  // index built before a separate debug file was installed would keep
+  // hiding it. Modules with split DWARF are not indexed, as whether their
+  // .dwo or .dwp files are found is not part of the key.
+  std::string DebugInfoKey;
+  bool UseIndex = !Opts.IndexCacheDirectory.empty();
+  if (UseIndex) {
+    DebugInfoKey = "nodwarf";
+    if (auto *DCtx = dyn_cast<DWARFContext>(Context.get()))
+      if (DCtx->getNumCompileUnits() != 0) {
+        const ObjectFile *DebugObj = DCtx->getDWARFObj().getFile();
+        StringRef DebugPath = DebugObj ? DebugObj->getFileName() : "";
+        DebugInfoKey = "dwarf" + utohexstr(xxHash64(DebugPath));
+        UseIndex = !hasSkeletonUnits(*DCtx);
+      }
+  }
   auto InfoOrErr = SymbolizableObjectFile::create(Obj, std::move(Context),
                                                   Opts.UntagAddresses);
   std::unique_ptr<SymbolizableModule> SymMod;
-  if (InfoOrErr)
-    SymMod = std::move(*InfoOrErr);
+  if (InfoOrErr) {
+    if (!UseIndex)
+      SymMod = std::move(*InfoOrErr);
+    else
+      SymMod = getIndexedModule(Obj, DebugInfoKey, std::move(*InfoOrErr));
+  }
   auto InsertResult = Modules.insert(
       std::make_pair(std::string(ModuleName), std::move(SymMod)));
   assert(InsertResult.second);
@@ -597,6 +729,101 @@ LLVMSymbolizer::createModuleInfo(const ObjectFile *Obj,
   return InsertResult.first->second.get();
 }
 
+std::unique_ptr<SymbolizableModule> LLVMSymbolizer::getIndexedModule(
+    const ObjectFile *Obj, StringRef DebugInfoKey,
+    std::unique_ptr<SymbolizableObjectFile> Module) {
+  // Relocatable objects are symbolized by section-relative addresses, which
+  // the index does not record.
+  const auto *ELFObj = dyn_cast<ELFObjectFileBase>(Obj);
+  if (!ELFObj || ELFObj->isRelocatableObject())
+    return std::move(Module);
+  Optional<ArrayRef<uint8_t>> BuildID = getBuildID(ELFObj);
+  if (!BuildID || BuildID->empty())
+    return std::move(Module);
+
+  // The index depends on its format, the debug info and the options
+  // affecting code queries, so make them part of the key.
+  std::string Key = toHex(*BuildID, /*LowerCase=*/true);
+  Key += "-" + DebugInfoKey.str();
+  Key += "-symidx" + utostr(index::Version) + "-" +
+         utostr(static_cast<unsigned>(Opts.PathStyle)) +
+         utostr(static_cast<unsigned>(Opts.PrintFunctions)) +
+         utostr(Opts.UseSymbolTable) + utostr(Opts.UntagAddresses);
+
+  // Fallback is left untouched if the cached index is malformed.
+  const SymbolizableObjectFile &ObjModule = *Module;
+  std::unique_ptr<SymbolizableModule> Fallback = std::move(Module);
+  for (unsigned Attempt = 0; Attempt != 2; ++Attempt) {
+    std::unique_ptr<MemoryBuffer> IndexBuffer = getIndex(ObjModule, Key);
+    if (!IndexBuffer)
+      return Fallback;
+    Expected<std::unique_ptr<IndexedSymbolizableModule>> IndexedOrErr =
+        IndexedSymbolizableModule::create(std::move(IndexBuffer),
+                                          std::move(Fallback));
+    if (IndexedOrErr)
+      return std::move(*IndexedOrErr);
+    consumeError(IndexedOrErr.takeError());
+
+    // A malformed entry, such as a truncated file, would be hit by every
+    // later run. Remove it, so that the index is built again.
+    SmallString<128> EntryPath;
+    sys::path::append(EntryPath, Opts.IndexCacheDirectory, "llvmcache-" + Key);
+    if (sys::fs::remove(EntryPath))
+      break;
+  }
+  return Fallback;
+}
+
+std::unique_ptr<MemoryBuffer>
+LLVMSymbolizer::getIndex(const SymbolizableObjectFile &Module, StringRef Key) {
+  std::unique_ptr<MemoryBuffer> IndexBuffer;
+  Expected<FileCache> CacheOrErr = localCache(
+      "llvm-symbolizer index", "llvm-symbolizer-index",
+      Opts.IndexCacheDirectory,
+      [&](size_t Task, std::unique_ptr<MemoryBuffer> MB) {
+        IndexBuffer = std::move(MB);
+      });
+  if (!CacheOrErr) {
+    consumeError(CacheOrErr.takeError());
+    return nullptr;
+  }
+  Expected<AddStreamFn> AddStreamOrErr = (*CacheOrErr)(0, Key);
+  if (!AddStreamOrErr) {
+    consumeError(AddStreamOrErr.takeError());
+    return nullptr;
+  }
+
+  if (AddStreamFn &AddStream = *AddStreamOrErr) {
+    // Cache miss: build the index in memory first, so that a failure never
+    // leaves a partial file behind. Destroying the stream commits it to the
+    // cache, which hands the committed file back through the buffer callback.
+    SmallString<0> Index;
+    raw_svector_ostream IndexOS(Index);
+    if (Error E = IndexedSymbolizableModule::writeIndex(
+            Module, DILineInfoSpecifier(Opts.PathStyle, Opts.PrintFunctions),
+            Opts.UseSymbolTable, IndexOS)) {
+      consumeError(std::move(E));
+      return nullptr;
+    }
+    Expected<std::unique_ptr<CachedFileStream>> StreamOrErr = AddStream(0);
+    if (!StreamOrErr) {
+      consumeError(StreamOrErr.takeError());
+      return nullptr;
+    }
+    *(*StreamOrErr)->OS << Index;
+    StreamOrErr->reset();
+
+    if (!Opts.IndexCachePruningPolicy.empty()) {
+      if (Expected<CachePruningPolicy> PolicyOrErr =
+              parseCachePruningPolicy(Opts.IndexCachePruningPolicy))
+        llvm::pruneCache(Opts.IndexCacheDirectory, *PolicyOrErr);
+      else
+        consumeError(PolicyOrErr.takeError());
+    }
+  }
+  return IndexBuffer;
+}
+
 Expected<SymbolizableModule *>
 LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
   std::string BinaryName = ModuleName;
@@ -647,17 +874,29 @@ LLVMSymbolizer::getOrCreateModuleInfo(const std::string &ModuleName) {
       Context.reset(new PDBContext(*CoffObject, std::move(Session)));
     }
   }
-  if (!Context)
-    Context = DWARFContext::create(
+  DWARFContext *DCtx = nullptr;
+  if (!Context) {
+    std::unique_ptr<DWARFContext> DWARFCtx = DWARFContext::create(
         *Objects.second, DWARFContext::ProcessDebugRelocations::Process,
         nullptr, Opts.DWPName);
+    DCtx = DWARFCtx.get();
+    Context = std::move(DWARFCtx);
+  }
   auto ModuleOrErr =
       createModuleInfo(Objects.first, std::move(Context), ModuleName);
   if (ModuleOrErr) {
     auto I = Modules.find(ModuleName);
-    BinaryForPath.find(BinaryName)->second.pushEvictor([this, I]() {
-      Modules.erase(I);
-    });
+    bool Budgeted = DCtx && Opts.DIEMemoryBudget;
+    if (Budgeted) {
+      DCtx->setDIEMemoryBudget(Opts.DIEMemoryBudget);
+      DWARFContexts[ModuleName] = DCtx;
+    }
+    BinaryForPath.find(BinaryName)->second.pushEvictor(
+        [this, I, Budgeted]() {
+          if (Budgeted)
+            DWARFContexts.erase(I->first);
+          Modules.erase(I);
+        });
   }
   return ModuleOrErr;
 }
@@ -669,9 +908,16 @@ LLVMSymbolizer::getOrCreateModuleInfo(const ObjectFile &Obj) {
   if (I != Modules.end())
     return I->second.get();
 
-  std::unique_ptr<DIContext> Context = DWARFContext::create(Obj);
+  std::unique_ptr<DWARFContext> Context = DWARFContext::create(Obj);
+  DWARFContext *DCtx = Context.get();
   // FIXME: handle COFF object with PDB info to use PDBContext
-  return createModuleInfo(&Obj, std::move(Context), ObjName);
+  Expected<SymbolizableModule *> ModuleOrErr =
+      createModuleInfo(&Obj, std::move(Context), ObjName);
+  if (ModuleOrErr && Opts.DIEMemoryBudget) {
+    DCtx->setDIEMemoryBudget(Opts.DIEMemoryBudget);
+    DWARFContexts[std::string(ObjName)] = DCtx;
+  }
+  return ModuleOrErr;
 }
 
 Expected<SymbolizableModule *>
@@ -743,7 +989,7 @@ LLVMSymbolizer::DemangleName(const std::string &Name,
 }
 
 void LLVMSymbolizer::recordAccess(CachedBinary &Bin) {
-  if (Bin->getBinary())
+  if (Bin.getBinary())
     LRUBinaries.splice(LRUBinaries.end(), LRUBinaries, Bin.getIterator());
 }
 
@@ -758,6 +1004,9 @@ void LLVMSymbolizer::pruneCache() {
     LRUBinaries.pop_front();
     Bin.evict();
   }
+
+  for (auto &Entry : DWARFContexts)
+    Entry.second->pruneDIECache();
 }
 
 void CachedBinary::pushEvictor(std::function<void()> NewEvictor) {
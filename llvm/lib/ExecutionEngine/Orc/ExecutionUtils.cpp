@@ -360,6 +360,13 @@ Error StaticLibraryDefinitionGenerator::tryToGenerate(
   if (!Archive)
     return Error::success();
 
+  // Symbols are looked up one by one, so index the symbol table the first
+  // time the archive is searched. If the symbol table can't be indexed,
+  // findSym falls back to scanning it and reports the problem if it matters.
+  std::call_once(SymbolIndexOnce, [this]() {
+    consumeError(Archive->buildSymbolIndex());
+  });
+
   DenseSet<std::pair<StringRef, StringRef>> ChildBufferInfos;
 
   for (const auto &KV : Symbols) {
@@ -398,7 +405,6 @@ StaticLibraryDefinitionGenerator::StaticLibraryDefinitionGenerator(
     : L(L), GetObjFileInterface(std::move(GetObjFileInterface)),
       ArchiveBuffer(std::move(ArchiveBuffer)),
       Archive(std::make_unique<object::Archive>(*this->ArchiveBuffer, Err)) {
-
   if (!this->GetObjFileInterface)
     this->GetObjFileInterface = getObjectFileInterface;
 }
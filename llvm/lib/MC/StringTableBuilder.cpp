@@ -14,6 +14,7 @@
 #include "llvm/BinaryFormat/COFF.h"
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/raw_ostream.h"
 #include <cassert>
 #include <cstddef>
@@ -125,6 +126,44 @@ tailcall:
   }
 }
 
+// Tables with at least this many strings are sorted by tailMergeSort.
+static const size_t ParallelSortThreshold = 1 << 14;
+
+// Sort Vec in the same order as multikeySort(Vec, 0), concurrently according
+// to parallel::strategy. Strings are first distributed into buckets by their
+// last two characters, which multikeySort would compare first, and the buckets
+// are then sorted independently. As the strings are distinct, the result does
+// not depend on how the work is split.
+static void tailMergeSort(MutableArrayRef<StringPair *> Vec) {
+  // charTailAt returns values in [-1, 256), so each character selects one of
+  // 257 keys. Keys are numbered in descending order to match multikeySort.
+  const size_t NumKeys = 257;
+  auto getBucket = [&](StringPair *P) {
+    return (255 - charTailAt(P, 0)) * NumKeys + (255 - charTailAt(P, 1));
+  };
+
+  std::vector<size_t> Begin(NumKeys * NumKeys + 1);
+  for (StringPair *P : Vec)
+    ++Begin[getBucket(P) + 1];
+  for (size_t I = 1; I < Begin.size(); ++I)
+    Begin[I] += Begin[I - 1];
+
+  std::vector<StringPair *> Sorted(Vec.size());
+  std::vector<size_t> Next(Begin.begin(), Begin.end() - 1);
+  for (StringPair *P : Vec)
+    Sorted[Next[getBucket(P)]++] = P;
+  std::copy(Sorted.begin(), Sorted.end(), Vec.begin());
+
+  std::vector<size_t> Buckets;
+  for (size_t I = 0; I + 1 < Begin.size(); ++I)
+    if (Begin[I + 1] - Begin[I] > 1)
+      Buckets.push_back(I);
+  parallelForEachN(0, Buckets.size(), [&](size_t I) {
+    size_t B = Buckets[I];
+    multikeySort(Vec.slice(Begin[B], Begin[B + 1] - Begin[B]), 2);
+  });
+}
+
 void StringTableBuilder::finalize() {
   assert(K != DWARF);
   finalizeStringTable(/*Optimize=*/true);
@@ -143,7 +182,10 @@ void StringTableBuilder::finalizeStringTable(bool Optimize) {
     for (StringPair &P : StringIndexMap)
       Strings.push_back(&P);
 
-    multikeySort(Strings, 0);
+    if (Strings.size() >= ParallelSortThreshold)
+      tailMergeSort(Strings);
+    else
+      multikeySort(Strings, 0);
     initSize();
 
     StringRef Previous;
@@ -12,6 +12,7 @@
 #include "llvm/ObjCopy/ObjCopy.h"
 #include "llvm/Object/Error.h"
 #include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 
 namespace llvm {
@@ -22,6 +23,10 @@ using namespace llvm::object;
 Expected<std::vector<NewArchiveMember>>
 createNewArchiveMembers(const MultiFormatConfig &Config, const Archive &Ar) {
   std::vector<NewArchiveMember> NewArchiveMembers;
+  std::vector<StringRef> ChildNames;
+  std::vector<std::unique_ptr<Binary>> ChildBinaries;
+  // Reading the children may modify the archive (e.g. to keep the buffers of
+  // thin archive members alive), so it is done serially.
   Error Err = Error::success();
   for (const Archive::Child &Child : Ar.children(Err)) {
     Expected<StringRef> ChildNameOrErr = Child.getName();
@@ -33,25 +38,56 @@ createNewArchiveMembers(const MultiFormatConfig &Config, const Archive &Ar) {
       return createFileError(Ar.getFileName() + "(" + *ChildNameOrErr + ")",
                              ChildOrErr.takeError());
 
-    SmallVector<char, 0> Buffer;
-    raw_svector_ostream MemStream(Buffer);
-
-    if (Error E = executeObjcopyOnBinary(Config, *ChildOrErr->get(), MemStream))
-      return std::move(E);
-
     Expected<NewArchiveMember> Member = NewArchiveMember::getOldMember(
         Child, Config.getCommonConfig().DeterministicArchives);
     if (!Member)
       return createFileError(Ar.getFileName(), Member.takeError());
 
-    Member->Buf = std::make_unique<SmallVectorMemoryBuffer>(
-        std::move(Buffer), ChildNameOrErr.get());
-    Member->MemberName = Member->Buf->getBufferIdentifier();
+    ChildNames.push_back(*ChildNameOrErr);
+    ChildBinaries.push_back(std::move(*ChildOrErr));
     NewArchiveMembers.push_back(std::move(*Member));
   }
   if (Err)
     return createFileError(Config.getCommonConfig().InputFilename,
                            std::move(Err));
+
+  std::vector<SmallVector<char, 0>> Buffers(ChildBinaries.size());
+  if (!Config.getCommonConfig().DumpSection.empty()) {
+    // Every member dumps its sections to the same files, so they have to be
+    // processed in order for the last member to win.
+    for (size_t I = 0, E = ChildBinaries.size(); I != E; ++I) {
+      raw_svector_ostream MemStream(Buffers[I]);
+      if (Error Err =
+              executeObjcopyOnBinary(Config, *ChildBinaries[I], MemStream))
+        return std::move(Err);
+    }
+  } else {
+    // Otherwise the members are independent of each other, so they are
+    // transformed according to parallel::strategy. Results are stored by
+    // index to keep the archive, and the error reported for it,
+    // deterministic.
+    std::vector<Optional<Error>> Errors(ChildBinaries.size());
+    parallelForEachN(0, ChildBinaries.size(), [&](size_t I) {
+      raw_svector_ostream MemStream(Buffers[I]);
+      Errors[I] = executeObjcopyOnBinary(Config, *ChildBinaries[I], MemStream);
+    });
+
+    Error FirstErr = Error::success();
+    for (Optional<Error> &E : Errors)
+      if (FirstErr)
+        consumeError(std::move(*E));
+      else
+        FirstErr = std::move(*E);
+    if (FirstErr)
+      return std::move(FirstErr);
+  }
+
+  for (size_t I = 0, E = NewArchiveMembers.size(); I != E; ++I) {
+    NewArchiveMember &Member = NewArchiveMembers[I];
+    Member.Buf = std::make_unique<SmallVectorMemoryBuffer>(
+        std::move(Buffers[I]), ChildNames[I]);
+    Member.MemberName = Member.Buf->getBufferIdentifier();
+  }
   return std::move(NewArchiveMembers);
 }
 
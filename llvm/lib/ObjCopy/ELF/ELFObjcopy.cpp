@@ -506,15 +506,24 @@ static Error replaceAndRemoveSections(const CommonConfig &Config,
     return E;
 
   if (Config.CompressionType != DebugCompressionType::None) {
+    // Compress all sections up front so that they can be compressed
+    // concurrently. replaceDebugSections visits them in the same order.
+    SmallVector<const SectionBase *, 13> ToCompress;
+    for (const SectionBase &Sec : Obj.sections())
+      if (isCompressable(Sec))
+        ToCompress.push_back(&Sec);
+    Expected<std::vector<CompressedSection>> Compressed =
+        CompressedSection::create(ToCompress, Config.CompressionType);
+    if (!Compressed)
+      return Compressed.takeError();
+
+    size_t Next = 0;
     if (Error Err = replaceDebugSections(
             Obj, isCompressable,
-            [&Config, &Obj](const SectionBase *S) -> Expected<SectionBase *> {
-              Expected<CompressedSection> NewSection =
-                  CompressedSection::create(*S, Config.CompressionType);
-              if (!NewSection)
-                return NewSection.takeError();
-
-              return &Obj.addSection<CompressedSection>(std::move(*NewSection));
+            [&](const SectionBase *S) -> Expected<SectionBase *> {
+              assert(ToCompress[Next] == S && "sections visited out of order");
+              return &Obj.addSection<CompressedSection>(
+                  std::move((*Compressed)[Next++]));
             }))
       return Err;
   } else if (Config.DecompressDebugSections) {
@@ -20,11 +20,14 @@
 #include "llvm/Support/Endian.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/FileOutputBuffer.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include <algorithm>
 #include <cstddef>
 #include <cstdint>
 #include <iterator>
+#include <numeric>
+#include <set>
 #include <unordered_set>
 #include <utility>
 #include <vector>
@@ -35,8 +38,8 @@ using namespace llvm::objcopy::elf;
 using namespace llvm::object;
 
 template <class ELFT> void ELFWriter<ELFT>::writePhdr(const Segment &Seg) {
-  uint8_t *B = reinterpret_cast<uint8_t *>(Buf->getBufferStart()) +
-               Obj.ProgramHdrSegment.Offset + Seg.Index * sizeof(Elf_Phdr);
+  uint8_t *B =
+      getBufferAt(Obj.ProgramHdrSegment.Offset + Seg.Index * sizeof(Elf_Phdr));
   Elf_Phdr &Phdr = *reinterpret_cast<Elf_Phdr *>(B);
   Phdr.p_type = Seg.Type;
   Phdr.p_flags = Seg.Flags;
@@ -65,8 +68,7 @@ void SectionBase::replaceSectionReferences(
 void SectionBase::onRemove() {}
 
 template <class ELFT> void ELFWriter<ELFT>::writeShdr(const SectionBase &Sec) {
-  uint8_t *B =
-      reinterpret_cast<uint8_t *>(Buf->getBufferStart()) + Sec.HeaderOffset;
+  uint8_t *B = getBufferAt(Sec.HeaderOffset);
   Elf_Shdr &Shdr = *reinterpret_cast<Elf_Shdr *>(B);
   Shdr.sh_name = Sec.NameIndex;
   Shdr.sh_type = Sec.Type;
@@ -167,9 +169,18 @@ Error BinarySectionWriter::visit(const GroupSection &Sec) {
                            "cannot write '" + Sec.Name + "' out to binary");
 }
 
+uint8_t *SectionWriter::getSectionBuffer(const SectionBase &Sec) {
+  return reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+}
+
+void SectionWriter::writeSectionContents(const SectionBase &Sec,
+                                         ArrayRef<uint8_t> Data) {
+  llvm::copy(Data, getSectionBuffer(Sec));
+}
+
 Error SectionWriter::visit(const Section &Sec) {
   if (Sec.Type != SHT_NOBITS)
-    llvm::copy(Sec.Contents, Out.getBufferStart() + Sec.Offset);
+    writeSectionContents(Sec, Sec.Contents);
 
   return Error::success();
 }
@@ -430,7 +441,7 @@ Error Section::accept(MutableSectionVisitor &Visitor) {
 }
 
 Error SectionWriter::visit(const OwnedDataSection &Sec) {
-  llvm::copy(Sec.Data, Out.getBufferStart() + Sec.Offset);
+  writeSectionContents(Sec, Sec.Data);
   return Error::success();
 }
 
@@ -457,23 +468,56 @@ getDecompressedSizeAndAlignment(ArrayRef<uint8_t> Data) {
   return std::make_tuple(DecompressedSize, DecompressedAlign);
 }
 
+static Error uncompressSectionData(uint32_t CompressionType,
+                                   StringRef CompressedContent,
+                                   SmallVectorImpl<char> &DecompressedContent,
+                                   size_t DecompressedSize) {
+  switch (CompressionType) {
+  case ELF::ELFCOMPRESS_ZLIB:
+    if (!zlib::isAvailable())
+      return createStringError(
+          errc::invalid_argument,
+          "LLVM was not compiled with LLVM_ENABLE_ZLIB: cannot decompress");
+    return zlib::uncompress(CompressedContent, DecompressedContent,
+                            DecompressedSize);
+  case ELF::ELFCOMPRESS_ZSTD:
+    if (!zstd::isAvailable())
+      return createStringError(
+          errc::invalid_argument,
+          "LLVM was not compiled with LLVM_ENABLE_ZSTD: cannot decompress");
+    return zstd::uncompress(CompressedContent, DecompressedContent,
+                            DecompressedSize);
+  default:
+    return createStringError(errc::not_supported,
+                             "unsupported compression type %" PRIu32,
+                             CompressionType);
+  }
+}
+
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const DecompressedSection &Sec) {
-  const size_t DataOffset = isDataGnuCompressed(Sec.OriginalData)
+  const bool IsGnuStyle = isDataGnuCompressed(Sec.OriginalData);
+  const size_t DataOffset = IsGnuStyle
                                 ? (ZlibGnuMagic.size() + sizeof(Sec.Size))
                                 : sizeof(Elf_Chdr_Impl<ELFT>);
+  const uint32_t CompressionType =
+      IsGnuStyle ? ELF::ELFCOMPRESS_ZLIB
+                 : reinterpret_cast<const Elf_Chdr_Impl<ELFT> *>(
+                       Sec.OriginalData.data())
+                       ->ch_type;
 
   StringRef CompressedContent(
       reinterpret_cast<const char *>(Sec.OriginalData.data()) + DataOffset,
       Sec.OriginalData.size() - DataOffset);
 
   SmallVector<char, 128> DecompressedContent;
-  if (Error Err = zlib::uncompress(CompressedContent, DecompressedContent,
-                                   static_cast<size_t>(Sec.Size)))
+  if (Error Err = uncompressSectionData(CompressionType, CompressedContent,
+                                       DecompressedContent,
+                                       static_cast<size_t>(Sec.Size)))
     return createStringError(errc::invalid_argument,
                              "'" + Sec.Name + "': " + toString(std::move(Err)));
 
-  uint8_t *Buf = reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+  uint8_t *Buf = getSectionBuffer(Sec);
   std::copy(DecompressedContent.begin(), DecompressedContent.end(), Buf);
 
   return Error::success();
@@ -518,7 +562,7 @@ Error BinarySectionWriter::visit(const CompressedSection &Sec) {
 
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const CompressedSection &Sec) {
-  uint8_t *Buf = reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+  uint8_t *Buf = getSectionBuffer(Sec);
   if (Sec.CompressionType == DebugCompressionType::None) {
     std::copy(Sec.OriginalData.begin(), Sec.OriginalData.end(), Buf);
     return Error::success();
@@ -534,7 +578,9 @@ Error ELFSectionWriter<ELFT>::visit(const CompressedSection &Sec) {
     Buf += sizeof(DecompressedSize);
   } else {
     Elf_Chdr_Impl<ELFT> Chdr;
-    Chdr.ch_type = ELF::ELFCOMPRESS_ZLIB;
+    Chdr.ch_type = Sec.CompressionType == DebugCompressionType::Zstd
+                       ? ELF::ELFCOMPRESS_ZSTD
+                       : ELF::ELFCOMPRESS_ZLIB;
     Chdr.ch_size = Sec.DecompressedSize;
     Chdr.ch_addralign = Sec.DecompressedAlign;
     memcpy(Buf, &Chdr, sizeof(Chdr));
@@ -548,14 +594,45 @@ Error ELFSectionWriter<ELFT>::visit(const CompressedSection &Sec) {
 Expected<CompressedSection>
 CompressedSection::create(const SectionBase &Sec,
                           DebugCompressionType CompressionType) {
-  Error Err = Error::success();
-  CompressedSection Section(Sec, CompressionType, Err);
-
-  if (Err)
+  CompressedSection Section(Sec, CompressionType);
+  if (Error Err = Section.compress())
     return std::move(Err);
 
   return Section;
 }
+
+Expected<std::vector<CompressedSection>>
+CompressedSection::create(ArrayRef<const SectionBase *> Sections,
+                          DebugCompressionType CompressionType) {
+  std::vector<CompressedSection> Result;
+  for (const SectionBase *Sec : Sections)
+    Result.push_back(CompressedSection(*Sec, CompressionType));
+
+  // Sections that span several shards are compressed one after another, each
+  // with its shards in parallel. All other sections are compressed
+  // concurrently with each other.
+  std::vector<Optional<Error>> Errors(Result.size());
+  auto IsLarge = [](const CompressedSection &Sec) {
+    return Sec.OriginalData.size() >
+           (Sec.CompressionType == DebugCompressionType::Zstd
+                ? zstd::ParallelShardSize
+                : zlib::ParallelShardSize);
+  };
+  for (size_t I = 0, E = Result.size(); I != E; ++I)
+    if (IsLarge(Result[I]))
+      Errors[I] = Result[I].compress();
+  parallelForEachN(0, Result.size(), [&](size_t I) {
+    if (!IsLarge(Result[I]))
+      Errors[I] = Result[I].compress();
+  });
+
+  Error Err = Error::success();
+  for (Optional<Error> &E : Errors)
+    Err = joinErrors(std::move(Err), std::move(*E));
+  if (Err)
+    return std::move(Err);
+  return std::move(Result);
+}
 Expected<CompressedSection>
 CompressedSection::create(ArrayRef<uint8_t> CompressedData,
                           uint64_t DecompressedSize,
@@ -564,24 +641,22 @@ CompressedSection::create(ArrayRef<uint8_t> CompressedData,
 }
 
 CompressedSection::CompressedSection(const SectionBase &Sec,
-                                     DebugCompressionType CompressionType,
-                                     Error &OutErr)
+                                     DebugCompressionType CompressionType)
     : SectionBase(Sec), CompressionType(CompressionType),
-      DecompressedSize(Sec.OriginalData.size()), DecompressedAlign(Sec.Align) {
-  ErrorAsOutParameter EAO(&OutErr);
-
-  if (Error Err = zlib::compress(
-          StringRef(reinterpret_cast<const char *>(OriginalData.data()),
-                    OriginalData.size()),
-          CompressedData)) {
-    OutErr = createStringError(llvm::errc::invalid_argument,
-                               "'" + Name + "': " + toString(std::move(Err)));
-    return;
-  }
+      DecompressedSize(Sec.OriginalData.size()), DecompressedAlign(Sec.Align) {}
+
+Error CompressedSection::compress() {
+  StringRef Data(reinterpret_cast<const char *>(OriginalData.data()),
+                 OriginalData.size());
+  if (Error Err = CompressionType == DebugCompressionType::Zstd
+                      ? zstd::compressParallel(Data, CompressedData)
+                      : zlib::compressParallel(Data, CompressedData))
+    return createStringError(llvm::errc::invalid_argument,
+                             "'" + Name + "': " + toString(std::move(Err)));
 
   size_t ChdrSize;
   if (CompressionType == DebugCompressionType::GNU) {
-    Name = ".z" + Sec.Name.substr(1);
+    Name = ".z" + Name.substr(1);
     ChdrSize = sizeof("ZLIB") - 1 + sizeof(uint64_t);
   } else {
     Flags |= ELF::SHF_COMPRESSED;
@@ -593,6 +668,7 @@ CompressedSection::CompressedSection(const SectionBase &Sec,
   }
   Size = ChdrSize + CompressedData.size();
   Align = 8;
+  return Error::success();
 }
 
 CompressedSection::CompressedSection(ArrayRef<uint8_t> CompressedData,
@@ -623,8 +699,7 @@ void StringTableSection::prepareForLayout() {
 }
 
 Error SectionWriter::visit(const StringTableSection &Sec) {
-  Sec.StrTabBuilder.write(reinterpret_cast<uint8_t *>(Out.getBufferStart()) +
-                          Sec.Offset);
+  Sec.StrTabBuilder.write(getSectionBuffer(Sec));
   return Error::success();
 }
 
@@ -638,7 +713,7 @@ Error StringTableSection::accept(MutableSectionVisitor &Visitor) {
 
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const SectionIndexSection &Sec) {
-  uint8_t *Buf = reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+  uint8_t *Buf = getSectionBuffer(Sec);
   llvm::copy(Sec.Indexes, reinterpret_cast<Elf_Word *>(Buf));
   return Error::success();
 }
@@ -870,7 +945,7 @@ Expected<Symbol *> SymbolTableSection::getSymbolByIndex(uint32_t Index) {
 
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const SymbolTableSection &Sec) {
-  Elf_Sym *Sym = reinterpret_cast<Elf_Sym *>(Out.getBufferStart() + Sec.Offset);
+  Elf_Sym *Sym = reinterpret_cast<Elf_Sym *>(getSectionBuffer(Sec));
   // Loop though symbols setting each entry of the symbol table.
   for (const std::unique_ptr<Symbol> &Symbol : Sec.Symbols) {
     Sym->st_name = Symbol->NameIndex;
@@ -990,7 +1065,7 @@ static void writeRel(const RelRange &Relocations, T *Buf, bool IsMips64EL) {
 
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const RelocationSection &Sec) {
-  uint8_t *Buf = reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+  uint8_t *Buf = getSectionBuffer(Sec);
   if (Sec.Type == SHT_REL)
     writeRel(Sec.Relocations, reinterpret_cast<Elf_Rel *>(Buf),
              Sec.getObject().IsMips64EL);
@@ -1033,7 +1108,7 @@ void RelocationSection::replaceSectionReferences(
 }
 
 Error SectionWriter::visit(const DynamicRelocationSection &Sec) {
-  llvm::copy(Sec.Contents, Out.getBufferStart() + Sec.Offset);
+  writeSectionContents(Sec, Sec.Contents);
   return Error::success();
 }
 
@@ -1179,8 +1254,7 @@ GnuDebugLinkSection::GnuDebugLinkSection(StringRef File,
 
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const GnuDebugLinkSection &Sec) {
-  unsigned char *Buf =
-      reinterpret_cast<uint8_t *>(Out.getBufferStart()) + Sec.Offset;
+  unsigned char *Buf = getSectionBuffer(Sec);
   Elf_Word *CRC =
       reinterpret_cast<Elf_Word *>(Buf + Sec.Size - sizeof(Elf_Word));
   *CRC = Sec.CRC32;
@@ -1199,7 +1273,7 @@ Error GnuDebugLinkSection::accept(MutableSectionVisitor &Visitor) {
 template <class ELFT>
 Error ELFSectionWriter<ELFT>::visit(const GroupSection &Sec) {
   ELF::Elf32_Word *Buf =
-      reinterpret_cast<ELF::Elf32_Word *>(Out.getBufferStart() + Sec.Offset);
+      reinterpret_cast<ELF::Elf32_Word *>(getSectionBuffer(Sec));
   support::endian::write32<ELFT::TargetEndianness>(Buf++, Sec.FlagWord);
   for (SectionBase *S : Sec.GroupMembers)
     support::endian::write32<ELFT::TargetEndianness>(Buf++, S->Index);
@@ -2008,7 +2082,7 @@ Expected<std::unique_ptr<Object>> ELFReader::create(bool EnsureSymtab) const {
 }
 
 template <class ELFT> void ELFWriter<ELFT>::writeEhdr() {
-  Elf_Ehdr &Ehdr = *reinterpret_cast<Elf_Ehdr *>(Buf->getBufferStart());
+  Elf_Ehdr &Ehdr = *reinterpret_cast<Elf_Ehdr *>(getBufferAt(0));
   std::fill(Ehdr.e_ident, Ehdr.e_ident + 16, 0);
   Ehdr.e_ident[EI_MAG0] = 0x7f;
   Ehdr.e_ident[EI_MAG1] = 'E';
@@ -2072,8 +2146,7 @@ template <class ELFT> void ELFWriter<ELFT>::writePhdrs() {
 template <class ELFT> void ELFWriter<ELFT>::writeShdrs() {
   // This reference serves to write the dummy section header at the begining
   // of the file. It is not used for anything else
-  Elf_Shdr &Shdr =
-      *reinterpret_cast<Elf_Shdr *>(Buf->getBufferStart() + Obj.SHOff);
+  Elf_Shdr &Shdr = *reinterpret_cast<Elf_Shdr *>(getBufferAt(Obj.SHOff));
   Shdr.sh_name = 0;
   Shdr.sh_type = SHT_NULL;
   Shdr.sh_flags = 0;
@@ -2098,45 +2171,153 @@ template <class ELFT> void ELFWriter<ELFT>::writeShdrs() {
     writeShdr(Sec);
 }
 
-template <class ELFT> Error ELFWriter<ELFT>::writeSectionData() {
-  for (SectionBase &Sec : Obj.sections())
-    // Segments are responsible for writing their contents, so only write the
-    // section data if the section is not in a segment. Note that this renders
-    // sections in segments effectively immutable.
-    if (Sec.ParentSegment == nullptr)
-      if (Error Err = Sec.accept(*SecWriter))
-        return Err;
+namespace {
+// Renders the contents of one section at a time for ELFWriter::write.
+// Contents that are already in memory, such as those of sections copied from
+// the input file, are referenced instead of being copied. Anything else is
+// rendered into a buffer of its own.
+template <class ELFT>
+class StreamingSectionWriter : public ELFSectionWriter<ELFT> {
+  std::unique_ptr<WritableMemoryBuffer> SecBuf;
+  ArrayRef<uint8_t> Contents;
+
+protected:
+  uint8_t *getSectionBuffer(const SectionBase &Sec) override {
+    SecBuf = WritableMemoryBuffer::getNewMemBuffer(Sec.Size);
+    if (!SecBuf)
+      report_bad_alloc_error("failed to allocate section buffer");
+    Contents = makeArrayRef(
+        reinterpret_cast<const uint8_t *>(SecBuf->getBufferStart()),
+        SecBuf->getBufferSize());
+    return reinterpret_cast<uint8_t *>(SecBuf->getBufferStart());
+  }
+
+  void writeSectionContents(const SectionBase &,
+                            ArrayRef<uint8_t> Data) override {
+    Contents = Data;
+  }
+
+public:
+  explicit StreamingSectionWriter(WritableMemoryBuffer &EmptyBuf)
+      : ELFSectionWriter<ELFT>(EmptyBuf) {}
+
+  // Return the contents of Sec. If they had to be rendered, the buffer holding
+  // them is moved to Storage.
+  Expected<ArrayRef<uint8_t>>
+  render(const SectionBase &Sec,
+         std::unique_ptr<WritableMemoryBuffer> &Storage) {
+    Contents = {};
+    if (Error E = Sec.accept(*this))
+      return std::move(E);
+    Storage = std::move(SecBuf);
+    return Contents;
+  }
+};
+} // namespace
+
+template <class ELFT>
+void ELFWriter<ELFT>::addChunk(uint64_t Offset, uint64_t Size,
+                               ArrayRef<uint8_t> Data,
+                               const SectionBase *Sec) {
+  Chunks.emplace_back();
+  OutputChunk &Chunk = Chunks.back();
+  Chunk.Offset = Offset;
+  Chunk.Size = Size;
+  Chunk.Data = Data;
+  Chunk.Sec = Sec;
+}
 
+template <class ELFT>
+Error ELFWriter<ELFT>::addHeaderChunk(uint64_t Offset, uint64_t Size,
+                                      function_ref<void()> WriteHeaders) {
+  Buf = WritableMemoryBuffer::getNewMemBuffer(Size);
+  if (!Buf)
+    return createStringError(errc::not_enough_memory,
+                             "failed to allocate memory buffer of " +
+                                 Twine::utohexstr(Size) + " bytes");
+  BufOffset = Offset;
+  WriteHeaders();
+  addChunk(Offset, Size,
+           makeArrayRef(
+               reinterpret_cast<const uint8_t *>(Buf->getBufferStart()), Size));
+  Chunks.back().Storage = std::move(Buf);
   return Error::success();
 }
 
-template <class ELFT> void ELFWriter<ELFT>::writeSegmentData() {
-  for (Segment &Seg : Obj.segments()) {
-    size_t Size = std::min<size_t>(Seg.FileSize, Seg.getContents().size());
-    std::memcpy(Buf->getBufferStart() + Seg.Offset, Seg.getContents().data(),
-                Size);
-  }
+template <class ELFT> Error ELFWriter<ELFT>::writeChunks() {
+  std::unique_ptr<WritableMemoryBuffer> EmptyBuffer =
+      WritableMemoryBuffer::getNewMemBuffer(0);
+  if (!EmptyBuffer)
+    return createStringError(errc::not_enough_memory,
+                             "failed to allocate memory buffer of 0 bytes");
+  StreamingSectionWriter<ELFT> SecWriter(*EmptyBuffer);
 
-  for (auto it : Obj.getUpdatedSections()) {
-    SectionBase *Sec = it.first;
-    ArrayRef<uint8_t> Data = it.second;
+  std::vector<size_t> ByOffset(Chunks.size());
+  std::iota(ByOffset.begin(), ByOffset.end(), 0);
+  llvm::stable_sort(ByOffset, [&](size_t LHS, size_t RHS) {
+    return Chunks[LHS].Offset < Chunks[RHS].Offset;
+  });
 
-    auto *Parent = Sec->ParentSegment;
-    assert(Parent && "This section should've been part of a segment.");
-    uint64_t Offset =
-        Sec->OriginalOffset - Parent->OriginalOffset + Parent->Offset;
-    llvm::copy(Data, Buf->getBufferStart() + Offset);
-  }
+  // Walk the file from start to end. Between any two chunk boundaries the
+  // contents come from the last added chunk covering that range, or are zero
+  // if there is none. Rendered sections are only kept while they are covered.
+  const uint64_t TotalSize = totalSize();
+  std::set<size_t> Active;
+  size_t NextChunk = 0;
+  uint64_t Pos = 0;
+  while (Pos < TotalSize) {
+    for (; NextChunk < ByOffset.size() &&
+           Chunks[ByOffset[NextChunk]].Offset <= Pos;
+         ++NextChunk) {
+      const OutputChunk &Chunk = Chunks[ByOffset[NextChunk]];
+      if (Chunk.Offset + Chunk.Size > Pos)
+        Active.insert(ByOffset[NextChunk]);
+    }
 
-  // Iterate over removed sections and overwrite their old data with zeroes.
-  for (auto &Sec : Obj.removedSections()) {
-    Segment *Parent = Sec.ParentSegment;
-    if (Parent == nullptr || Sec.Type == SHT_NOBITS || Sec.Size == 0)
+    uint64_t End = TotalSize;
+    if (NextChunk < ByOffset.size())
+      End = std::min(End, Chunks[ByOffset[NextChunk]].Offset);
+    for (auto It = Active.begin(); It != Active.end();) {
+      OutputChunk &Chunk = Chunks[*It];
+      if (Chunk.Offset + Chunk.Size <= Pos) {
+        Chunk.Storage.reset();
+        It = Active.erase(It);
+        continue;
+      }
+      End = std::min(End, Chunk.Offset + Chunk.Size);
+      ++It;
+    }
+
+    if (Active.empty()) {
+      Out.write_zeros(End - Pos);
+      Pos = End;
       continue;
-    uint64_t Offset =
-        Sec.OriginalOffset - Parent->OriginalOffset + Parent->Offset;
-    std::memset(Buf->getBufferStart() + Offset, 0, Sec.Size);
+    }
+
+    OutputChunk &Chunk = Chunks[*Active.rbegin()];
+    if (Chunk.Sec) {
+      Expected<ArrayRef<uint8_t>> Data =
+          SecWriter.render(*Chunk.Sec, Chunk.Storage);
+      if (!Data)
+        return Data.takeError();
+      Chunk.Data = *Data;
+      Chunk.Sec = nullptr;
+    }
+
+    uint64_t From = Pos - Chunk.Offset;
+    uint64_t To = End - Chunk.Offset;
+    uint64_t DataEnd = std::min<uint64_t>(To, Chunk.Data.size());
+    if (From < DataEnd) {
+      Out.write(reinterpret_cast<const char *>(Chunk.Data.data()) + From,
+                DataEnd - From);
+      From = DataEnd;
+    }
+    Out.write_zeros(To - From);
+    Pos = End;
   }
+
+  Chunks.clear();
+  return Error::success();
 }
 
 template <class ELFT>
@@ -2511,20 +2692,57 @@ template <class ELFT> size_t ELFWriter<ELFT>::totalSize() const {
 }
 
 template <class ELFT> Error ELFWriter<ELFT>::write() {
-  // Segment data must be written first, so that the ELF header and program
-  // header tables can overwrite it, if covered by a segment.
-  writeSegmentData();
-  writeEhdr();
-  writePhdrs();
-  if (Error E = writeSectionData())
+  // The output is described as a list of chunks, which are then written in
+  // file order without materializing the whole file. Segment data comes
+  // first, so that the ELF header and program header tables can overwrite
+  // it, if covered by a segment.
+  for (Segment &Seg : Obj.segments()) {
+    size_t Size = std::min<size_t>(Seg.FileSize, Seg.getContents().size());
+    addChunk(Seg.Offset, Size, Seg.getContents().take_front(Size));
+  }
+
+  for (auto It : Obj.getUpdatedSections()) {
+    SectionBase *Sec = It.first;
+    ArrayRef<uint8_t> Data = It.second;
+
+    auto *Parent = Sec->ParentSegment;
+    assert(Parent && "This section should've been part of a segment.");
+    uint64_t Offset =
+        Sec->OriginalOffset - Parent->OriginalOffset + Parent->Offset;
+    addChunk(Offset, Data.size(), Data);
+  }
+
+  // Overwrite the old data of removed sections with zeroes.
+  for (auto &Sec : Obj.removedSections()) {
+    Segment *Parent = Sec.ParentSegment;
+    if (Parent == nullptr || Sec.Type == SHT_NOBITS || Sec.Size == 0)
+      continue;
+    uint64_t Offset =
+        Sec.OriginalOffset - Parent->OriginalOffset + Parent->Offset;
+    addChunk(Offset, Sec.Size, {});
+  }
+
+  if (Error E = addHeaderChunk(0, sizeof(Elf_Ehdr), [&] { writeEhdr(); }))
     return E;
+  if (size_t PhNum = llvm::size(Obj.segments()))
+    if (Error E = addHeaderChunk(Obj.ProgramHdrSegment.Offset,
+                                 PhNum * sizeof(Elf_Phdr),
+                                 [&] { writePhdrs(); }))
+      return E;
+
+  // Segments are responsible for writing their contents, so only write the
+  // section data if the section is not in a segment. Note that this renders
+  // sections in segments effectively immutable.
+  for (SectionBase &Sec : Obj.sections())
+    if (Sec.ParentSegment == nullptr && Sec.Type != SHT_NOBITS)
+      addChunk(Sec.Offset, Sec.Size, {}, &Sec);
+
   if (WriteSectionHeaders)
-    writeShdrs();
+    if (Error E = addHeaderChunk(Obj.SHOff, totalSize() - Obj.SHOff,
+                                 [&] { writeShdrs(); }))
+      return E;
 
-  // TODO: Implement direct writing to the output stream (without intermediate
-  // memory buffer Buf).
-  Out.write(Buf->getBufferStart(), Buf->getBufferSize());
-  return Error::success();
+  return writeChunks();
 }
 
 static Error removeUnneededSections(Object &Obj) {
@@ -2645,14 +2863,6 @@ template <class ELFT> Error ELFWriter<ELFT>::finalize() {
     Sec.finalize();
   }
 
-  size_t TotalSize = totalSize();
-  Buf = WritableMemoryBuffer::getNewMemBuffer(TotalSize);
-  if (!Buf)
-    return createStringError(errc::not_enough_memory,
-                             "failed to allocate memory buffer of " +
-                                 Twine::utohexstr(TotalSize) + " bytes");
-
-  SecWriter = std::make_unique<ELFSectionWriter<ELFT>>(*Buf);
   return Error::success();
 }
 
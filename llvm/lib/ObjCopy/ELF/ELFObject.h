@@ -108,6 +108,13 @@ class SectionWriter : public SectionVisitor {
 protected:
   WritableMemoryBuffer &Out;
 
+  // Return the memory the contents of Sec are written to.
+  virtual uint8_t *getSectionBuffer(const SectionBase &Sec);
+  // Write Data, which stays valid until the output is written, as the contents
+  // of Sec.
+  virtual void writeSectionContents(const SectionBase &Sec,
+                                    ArrayRef<uint8_t> Data);
+
 public:
   virtual ~SectionWriter() = default;
 
@@ -333,12 +340,33 @@ private:
 
   void writePhdrs();
   void writeShdrs();
-  Error writeSectionData();
-  void writeSegmentData();
 
   void assignOffsets();
 
-  std::unique_ptr<ELFSectionWriter<ELFT>> SecWriter;
+  // A range of the output file and where its contents come from. Bytes past
+  // the end of Data are zero. Where chunks overlap, the one added last wins.
+  struct OutputChunk {
+    uint64_t Offset = 0;
+    uint64_t Size = 0;
+    ArrayRef<uint8_t> Data;
+    // If set, Data is rendered from this section when it is first needed.
+    const SectionBase *Sec = nullptr;
+    std::unique_ptr<WritableMemoryBuffer> Storage;
+  };
+
+  std::vector<OutputChunk> Chunks;
+  // The output offset that the start of Buf corresponds to.
+  uint64_t BufOffset = 0;
+
+  uint8_t *getBufferAt(uint64_t Offset) {
+    return reinterpret_cast<uint8_t *>(Buf->getBufferStart()) +
+           (Offset - BufOffset);
+  }
+  void addChunk(uint64_t Offset, uint64_t Size, ArrayRef<uint8_t> Data,
+                const SectionBase *Sec = nullptr);
+  Error addHeaderChunk(uint64_t Offset, uint64_t Size,
+                       function_ref<void()> WriteHeaders);
+  Error writeChunks();
 
   size_t totalSize() const;
 
@@ -544,6 +572,11 @@ class CompressedSection : public SectionBase {
 public:
   static Expected<CompressedSection>
   create(const SectionBase &Sec, DebugCompressionType CompressionType);
+  /// Compress \p Sections, concurrently according to parallel::strategy.
+  /// The result does not depend on the number of threads.
+  static Expected<std::vector<CompressedSection>>
+  create(ArrayRef<const SectionBase *> Sections,
+         DebugCompressionType CompressionType);
   static Expected<CompressedSection> create(ArrayRef<uint8_t> CompressedData,
                                             uint64_t DecompressedSize,
                                             uint64_t DecompressedAlign);
@@ -561,7 +594,8 @@ public:
 
 private:
   CompressedSection(const SectionBase &Sec,
-                    DebugCompressionType CompressionType, Error &Err);
+                    DebugCompressionType CompressionType);
+  Error compress();
   CompressedSection(ArrayRef<uint8_t> CompressedData, uint64_t DecompressedSize,
                     uint64_t DecompressedAlign);
 };
@@ -945,7 +945,7 @@ StringRef Archive::Symbol::getName() const {
   return Parent->getSymbolTable().begin() + StringIndex;
 }
 
-Expected<Archive::Child> Archive::Symbol::getMember() const {
+Expected<uint64_t> Archive::Symbol::getMemberOffset() const {
   const char *Buf = Parent->getSymbolTable().begin();
   const char *Offsets = Buf;
   if (Parent->kind() == K_GNU64 || Parent->kind() == K_DARWIN64)
@@ -996,13 +996,14 @@ Expected<Archive::Child> Archive::Symbol::getMember() const {
 
     Offset = read32le(Offsets + OffsetIndex * 4);
   }
+  return Offset;
+}
 
-  const char *Loc = Parent->getData().begin() + Offset;
-  Error Err = Error::success();
-  Child C(Parent, Loc, &Err);
-  if (Err)
-    return std::move(Err);
-  return C;
+Expected<Archive::Child> Archive::Symbol::getMember() const {
+  Expected<uint64_t> OffsetOrErr = getMemberOffset();
+  if (!OffsetOrErr)
+    return OffsetOrErr.takeError();
+  return Parent->getChildAt(*OffsetOrErr);
 }
 
 Archive::Symbol Archive::Symbol::getNext() const {
@@ -1122,7 +1123,87 @@ uint32_t Archive::getNumberOfSymbols() const {
   return read32le(buf);
 }
 
+Expected<Archive::Child> Archive::getChildAt(uint64_t Offset) const {
+  const char *Loc = getData().begin() + Offset;
+  Error Err = Error::success();
+  Child C(this, Loc, &Err);
+  if (Err)
+    return std::move(Err);
+  return std::move(C);
+}
+
+// The indexes keep the first entry for each name, which is what a linear scan
+// finds.
+Error Archive::buildSymbolIndex() {
+  if (HasSymbolIndex)
+    return Error::success();
+
+  StringMap<uint64_t> Symbols;
+  for (const Symbol &Sym : symbols()) {
+    Expected<uint64_t> OffsetOrErr = Sym.getMemberOffset();
+    if (!OffsetOrErr)
+      return OffsetOrErr.takeError();
+    Symbols.try_emplace(Sym.getName(), *OffsetOrErr);
+  }
+  SymbolIndex = std::move(Symbols);
+  HasSymbolIndex = true;
+  return Error::success();
+}
+
+Error Archive::buildMemberIndex() {
+  if (HasMemberIndex)
+    return Error::success();
+
+  StringMap<uint64_t> Members;
+  Error Err = Error::success();
+  for (const Child &C : children(Err)) {
+    Expected<StringRef> NameOrErr = C.getName();
+    if (!NameOrErr)
+      return NameOrErr.takeError();
+    Members.try_emplace(*NameOrErr, C.getChildOffset());
+  }
+  if (Err)
+    return Err;
+  MemberIndex = std::move(Members);
+  HasMemberIndex = true;
+  return Error::success();
+}
+
+Expected<Optional<Archive::Child>> Archive::findMember(StringRef Name) const {
+  if (HasMemberIndex) {
+    auto It = MemberIndex.find(Name);
+    if (It == MemberIndex.end())
+      return Optional<Child>();
+    Expected<Child> ChildOrErr = getChildAt(It->second);
+    if (!ChildOrErr)
+      return ChildOrErr.takeError();
+    return Optional<Child>(std::move(*ChildOrErr));
+  }
+
+  Error Err = Error::success();
+  for (const Child &C : children(Err)) {
+    Expected<StringRef> NameOrErr = C.getName();
+    if (!NameOrErr)
+      return NameOrErr.takeError();
+    if (*NameOrErr == Name)
+      return Optional<Child>(C);
+  }
+  if (Err)
+    return std::move(Err);
+  return Optional<Child>();
+}
+
 Expected<Optional<Archive::Child>> Archive::findSym(StringRef name) const {
+  if (HasSymbolIndex) {
+    auto It = SymbolIndex.find(name);
+    if (It == SymbolIndex.end())
+      return Optional<Child>();
+    Expected<Child> ChildOrErr = getChildAt(It->second);
+    if (!ChildOrErr)
+      return ChildOrErr.takeError();
+    return Optional<Child>(std::move(*ChildOrErr));
+  }
+
   Archive::symbol_iterator bs = symbol_begin();
   Archive::symbol_iterator es = symbol_end();
 
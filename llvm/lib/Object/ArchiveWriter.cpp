@@ -12,6 +12,9 @@
 
 #include "llvm/Object/ArchiveWriter.h"
 #include "llvm/ADT/ArrayRef.h"
+#include "llvm/ADT/Optional.h"
+#include "llvm/ADT/ScopeExit.h"
+#include "llvm/ADT/SmallString.h"
 #include "llvm/ADT/StringMap.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/BinaryFormat/Magic.h"
@@ -25,6 +28,7 @@
 #include "llvm/Support/Errc.h"
 #include "llvm/Support/ErrorHandling.h"
 #include "llvm/Support/Format.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
 #include "llvm/Support/raw_ostream.h"
@@ -403,6 +407,15 @@ getSymbols(MemoryBufferRef Buf, raw_ostream &SymNames, bool &HasObject) {
   return Ret;
 }
 
+namespace {
+// The archive symbols of one member, with names in a buffer of their own.
+struct MemberSymbols {
+  std::vector<unsigned> Offsets;
+  SmallString<0> Names;
+  bool HasObject = false;
+};
+} // namespace
+
 static Expected<std::vector<MemberData>>
 computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
                   object::Archive::Kind Kind, bool Thin, bool Deterministic,
@@ -471,7 +484,29 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
       Entry.second = Entry.second > 1 ? 1 : 0;
   }
 
-  for (const NewArchiveMember &M : NewMembers) {
+  // Reading the symbol tables of the members dominates the time spent here.
+  // As each member is read independently, this is done according to
+  // parallel::strategy, and the results are merged in member order below.
+  std::vector<MemberSymbols> MemberSyms(NeedSymbols ? NewMembers.size() : 0);
+  std::vector<Optional<Error>> SymbolErrors(MemberSyms.size());
+  auto ConsumeSymbolErrors = make_scope_exit([&] {
+    for (Optional<Error> &E : SymbolErrors)
+      if (E)
+        consumeError(std::move(*E));
+  });
+  parallelForEachN(0, MemberSyms.size(), [&](size_t I) {
+    MemberSymbols &Syms = MemberSyms[I];
+    raw_svector_ostream Names(Syms.Names);
+    Expected<std::vector<unsigned>> OffsetsOrErr = getSymbols(
+        NewMembers[I].Buf->getMemBufferRef(), Names, Syms.HasObject);
+    if (OffsetsOrErr)
+      Syms.Offsets = std::move(*OffsetsOrErr);
+    else
+      SymbolErrors[I] = OffsetsOrErr.takeError();
+  });
+
+  for (size_t I = 0, E = NewMembers.size(); I != E; ++I) {
+    const NewArchiveMember &M = NewMembers[I];
     std::string Header;
     raw_string_ostream Out(Header);
 
@@ -509,11 +544,16 @@ computeMemberData(raw_ostream &StringTable, raw_ostream &SymNames,
 
     std::vector<unsigned> Symbols;
     if (NeedSymbols) {
-      Expected<std::vector<unsigned>> SymbolsOrErr =
-          getSymbols(Buf, SymNames, HasObject);
-      if (auto E = SymbolsOrErr.takeError())
-        return std::move(E);
-      Symbols = std::move(*SymbolsOrErr);
+      if (SymbolErrors[I])
+        return std::move(*SymbolErrors[I]);
+      MemberSymbols &Syms = MemberSyms[I];
+      unsigned Base = SymNames.tell();
+      for (unsigned &Offset : Syms.Offsets)
+        Offset += Base;
+      SymNames << Syms.Names;
+      HasObject |= Syms.HasObject;
+      Symbols = std::move(Syms.Offsets);
+      Syms.Names = SmallString<0>();
     }
 
     Pos += Header.size() + Data.size() + Padding.size();
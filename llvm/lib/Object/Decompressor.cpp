@@ -19,19 +19,21 @@ using namespace object;
 
 Expected<Decompressor> Decompressor::create(StringRef Name, StringRef Data,
                                             bool IsLE, bool Is64Bit) {
-  if (!zlib::isAvailable())
-    return createError("zlib is not available");
-
   Decompressor D(Data);
   Error Err = isGnuStyle(Name) ? D.consumeCompressedGnuHeader()
-                               : D.consumeCompressedZLibHeader(Is64Bit, IsLE);
+                               : D.consumeCompressedELFHeader(Is64Bit, IsLE);
   if (Err)
     return std::move(Err);
+  if (D.CompressionType == ELF::ELFCOMPRESS_ZLIB && !zlib::isAvailable())
+    return createError("zlib is not available");
+  if (D.CompressionType == ELF::ELFCOMPRESS_ZSTD && !zstd::isAvailable())
+    return createError("zstd is not available");
   return D;
 }
 
 Decompressor::Decompressor(StringRef Data)
-    : SectionData(Data), DecompressedSize(0) {}
+    : SectionData(Data), DecompressedSize(0),
+      CompressionType(ELF::ELFCOMPRESS_ZLIB) {}
 
 Error Decompressor::consumeCompressedGnuHeader() {
   if (!SectionData.startswith("ZLIB"))
@@ -48,8 +50,8 @@ Error Decompressor::consumeCompressedGnuHeader() {
   return Error::success();
 }
 
-Error Decompressor::consumeCompressedZLibHeader(bool Is64Bit,
-                                                bool IsLittleEndian) {
+Error Decompressor::consumeCompressedELFHeader(bool Is64Bit,
+                                               bool IsLittleEndian) {
   using namespace ELF;
   uint64_t HdrSize = Is64Bit ? sizeof(Elf64_Chdr) : sizeof(Elf32_Chdr);
   if (SectionData.size() < HdrSize)
@@ -57,9 +59,10 @@ Error Decompressor::consumeCompressedZLibHeader(bool Is64Bit,
 
   DataExtractor Extractor(SectionData, IsLittleEndian, 0);
   uint64_t Offset = 0;
-  if (Extractor.getUnsigned(&Offset, Is64Bit ? sizeof(Elf64_Word)
-                                             : sizeof(Elf32_Word)) !=
-      ELFCOMPRESS_ZLIB)
+  CompressionType = Extractor.getUnsigned(
+      &Offset, Is64Bit ? sizeof(Elf64_Word) : sizeof(Elf32_Word));
+  if (CompressionType != ELFCOMPRESS_ZLIB &&
+      CompressionType != ELFCOMPRESS_ZSTD)
     return createError("unsupported compression type");
 
   // Skip Elf64_Chdr::ch_reserved field.
@@ -94,5 +97,7 @@ bool Decompressor::isCompressedELFSection(uint64_t Flags, StringRef Name) {
 
 Error Decompressor::decompress(MutableArrayRef<char> Buffer) {
   size_t Size = Buffer.size();
+  if (CompressionType == ELF::ELFCOMPRESS_ZSTD)
+    return zstd::uncompress(SectionData, Buffer.data(), Size);
   return zlib::uncompress(SectionData, Buffer.data(), Size);
 }
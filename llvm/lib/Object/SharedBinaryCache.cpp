@@ -0,0 +1,120 @@
+//===- SharedBinaryCache.cpp - Process-wide cache of binaries -------------===//
+//
+// Part of the LLVM Project, under the Apache License v2.0 with LLVM Exceptions.
+// See https://llvm.org/LICENSE.txt for license information.
+// SPDX-License-Identifier: Apache-2.0 WITH LLVM-exception
+//
+//===----------------------------------------------------------------------===//
+
+#include "llvm/Object/SharedBinaryCache.h"
+#include "llvm/Object/BuildID.h"
+#include "llvm/Object/ObjectFile.h"
+#include "llvm/Support/FileSystem.h"
+
+using namespace llvm;
+using namespace llvm::object;
+
+static StringRef getBuildIDKey(ArrayRef<uint8_t> BuildID) {
+  return StringRef(reinterpret_cast<const char *>(BuildID.data()),
+                   BuildID.size());
+}
+
+static bool hasDebugInfo(const ObjectFile &Obj) {
+  for (const SectionRef &Sec : Obj.sections()) {
+    Expected<StringRef> NameOrErr = Sec.getName();
+    if (!NameOrErr) {
+      consumeError(NameOrErr.takeError());
+      continue;
+    }
+    StringRef Name = NameOrErr->ltrim("._");
+    if (Name == "debug_info" || Name == "zdebug_info")
+      return true;
+  }
+  return false;
+}
+
+SharedBinaryCache &SharedBinaryCache::get() {
+  static SharedBinaryCache Cache;
+  return Cache;
+}
+
+Expected<SharedBinaryCache::SharedBinary>
+SharedBinaryCache::getOrOpen(StringRef Path) {
+  // Standard input and files whose status is unknown are not cached;
+  // createBinary reports any problem opening them.
+  sys::fs::file_status Status;
+  if (Path == "-" || sys::fs::status(Path, Status)) {
+    Expected<OwningBinary<Binary>> BinOrErr = createBinary(Path);
+    if (!BinOrErr)
+      return BinOrErr.takeError();
+    return std::make_shared<OwningBinary<Binary>>(std::move(*BinOrErr));
+  }
+
+  {
+    std::lock_guard<std::mutex> Lock(Mutex);
+    auto It = ByPath.find(Path);
+    if (It != ByPath.end() && It->second.isCurrent(Status))
+      if (SharedBinary Bin = It->second.Bin.lock())
+        return Bin;
+  }
+
+  // Open the file without holding the lock, so that requests for binaries
+  // that are already open don't wait for it. If another thread opens the same
+  // file in the meantime, its binary is kept and this one is dropped.
+  Expected<OwningBinary<Binary>> BinOrErr = createBinary(Path);
+  if (!BinOrErr)
+    return BinOrErr.takeError();
+  auto Bin = std::make_shared<OwningBinary<Binary>>(std::move(*BinOrErr));
+  Optional<ArrayRef<uint8_t>> BuildID;
+  bool HasDebugInfo = false;
+  if (auto *Obj = dyn_cast<ObjectFile>(Bin->getBinary())) {
+    BuildID = getBuildID(Obj);
+    HasDebugInfo = hasDebugInfo(*Obj);
+  }
+
+  std::lock_guard<std::mutex> Lock(Mutex);
+  Entry &E = ByPath[Path];
+  if (E.isCurrent(Status))
+    if (SharedBinary Other = E.Bin.lock())
+      return Other;
+  E.ModificationTime = Status.getLastModificationTime();
+  E.Size = Status.getSize();
+  E.Bin = Bin;
+  if (BuildID && !BuildID->empty()) {
+    // Several files, e.g. a stripped binary and its debug file, may share a
+    // build ID. Keep the binary that is already indexed unless it is gone or
+    // the new one has debug info and it does not.
+    BuildIDEntry &BE = ByBuildID[getBuildIDKey(*BuildID)];
+    if (BE.Bin.expired() || (HasDebugInfo && !BE.HasDebugInfo)) {
+      BE.Bin = Bin;
+      BE.HasDebugInfo = HasDebugInfo;
+    }
+  }
+
+  if (ByPath.size() >= NextCleanup)
+    removeExpiredEntries();
+  return Bin;
+}
+
+SharedBinaryCache::SharedBinary
+SharedBinaryCache::lookupBuildID(ArrayRef<uint8_t> BuildID) {
+  std::lock_guard<std::mutex> Lock(Mutex);
+  auto It = ByBuildID.find(getBuildIDKey(BuildID));
+  if (It == ByBuildID.end())
+    return nullptr;
+  return It->second.Bin.lock();
+}
+
+void SharedBinaryCache::removeExpiredEntries() {
+  for (auto It = ByPath.begin(); It != ByPath.end();) {
+    auto Cur = It++;
+    if (Cur->second.Bin.expired())
+      ByPath.erase(Cur);
+  }
+  for (auto It = ByBuildID.begin(); It != ByBuildID.end();) {
+    auto Cur = It++;
+    if (Cur->second.Bin.expired())
+      ByBuildID.erase(Cur);
+  }
+  NextCleanup = std::max<size_t>(64, 2 * ByPath.size());
+}
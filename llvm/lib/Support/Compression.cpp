@@ -11,22 +11,31 @@
 //===----------------------------------------------------------------------===//
 
 #include "llvm/Support/Compression.h"
+#include "llvm/ADT/Optional.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
 #include "llvm/Config/config.h"
 #include "llvm/Support/Compiler.h"
 #include "llvm/Support/Error.h"
 #include "llvm/Support/ErrorHandling.h"
+#include "llvm/Support/MathExtras.h"
+#include "llvm/Support/Parallel.h"
 #if LLVM_ENABLE_ZLIB
 #include <zlib.h>
 #endif
+#if LLVM_ENABLE_ZSTD
+#include <zstd.h>
+#endif
 
 using namespace llvm;
 
-#if LLVM_ENABLE_ZLIB
+#if LLVM_ENABLE_ZLIB || LLVM_ENABLE_ZSTD
 static Error createError(StringRef Err) {
   return make_error<StringError>(Err, inconvertibleErrorCode());
 }
+#endif
+
+#if LLVM_ENABLE_ZLIB
 
 static StringRef convertZlibCodeToString(int Code) {
   switch (Code) {
@@ -60,6 +69,87 @@ Error zlib::compress(StringRef InputBuffer,
   return Res ? createError(convertZlibCodeToString(Res)) : Error::success();
 }
 
+// Deflate one shard of the input into a raw deflate stream. \p Flush is
+// Z_SYNC_FLUSH for all shards but the last, so that their output ends on a
+// byte boundary and they can be concatenated.
+static int deflateShard(StringRef InputBuffer, SmallVectorImpl<char> &Shard,
+                        int Level, int Flush) {
+  z_stream Stream = {};
+  int Res = ::deflateInit2(&Stream, Level, Z_DEFLATED, /*windowBits=*/-15,
+                           /*memLevel=*/8, Z_DEFAULT_STRATEGY);
+  if (Res != Z_OK)
+    return Res;
+  Stream.next_in = (Bytef *)InputBuffer.data();
+  Stream.avail_in = InputBuffer.size();
+  // Start with half of the input size and grow the buffer as needed.
+  size_t Pos = 0;
+  Shard.resize_for_overwrite(std::max<size_t>(InputBuffer.size() / 2, 64));
+  do {
+    if (Pos == Shard.size())
+      Shard.resize_for_overwrite(Shard.size() * 3 / 2);
+    Stream.next_out = (Bytef *)Shard.data() + Pos;
+    Stream.avail_out = Shard.size() - Pos;
+    Res = ::deflate(&Stream, Flush);
+    Pos = (char *)Stream.next_out - Shard.data();
+  } while (Res != Z_STREAM_ERROR && Stream.avail_out == 0);
+  ::deflateEnd(&Stream);
+  __msan_unpoison(Shard.data(), Pos);
+  Shard.truncate(Pos);
+  return Res == Z_STREAM_ERROR ? Res : Z_OK;
+}
+
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  size_t NumShards = divideCeil(InputBuffer.size(), ParallelShardSize);
+  if (NumShards <= 1)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  std::vector<SmallVector<char, 0>> Shards(NumShards);
+  std::vector<uint32_t> Checksums(NumShards);
+  std::vector<int> Results(NumShards);
+  parallelForEachN(0, NumShards, [&](size_t I) {
+    StringRef Input =
+        InputBuffer.substr(I * ParallelShardSize, ParallelShardSize);
+    Results[I] = deflateShard(Input, Shards[I], Level,
+                              I + 1 == NumShards ? Z_FINISH : Z_SYNC_FLUSH);
+    Checksums[I] = ::adler32(::adler32(0, Z_NULL, 0),
+                             (const Bytef *)Input.data(), Input.size());
+  });
+  for (int Res : Results)
+    if (Res != Z_OK)
+      return createError(convertZlibCodeToString(Res));
+
+  // Wrap the concatenated shards in the same zlib header deflate() would
+  // write, and an Adler-32 checksum of the whole input combined from the
+  // checksums of the shards.
+  int HeaderLevel = Level == Z_DEFAULT_COMPRESSION ? 6 : Level;
+  unsigned LevelFlags = 3;
+  if (HeaderLevel < 2)
+    LevelFlags = 0;
+  else if (HeaderLevel < 6)
+    LevelFlags = 1;
+  else if (HeaderLevel == 6)
+    LevelFlags = 2;
+  unsigned Header = (Z_DEFLATED + ((15 - 8) << 4)) << 8 | LevelFlags << 6;
+  Header += 31 - Header % 31;
+  uint32_t Checksum = Checksums[0];
+  for (size_t I = 1; I != NumShards; ++I) {
+    size_t Size = std::min(ParallelShardSize,
+                           InputBuffer.size() - I * ParallelShardSize);
+    Checksum = ::adler32_combine(Checksum, Checksums[I], Size);
+  }
+
+  CompressedBuffer.clear();
+  CompressedBuffer.push_back(Header >> 8);
+  CompressedBuffer.push_back(Header & 0xff);
+  for (const SmallVector<char, 0> &Shard : Shards)
+    CompressedBuffer.append(Shard.begin(), Shard.end());
+  for (int Shift = 24; Shift >= 0; Shift -= 8)
+    CompressedBuffer.push_back((Checksum >> Shift) & 0xff);
+  return Error::success();
+}
+
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   int Res =
@@ -91,6 +181,11 @@ Error zlib::compress(StringRef InputBuffer,
                      SmallVectorImpl<char> &CompressedBuffer, int Level) {
   llvm_unreachable("zlib::compress is unavailable");
 }
+Error zlib::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  llvm_unreachable("zlib::compressParallel is unavailable");
+}
 Error zlib::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
                        size_t &UncompressedSize) {
   llvm_unreachable("zlib::uncompress is unavailable");
@@ -104,3 +199,98 @@ uint32_t zlib::crc32(StringRef Buffer) {
   llvm_unreachable("zlib::crc32 is unavailable");
 }
 #endif
+
+#if LLVM_ENABLE_ZSTD
+bool zstd::isAvailable() { return true; }
+
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  size_t CompressedBufferSize = ::ZSTD_compressBound(InputBuffer.size());
+  CompressedBuffer.resize_for_overwrite(CompressedBufferSize);
+  size_t CompressedSize =
+      ::ZSTD_compress(CompressedBuffer.data(), CompressedBufferSize,
+                      InputBuffer.data(), InputBuffer.size(), Level);
+  if (::ZSTD_isError(CompressedSize)) {
+    CompressedBuffer.clear();
+    return createError(::ZSTD_getErrorName(CompressedSize));
+  }
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(CompressedBuffer.data(), CompressedSize);
+  CompressedBuffer.truncate(CompressedSize);
+  return Error::success();
+}
+
+Error zstd::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  size_t NumShards = divideCeil(InputBuffer.size(), ParallelShardSize);
+  if (NumShards <= 1)
+    return compress(InputBuffer, CompressedBuffer, Level);
+
+  std::vector<SmallVector<char, 0>> Shards(NumShards);
+  std::vector<Optional<Error>> Errors(NumShards);
+  parallelForEachN(0, NumShards, [&](size_t I) {
+    Errors[I] = compress(
+        InputBuffer.substr(I * ParallelShardSize, ParallelShardSize),
+        Shards[I], Level);
+  });
+  Error Err = Error::success();
+  for (Optional<Error> &E : Errors)
+    if (Err)
+      consumeError(std::move(*E));
+    else
+      Err = std::move(*E);
+  if (Err)
+    return Err;
+
+  CompressedBuffer.clear();
+  for (const SmallVector<char, 0> &Shard : Shards)
+    CompressedBuffer.append(Shard.begin(), Shard.end());
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  size_t Res = ::ZSTD_decompress(UncompressedBuffer, UncompressedSize,
+                                 InputBuffer.data(), InputBuffer.size());
+  if (::ZSTD_isError(Res))
+    return createError(::ZSTD_getErrorName(Res));
+  UncompressedSize = Res;
+  // Tell MemorySanitizer that zstd output buffer is fully initialized.
+  // This avoids a false report when running LLVM with uninstrumented zstd.
+  __msan_unpoison(UncompressedBuffer, UncompressedSize);
+  return Error::success();
+}
+
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  UncompressedBuffer.resize_for_overwrite(UncompressedSize);
+  Error E =
+      uncompress(InputBuffer, UncompressedBuffer.data(), UncompressedSize);
+  UncompressedBuffer.truncate(UncompressedSize);
+  return E;
+}
+
+#else
+bool zstd::isAvailable() { return false; }
+Error zstd::compress(StringRef InputBuffer,
+                     SmallVectorImpl<char> &CompressedBuffer, int Level) {
+  llvm_unreachable("zstd::compress is unavailable");
+}
+Error zstd::compressParallel(StringRef InputBuffer,
+                             SmallVectorImpl<char> &CompressedBuffer,
+                             int Level) {
+  llvm_unreachable("zstd::compressParallel is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer, char *UncompressedBuffer,
+                       size_t &UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+Error zstd::uncompress(StringRef InputBuffer,
+                       SmallVectorImpl<char> &UncompressedBuffer,
+                       size_t UncompressedSize) {
+  llvm_unreachable("zstd::uncompress is unavailable");
+}
+#endif
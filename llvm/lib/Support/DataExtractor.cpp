@@ -221,6 +221,33 @@ uint64_t DataExtractor::getULEB128(uint64_t *offset_ptr, Error *Err) const {
   return getLEB128(Data, offset_ptr, Err, decodeULEB128);
 }
 
+void DataExtractor::getULEB128(uint64_t *OffsetPtr,
+                               MutableArrayRef<uint64_t> Values,
+                               Error *Err) const {
+  ArrayRef<uint8_t> Bytes = arrayRefFromStringRef(Data);
+  assert(*OffsetPtr <= Bytes.size());
+  ErrorAsOutParameter ErrAsOut(Err);
+  if (isError(Err)) {
+    std::fill(Values.begin(), Values.end(), 0);
+    return;
+  }
+
+  const char *error;
+  uint64_t BytesRead =
+      decodeULEB128Values(Bytes.data() + *OffsetPtr, Bytes.end(),
+                          Values.data(), Values.size(), &error);
+  if (error) {
+    if (Err)
+      *Err = createStringError(errc::illegal_byte_sequence,
+                               "unable to decode LEB128 at offset 0x%8.8" PRIx64
+                               ": %s",
+                               *OffsetPtr + BytesRead, error);
+    std::fill(Values.begin(), Values.end(), 0);
+    return;
+  }
+  *OffsetPtr += BytesRead;
+}
+
 int64_t DataExtractor::getSLEB128(uint64_t *offset_ptr, Error *Err) const {
   return getLEB128(Data, offset_ptr, Err, decodeSLEB128);
 }
@@ -52,6 +52,9 @@ struct LinkOptions {
   /// Number of threads.
   unsigned Threads = 1;
 
+  /// Maximum size of the input debug info analyzed ahead of cloning.
+  uint64_t MemoryBudget = 0;
+
   // Output file type.
   OutputFileType FileType = OutputFileType::Object;
 
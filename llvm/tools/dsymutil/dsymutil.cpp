@@ -330,6 +330,14 @@ static Expected<DsymutilOptions> getOptions(opt::InputArgList &Args) {
   if (Options.DumpDebugMap || Options.LinkOpts.Verbose)
     Options.LinkOpts.Threads = 1;
 
+  if (opt::Arg *MemoryBudget = Args.getLastArg(OPT_memory_budget)) {
+    if (StringRef(MemoryBudget->getValue())
+            .getAsInteger(0, Options.LinkOpts.MemoryBudget))
+      return make_error<StringError>(
+          Twine("invalid memory budget: ") + MemoryBudget->getValue(),
+          inconvertibleErrorCode());
+  }
+
   if (getenv("RC_DEBUG_OPTIONS"))
     Options.PaperTrailWarnings = true;
 
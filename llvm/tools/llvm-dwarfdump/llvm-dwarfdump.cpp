@@ -31,6 +31,7 @@
 #include "llvm/Support/ToolOutputFile.h"
 #include "llvm/Support/WithColor.h"
 #include "llvm/Support/raw_ostream.h"
+#include <atomic>
 #include <cstdlib>
 
 using namespace llvm;
@@ -164,11 +165,18 @@ static list<std::string>
     Find("find",
          desc("Search for the exact match for <name> in the accelerator tables "
               "and print the matching debug information entries. When no "
-              "accelerator tables are available, the slower but more complete "
-              "-name option can be used instead."),
+              "accelerator tables are available, an equivalent name index is "
+              "built from the debug information entries first. The slower but "
+              "more complete -name option can be used instead."),
          value_desc("name"), cat(DwarfDumpCategory));
 static alias FindAlias("f", desc("Alias for --find."), aliasopt(Find),
                        cl::NotHidden);
+static opt<bool> CacheNameIndex(
+    "cache-name-index",
+    desc("When --find builds a name index for a file without accelerator "
+         "tables, store it next to the file as <file>.dwnames and reuse it "
+         "in later runs."),
+    cat(DwarfDumpCategory));
 static opt<bool> IgnoreCase("ignore-case",
                             desc("Ignore case distinctions when using --name."),
                             value_desc("i"), cat(DwarfDumpCategory));
@@ -251,6 +259,17 @@ static opt<bool> Verify("verify", desc("Verify the DWARF debug info."),
                         cat(DwarfDumpCategory));
 static opt<bool> Quiet("quiet", desc("Use with -verify to not emit to STDOUT."),
                        cat(DwarfDumpCategory));
+static opt<unsigned>
+    NumThreads("threads",
+               desc("Format, search or verify units on N threads. Output is "
+                    "the same for any N. 0 uses all available threads."),
+               cat(DwarfDumpCategory), init(1), value_desc("N"));
+static opt<uint64_t> DIEMemoryBudget(
+    "die-memory-budget",
+    desc("Release the DIEs and line tables of the least recently dumped "
+         "units once they take more than this many bytes. Only used with "
+         "--threads=1."),
+    cat(DwarfDumpCategory), init(0), value_desc("bytes"));
 static opt<bool> DumpUUID("uuid", desc("Show the UUID for each architecture."),
                           cat(DwarfDumpCategory));
 static alias DumpUUIDAlias("u", desc("Alias for --uuid."), aliasopt(DumpUUID),
@@ -363,19 +382,24 @@ static bool filterByName(const StringSet<> &Names, DWARFDie Die,
   return false;
 }
 
-/// Print only DIEs that have a certain name.
-static void filterByName(const StringSet<> &Names,
+/// Print only DIEs that have a certain name. Units are searched in parallel
+/// with --threads and their matches are printed in unit order.
+static void filterByName(const StringSet<> &Names, DWARFContext &DICtx,
                          DWARFContext::unit_iterator_range CUs,
                          raw_ostream &OS) {
-  for (const auto &CU : CUs)
-    for (const auto &Entry : CU->dies()) {
-      DWARFDie Die = {CU.get(), &Entry};
-      if (const char *Name = Die.getName(DINameKind::ShortName))
-        if (filterByName(Names, Die, Name, OS))
-          continue;
-      if (const char *Name = Die.getName(DINameKind::LinkageName))
-        filterByName(Names, Die, Name, OS);
-    }
+  DICtx.printInOrder(
+      OS, CUs.end() - CUs.begin(), hardware_concurrency(NumThreads),
+      [&](raw_ostream &UnitOS, size_t Index) {
+        DWARFUnit *CU = CUs.begin()[Index].get();
+        for (const auto &Entry : CU->dies()) {
+          DWARFDie Die = {CU, &Entry};
+          if (const char *Name = Die.getName(DINameKind::ShortName))
+            if (filterByName(Names, Die, Name, UnitOS))
+              continue;
+          if (const char *Name = Die.getName(DINameKind::LinkageName))
+            filterByName(Names, Die, Name, UnitOS);
+        }
+      });
 }
 
 static void getDies(DWARFContext &DICtx, const AppleAcceleratorTable &Accel,
@@ -417,15 +441,53 @@ static void getDies(DWARFContext &DICtx, const DWARFDebugNames &Accel,
   }
 }
 
+static bool hasAccelTables(DWARFContext &DICtx) {
+  const DWARFObject &DObj = DICtx.getDWARFObj();
+  return !DObj.getAppleNamesSection().Data.empty() ||
+         !DObj.getAppleTypesSection().Data.empty() ||
+         !DObj.getAppleNamespacesSection().Data.empty() ||
+         !DObj.getNamesSection().Data.empty();
+}
+
+/// Load the name index of \p Filename from <Filename>.dwnames, or build it and
+/// store it there.
+static void useNameIndexCache(DWARFContext &DICtx, const Twine &Filename) {
+  std::string CachePath = (Filename + ".dwnames").str();
+  if (ErrorOr<std::unique_ptr<MemoryBuffer>> BufOrErr =
+          MemoryBuffer::getFile(CachePath, /*IsText=*/false,
+                                /*RequiresNullTerminator=*/false)) {
+    Error E = DICtx.loadDebugNamesIndex(std::move(*BufOrErr));
+    if (!E)
+      return;
+    // Rebuild a stale or damaged index.
+    WithColor::warning() << toString(std::move(E)) << '\n';
+  }
+  if (Error E = writeToOutput(CachePath, [&](raw_ostream &OS) {
+        return DICtx.writeDebugNamesIndex(OS,
+                                          hardware_concurrency(NumThreads));
+      }))
+    WithColor::warning() << CachePath << ": " << toString(std::move(E))
+                         << '\n';
+}
+
 /// Print only DIEs that have a certain name.
 static void filterByAccelName(ArrayRef<std::string> Names, DWARFContext &DICtx,
-                              raw_ostream &OS) {
+                              const Twine &Filename, raw_ostream &OS) {
   SmallVector<DWARFDie, 4> Dies;
-  for (const auto &Name : Names) {
-    getDies(DICtx, DICtx.getAppleNames(), Name, Dies);
-    getDies(DICtx, DICtx.getAppleTypes(), Name, Dies);
-    getDies(DICtx, DICtx.getAppleNamespaces(), Name, Dies);
-    getDies(DICtx, DICtx.getDebugNames(), Name, Dies);
+  if (hasAccelTables(DICtx)) {
+    for (const auto &Name : Names) {
+      getDies(DICtx, DICtx.getAppleNames(), Name, Dies);
+      getDies(DICtx, DICtx.getAppleTypes(), Name, Dies);
+      getDies(DICtx, DICtx.getAppleNamespaces(), Name, Dies);
+      getDies(DICtx, DICtx.getDebugNames(), Name, Dies);
+    }
+  } else {
+    if (CacheNameIndex)
+      useNameIndexCache(DICtx, Filename);
+    const DWARFDebugNames &Index =
+        DICtx.getOrBuildDebugNames(hardware_concurrency(NumThreads));
+    for (const auto &Name : Names)
+      getDies(DICtx, Index, Name, Dies);
   }
   llvm::sort(Dies);
   Dies.erase(std::unique(Dies.begin(), Dies.end()), Dies.end());
@@ -484,19 +546,20 @@ static bool dumpObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
     for (auto name : Name)
       Names.insert((IgnoreCase && !UseRegex) ? StringRef(name).lower() : name);
 
-    filterByName(Names, DICtx.normal_units(), OS);
-    filterByName(Names, DICtx.dwo_units(), OS);
+    filterByName(Names, DICtx, DICtx.normal_units(), OS);
+    filterByName(Names, DICtx, DICtx.dwo_units(), OS);
     return true;
   }
 
   // Handle the --find option and lower it to --debug-info=<offset>.
   if (!Find.empty()) {
-    filterByAccelName(Find, DICtx, OS);
+    filterByAccelName(Find, DICtx, Filename, OS);
     return true;
   }
 
   // Dump the complete DWARF structure.
-  DICtx.dump(OS, getDumpOpts(DICtx), DumpOffsets);
+  DICtx.dump(OS, getDumpOpts(DICtx), DumpOffsets,
+             hardware_concurrency(NumThreads));
   return true;
 }
 
@@ -507,7 +570,8 @@ static bool verifyObjectFile(ObjectFile &Obj, DWARFContext &DICtx,
   raw_ostream &stream = Quiet ? nulls() : OS;
   stream << "Verifying " << Filename.str() << ":\tfile format "
          << Obj.getFileFormatName() << "\n";
-  bool Result = DICtx.verify(stream, getDumpOpts(DICtx));
+  bool Result = DICtx.verify(stream, getDumpOpts(DICtx),
+                             hardware_concurrency(NumThreads));
   if (Result)
     stream << "No errors.\n";
   else
@@ -541,15 +605,23 @@ static bool handleBuffer(StringRef Filename, MemoryBufferRef Buffer,
   error(Filename, BinOrErr.takeError());
 
   bool Result = true;
+  // The handler may be called from several threads with --threads.
+  std::atomic<bool> HadRecoverableError(false);
   auto RecoverableErrorHandler = [&](Error E) {
-    Result = false;
+    HadRecoverableError = true;
     WithColor::defaultErrorHandler(std::move(E));
   };
+  auto CreateContext = [&](const ObjectFile &Obj) {
+    std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(
+        Obj, DWARFContext::ProcessDebugRelocations::Process, nullptr, "",
+        RecoverableErrorHandler, WithColor::defaultWarningHandler,
+        /*ThreadSafe=*/NumThreads != 1);
+    DICtx->setDIEMemoryBudget(DIEMemoryBudget);
+    return DICtx;
+  };
   if (auto *Obj = dyn_cast<ObjectFile>(BinOrErr->get())) {
     if (filterArch(*Obj)) {
-      std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(
-          *Obj, DWARFContext::ProcessDebugRelocations::Process, nullptr, "",
-          RecoverableErrorHandler);
+      std::unique_ptr<DWARFContext> DICtx = CreateContext(*Obj);
       if (!HandleObj(*Obj, *DICtx, Filename, OS))
         Result = false;
     }
@@ -560,9 +632,7 @@ static bool handleBuffer(StringRef Filename, MemoryBufferRef Buffer,
       if (auto MachOOrErr = ObjForArch.getAsObjectFile()) {
         auto &Obj = **MachOOrErr;
         if (filterArch(Obj)) {
-          std::unique_ptr<DWARFContext> DICtx = DWARFContext::create(
-              Obj, DWARFContext::ProcessDebugRelocations::Process, nullptr, "",
-              RecoverableErrorHandler);
+          std::unique_ptr<DWARFContext> DICtx = CreateContext(Obj);
           if (!HandleObj(Obj, *DICtx, ObjName, OS))
             Result = false;
         }
@@ -579,7 +649,7 @@ static bool handleBuffer(StringRef Filename, MemoryBufferRef Buffer,
     }
   else if (auto *Arch = dyn_cast<Archive>(BinOrErr->get()))
     Result = handleArchive(Filename, *Arch, HandleObj, OS);
-  return Result;
+  return Result && !HadRecoverableError;
 }
 
 static bool handleFile(StringRef Filename, HandlerFn HandleObj,
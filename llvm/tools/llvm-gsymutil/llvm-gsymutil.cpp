@@ -410,8 +410,9 @@ static llvm::Error convertFileToGSYM(raw_ostream &OS) {
   return Error::success();
 }
 
-static void doLookup(GsymReader &Gsym, uint64_t Addr, raw_ostream &OS) {
-  if (auto Result = Gsym.lookup(Addr)) {
+static void doLookup(GsymReader &Gsym, uint64_t Addr,
+                     Expected<LookupResult> Result, raw_ostream &OS) {
+  if (Result) {
     // If verbose is enabled dump the full function info for the address.
     if (Verbose) {
       if (auto FI = Gsym.getFunctionInfo(Addr)) {
@@ -505,7 +506,7 @@ int main(int argc, char const *argv[]) {
         return 1;
       }
 
-      doLookup(**CurrentGsym, Addr, OS);
+      doLookup(**CurrentGsym, Addr, (*CurrentGsym)->lookup(Addr), OS);
 
       OS << "\n";
       OS.flush();
@@ -527,9 +528,11 @@ int main(int argc, char const *argv[]) {
 
     // Lookup an address in a GSYM file and print any matches.
     OS << "Looking up addresses in \"" << GSYMPath << "\":\n";
-    for (auto Addr : LookupAddresses) {
-      doLookup(*Gsym, Addr, OS);
-    }
+    std::vector<uint64_t> Addrs(LookupAddresses.begin(),
+                                LookupAddresses.end());
+    std::vector<Expected<LookupResult>> Results = Gsym->lookupAddresses(Addrs);
+    for (size_t I = 0, E = Addrs.size(); I != E; ++I)
+      doLookup(*Gsym, Addrs[I], std::move(Results[I]), OS);
   }
   return EXIT_SUCCESS;
 }
@@ -434,6 +434,16 @@ template <class T> static ErrorOr<T> getAsInteger(StringRef Val) {
   return Result;
 }
 
+static Expected<unsigned> parseThreads(StringRef Value) {
+  unsigned Threads;
+  if (Value.getAsInteger(10, Threads) || Threads == 0)
+    return createStringError(errc::invalid_argument,
+                             "--threads: expected a positive integer, but "
+                             "got '%s'",
+                             Value.str().c_str());
+  return Threads;
+}
+
 namespace {
 
 enum class ToolType { Objcopy, Strip, InstallNameTool, BitcodeStrip };
@@ -738,6 +748,7 @@ objcopy::parseObjcopyOptions(ArrayRef<const char *> RawArgsArr,
               InputArgs.getLastArgValue(OBJCOPY_compress_debug_sections_eq))
               .Case("zlib-gnu", DebugCompressionType::GNU)
               .Case("zlib", DebugCompressionType::Z)
+              .Case("zstd", DebugCompressionType::Zstd)
               .Default(DebugCompressionType::None);
       if (Config.CompressionType == DebugCompressionType::None)
         return createStringError(
@@ -747,10 +758,16 @@ objcopy::parseObjcopyOptions(ArrayRef<const char *> RawArgsArr,
                 .str()
                 .c_str());
     }
-    if (!zlib::isAvailable())
+    if (Config.CompressionType == DebugCompressionType::Zstd) {
+      if (!zstd::isAvailable())
+        return createStringError(
+            errc::invalid_argument,
+            "LLVM was not compiled with LLVM_ENABLE_ZSTD: can not compress");
+    } else if (!zlib::isAvailable()) {
       return createStringError(
           errc::invalid_argument,
           "LLVM was not compiled with LLVM_ENABLE_ZLIB: can not compress");
+    }
   }
 
   Config.AddGnuDebugLink = InputArgs.getLastArgValue(OBJCOPY_add_gnu_debuglink);
@@ -983,6 +1000,13 @@ objcopy::parseObjcopyOptions(ArrayRef<const char *> RawArgsArr,
 
   Config.PreserveDates = InputArgs.hasArg(OBJCOPY_preserve_dates);
 
+  if (const auto *A = InputArgs.getLastArg(OBJCOPY_threads)) {
+    Expected<unsigned> Threads = parseThreads(A->getValue());
+    if (!Threads)
+      return Threads.takeError();
+    DC.NumThreads = *Threads;
+  }
+
   if (Config.PreserveDates &&
       (Config.OutputFilename == "-" || Config.InputFilename == "-"))
     return createStringError(errc::invalid_argument,
@@ -1017,10 +1041,13 @@ objcopy::parseObjcopyOptions(ArrayRef<const char *> RawArgsArr,
         "--decompress-debug-sections");
   }
 
-  if (Config.DecompressDebugSections && !zlib::isAvailable())
-    return createStringError(
-        errc::invalid_argument,
-        "LLVM was not compiled with LLVM_ENABLE_ZLIB: cannot decompress");
+  // Whether the library needed for a particular section is available is
+  // checked when the section is decompressed.
+  if (Config.DecompressDebugSections && !zlib::isAvailable() &&
+      !zstd::isAvailable())
+    return createStringError(errc::invalid_argument,
+                             "LLVM was not compiled with LLVM_ENABLE_ZLIB or "
+                             "LLVM_ENABLE_ZSTD: cannot decompress");
 
   if (Config.ExtractPartition && Config.ExtractMainPartition)
     return createStringError(errc::invalid_argument,
@@ -1334,6 +1361,12 @@ objcopy::parseStripOptions(ArrayRef<const char *> RawArgsArr,
   Config.OutputFormat = FileFormat::Unspecified;
 
   DriverConfig DC;
+  if (const auto *A = InputArgs.getLastArg(STRIP_threads)) {
+    Expected<unsigned> Threads = parseThreads(A->getValue());
+    if (!Threads)
+      return Threads.takeError();
+    DC.NumThreads = *Threads;
+  }
   if (Positional.size() == 1) {
     Config.InputFilename = Positional[0];
     Config.OutputFilename =
@@ -21,6 +21,8 @@ namespace objcopy {
 // will contain one or more CopyConfigs.
 struct DriverConfig {
   SmallVector<ConfigManager, 1> CopyConfigs;
+  // The number of threads to process input files and archive members with.
+  unsigned NumThreads = 1;
   BumpPtrAllocator Alloc;
 };
 
@@ -10,6 +10,7 @@
 #include "llvm/ADT/STLExtras.h"
 #include "llvm/ADT/SmallVector.h"
 #include "llvm/ADT/StringRef.h"
+#include "llvm/ADT/StringSet.h"
 #include "llvm/ADT/Twine.h"
 #include "llvm/BinaryFormat/ELF.h"
 #include "llvm/ObjCopy/COFF/COFFConfig.h"
@@ -44,6 +45,7 @@
 #include "llvm/Support/Host.h"
 #include "llvm/Support/InitLLVM.h"
 #include "llvm/Support/Memory.h"
+#include "llvm/Support/Parallel.h"
 #include "llvm/Support/Path.h"
 #include "llvm/Support/Process.h"
 #include "llvm/Support/SmallVectorMemoryBuffer.h"
@@ -271,6 +273,20 @@ static Error executeObjcopy(ConfigManager &ConfigMgr) {
   return Error::success();
 }
 
+/// Returns true if no two of \p Configs write to the same file, so that they
+/// can be executed concurrently.
+static bool haveDistinctOutputs(ArrayRef<ConfigManager> Configs) {
+  StringSet<> Outputs;
+  for (const ConfigManager &ConfigMgr : Configs) {
+    const CommonConfig &Config = ConfigMgr.getCommonConfig();
+    if (!Outputs.insert(Config.OutputFilename).second)
+      return false;
+    if (!Config.SplitDWO.empty() && !Outputs.insert(Config.SplitDWO).second)
+      return false;
+  }
+  return true;
+}
+
 int main(int argc, char **argv) {
   InitLLVM X(argc, argv);
   ToolName = argv[0];
@@ -296,12 +312,39 @@ int main(int argc, char **argv) {
                           WithColor::error(errs(), ToolName));
     return 1;
   }
-  for (ConfigManager &ConfigMgr : DriverConfig->CopyConfigs) {
-    if (Error E = executeObjcopy(ConfigMgr)) {
-      logAllUnhandledErrors(std::move(E), WithColor::error(errs(), ToolName));
-      return 1;
+
+  // Archive members are processed according to the parallel strategy, so
+  // set it up even if there is a single input.
+  parallel::strategy = hardware_concurrency(DriverConfig->NumThreads);
+  MutableArrayRef<ConfigManager> Configs = DriverConfig->CopyConfigs;
+  if (DriverConfig->NumThreads == 1 || Configs.size() == 1 ||
+      !haveDistinctOutputs(Configs)) {
+    for (ConfigManager &ConfigMgr : Configs) {
+      if (Error E = executeObjcopy(ConfigMgr)) {
+        logAllUnhandledErrors(std::move(E),
+                              WithColor::error(errs(), ToolName));
+        return 1;
+      }
     }
+    return 0;
   }
 
-  return 0;
+  // Inputs are independent of each other. Unlike the serial mode, all of
+  // them are processed even if one fails; the error of the first failing
+  // input in command line order is reported.
+  std::vector<Optional<Error>> Errors(Configs.size());
+  parallelForEachN(0, Configs.size(),
+                   [&](size_t I) { Errors[I] = executeObjcopy(Configs[I]); });
+  int RetCode = 0;
+  for (Optional<Error> &E : Errors) {
+    if (RetCode) {
+      consumeError(std::move(*E));
+      continue;
+    }
+    if (*E) {
+      logAllUnhandledErrors(std::move(*E), WithColor::error(errs(), ToolName));
+      RetCode = 1;
+    }
+  }
+  return RetCode;
 }
@@ -57,6 +57,7 @@
 #include "llvm/Object/MachO.h"
 #include "llvm/Object/MachOUniversal.h"
 #include "llvm/Object/ObjectFile.h"
+#include "llvm/Object/SharedBinaryCache.h"
 #include "llvm/Object/Wasm.h"
 #include "llvm/Option/Arg.h"
 #include "llvm/Option/ArgList.h"
@@ -2480,9 +2481,11 @@ static void dumpInput(StringRef file) {
     return;
   }
 
-  // Attempt to open the binary.
-  OwningBinary<Binary> OBinary = unwrapOrError(createBinary(file), file);
-  Binary &Binary = *OBinary.getBinary();
+  // Attempt to open the binary. It is shared with the symbolizer used for
+  // source interleaving, which may look up the same file.
+  SharedBinaryCache::SharedBinary OBinary =
+      unwrapOrError(SharedBinaryCache::get().getOrOpen(file), file);
+  Binary &Binary = *OBinary->getBinary();
 
   if (Archive *A = dyn_cast<Archive>(&Binary))
     dumpArchive(A);
@@ -245,6 +245,55 @@ void executeCommand(StringRef ModuleName, const T &ModuleSpec, Command Cmd,
   Symbolizer.pruneCache();
 }
 
+// Returns the I-th result of a batch query. An error loading the module is
+// only reported for the first address, like for individual queries.
+template <typename T>
+static Expected<T> takeBatchResult(Expected<std::vector<T>> &ResOrErr,
+                                   size_t I) {
+  if (ResOrErr)
+    return std::move((*ResOrErr)[I]);
+  if (I == 0)
+    return ResOrErr.takeError();
+  return T();
+}
+
+template <typename T>
+void executeCodeBatch(StringRef ModuleName, const T &ModuleSpec,
+                      ArrayRef<uint64_t> Offsets, uint64_t AdjustVMA,
+                      bool ShouldInline, OutputStyle Style,
+                      LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
+  std::vector<object::SectionedAddress> Addresses;
+  for (uint64_t Offset : Offsets)
+    Addresses.push_back(
+        {Offset - AdjustVMA, object::SectionedAddress::UndefSection});
+  if (ShouldInline || Style == OutputStyle::GNU) {
+    // See executeCommand() for why the GNU style uses the inlined frames.
+    Expected<std::vector<DIInliningInfo>> ResOrErr =
+        Symbolizer.symbolizeInlinedCodeBatch(ModuleSpec, Addresses);
+    for (size_t I = 0, E = Offsets.size(); I != E; ++I) {
+      Expected<DIInliningInfo> InlinedOrErr = takeBatchResult(ResOrErr, I);
+      if (ShouldInline) {
+        print({ModuleName, Offsets[I]}, InlinedOrErr, Printer);
+        continue;
+      }
+      Expected<DILineInfo> Res0OrErr =
+          !InlinedOrErr ? Expected<DILineInfo>(InlinedOrErr.takeError())
+                        : ((InlinedOrErr->getNumberOfFrames() == 0)
+                               ? DILineInfo()
+                               : InlinedOrErr->getFrame(0));
+      print({ModuleName, Offsets[I]}, Res0OrErr, Printer);
+    }
+  } else {
+    Expected<std::vector<DILineInfo>> ResOrErr =
+        Symbolizer.symbolizeCodeBatch(ModuleSpec, Addresses);
+    for (size_t I = 0, E = Offsets.size(); I != E; ++I) {
+      Expected<DILineInfo> LineInfoOrErr = takeBatchResult(ResOrErr, I);
+      print({ModuleName, Offsets[I]}, LineInfoOrErr, Printer);
+    }
+  }
+  Symbolizer.pruneCache();
+}
+
 static void symbolizeInput(const opt::InputArgList &Args,
                            ArrayRef<uint8_t> IncomingBuildID,
                            uint64_t AdjustVMA, bool IsAddr2Line,
@@ -273,6 +322,62 @@ static void symbolizeInput(const opt::InputArgList &Args,
   }
 }
 
+// Symbolize all of Inputs, resolving each run of consecutive code queries for
+// the same module with a single batch query. Results are printed in input
+// order.
+static void symbolizeBatch(const opt::InputArgList &Args,
+                           ArrayRef<uint8_t> IncomingBuildID,
+                           uint64_t AdjustVMA, bool IsAddr2Line,
+                           OutputStyle Style, ArrayRef<std::string> Inputs,
+                           LLVMSymbolizer &Symbolizer, DIPrinter &Printer) {
+  struct ParsedInput {
+    bool IsCode = false;
+    std::string ModuleName;
+    SmallVector<uint8_t> BuildID;
+    uint64_t Offset = 0;
+  };
+  std::vector<ParsedInput> Parsed(Inputs.size());
+  for (size_t I = 0, E = Inputs.size(); I != E; ++I) {
+    ParsedInput &P = Parsed[I];
+    Command Cmd;
+    P.BuildID.assign(IncomingBuildID.begin(), IncomingBuildID.end());
+    P.IsCode = parseCommand(Args.getLastArgValue(OPT_obj_EQ), IsAddr2Line,
+                            Inputs[I], Cmd, P.ModuleName, P.BuildID,
+                            P.Offset) &&
+               Cmd == Command::Code;
+  }
+
+  bool ShouldInline = Args.hasFlag(OPT_inlines, OPT_no_inlines, !IsAddr2Line);
+  for (size_t I = 0, E = Inputs.size(); I != E;) {
+    const ParsedInput &First = Parsed[I];
+    if (!First.IsCode) {
+      symbolizeInput(Args, IncomingBuildID, AdjustVMA, IsAddr2Line, Style,
+                     Inputs[I], Symbolizer, Printer);
+      ++I;
+      continue;
+    }
+    SmallVector<uint64_t> Offsets;
+    size_t J = I;
+    for (; J != E && Parsed[J].IsCode &&
+           Parsed[J].ModuleName == First.ModuleName &&
+           Parsed[J].BuildID == First.BuildID;
+         ++J)
+      Offsets.push_back(Parsed[J].Offset);
+
+    if (!First.BuildID.empty()) {
+      if (!Args.hasArg(OPT_no_debuginfod))
+        enableDebuginfod(Symbolizer);
+      std::string BuildIDStr = toHex(First.BuildID);
+      executeCodeBatch(BuildIDStr, ArrayRef<uint8_t>(First.BuildID), Offsets,
+                       AdjustVMA, ShouldInline, Style, Symbolizer, Printer);
+    } else {
+      executeCodeBatch(First.ModuleName, First.ModuleName, Offsets, AdjustVMA,
+                       ShouldInline, Style, Symbolizer, Printer);
+    }
+    I = J;
+  }
+}
+
 static void printHelp(StringRef ToolName, const SymbolizerOptTable &Tbl,
                       raw_ostream &OS) {
   const char HelpText[] = " [options] addresses...";
@@ -382,6 +487,10 @@ int main(int argc, char **argv) {
   Opts.DWPName = Args.getLastArgValue(OPT_dwp_EQ).str();
   Opts.FallbackDebugPath =
       Args.getLastArgValue(OPT_fallback_debug_path_EQ).str();
+  Opts.IndexCacheDirectory =
+      Args.getLastArgValue(OPT_index_cache_directory_EQ).str();
+  Opts.IndexCachePruningPolicy =
+      Args.getLastArgValue(OPT_index_cache_policy_EQ).str();
   Opts.PrintFunctions = decideHowToPrintFunctions(Args, IsAddr2Line);
   parseIntArg(Args, OPT_print_source_context_lines_EQ,
               Config.SourceContextLines);
@@ -398,6 +507,8 @@ int main(int argc, char **argv) {
   Opts.UseSymbolTable = true;
   if (Args.hasArg(OPT_cache_size_EQ))
     parseIntArg(Args, OPT_cache_size_EQ, Opts.MaxCacheSize);
+  if (Args.hasArg(OPT_die_memory_budget_EQ))
+    parseIntArg(Args, OPT_die_memory_budget_EQ, Opts.DIEMemoryBudget);
   Config.PrintAddress = Args.hasArg(OPT_addresses);
   Config.PrintFunctions = Opts.PrintFunctions != FunctionNameKind::None;
   Config.Pretty = Args.hasArg(OPT_pretty_print);
@@ -449,7 +560,25 @@ int main(int argc, char **argv) {
     Printer = std::make_unique<LLVMPrinter>(outs(), errs(), Config);
 
   std::vector<std::string> InputAddresses = Args.getAllArgValues(OPT_INPUT);
-  if (InputAddresses.empty()) {
+  if (Args.hasArg(OPT_batch)) {
+    bool ReadStdin = InputAddresses.empty();
+    if (ReadStdin) {
+      const int kMaxInputStringLength = 1024;
+      char InputString[kMaxInputStringLength];
+      while (fgets(InputString, sizeof(InputString), stdin)) {
+        std::string StrippedInputString(InputString);
+        llvm::erase_if(StrippedInputString,
+                       [](char c) { return c == '\r' || c == '\n'; });
+        InputAddresses.push_back(std::move(StrippedInputString));
+      }
+    } else {
+      Printer->listBegin();
+    }
+    symbolizeBatch(Args, BuildID, AdjustVMA, IsAddr2Line, Style,
+                   InputAddresses, Symbolizer, *Printer);
+    if (!ReadStdin)
+      Printer->listEnd();
+  } else if (InputAddresses.empty()) {
     const int kMaxInputStringLength = 1024;
     char InputString[kMaxInputStringLength];
 
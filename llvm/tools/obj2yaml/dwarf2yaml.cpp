@@ -230,7 +230,7 @@ void dumpDebugInfo(DWARFContext &DCtx, DWARFYAML::Data &Y) {
     for (auto DIE : CU->dies()) {
       DWARFYAML::Entry NewEntry;
       DataExtractor EntryData = CU->getDebugInfoExtractor();
-      uint64_t offset = DIE.getOffset();
+      uint64_t offset = CU->getDIEOffset(DIE);
 
       assert(EntryData.isValidOffset(offset) && "Invalid DIE Offset");
       if (!EntryData.isValidOffset(offset))
@@ -238,7 +238,7 @@ void dumpDebugInfo(DWARFContext &DCtx, DWARFYAML::Data &Y) {
 
       NewEntry.AbbrCode = EntryData.getULEB128(&offset);
 
-      auto AbbrevDecl = DIE.getAbbreviationDeclarationPtr();
+      auto AbbrevDecl = CU->getDIEAbbreviationDeclaration(DIE);
       if (AbbrevDecl) {
         for (const auto &AttrSpec : AbbrevDecl->attributes()) {
           DWARFYAML::FormValue NewValue;